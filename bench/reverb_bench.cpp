@@ -0,0 +1,554 @@
+// 各 DSP ステージのベンチマーク
+//
+// 引数はすべて (ブロック長, サンプルレート, インスタンス数) の組み合わせ。
+// 1イテレーションで全インスタンスに1ブロックずつ処理させる。
+// samples/s (items_per_second) と ns/sample を報告する。
+//
+// JSON で保存する場合:
+//   reverb_bench --benchmark_out=result.json --benchmark_out_format=json
+// または cmake --build <build> --target reverb_bench_json
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "AllpassDiffuser.h"
+#include "AllpassFilter.h"
+#include "CombFilter.h"
+#include "ConvolutionReverb.h"
+#include "DelayLine.h"
+#include "EffectChain.h"
+#include "FdnReverb.h"
+#include "HybridReverb.h"
+#include "ParallelRenderer.h"
+#include "Reverb.h"
+#include "ReverbPool.h"
+#include "ReverbSendBus.h"
+#include "ReverbTuning.h"
+#include "StaticReverb.h"
+
+namespace {
+
+const std::vector<int64_t> kBlockSizes = {1, 32, 64, 256, 1024};
+const std::vector<int64_t> kSampleRates = {44100, 48000, 96000, 192000};
+const std::vector<int64_t> kInstanceCounts = {1, 16};
+// ReverbPool との比較用の多数インスタンス
+const std::vector<int64_t> kBatchInstanceCounts = {16, 256, 1024};
+
+struct Params {
+  size_t blockSize;
+  float sampleRate;
+  size_t instances;
+};
+
+Params getParams(const benchmark::State& state) {
+  return {static_cast<size_t>(state.range(0)),
+          static_cast<float>(state.range(1)),
+          static_cast<size_t>(state.range(2))};
+}
+
+std::vector<float> makeNoise(size_t numSamples) {
+  std::mt19937 gen(1234);
+  std::uniform_real_distribution<float> distrib(-1.0f, 1.0f);
+  std::vector<float> signal(numSamples);
+  for (float& x : signal) x = distrib(gen);
+  return signal;
+}
+
+// 処理したサンプル数 (ブロック長 x インスタンス数) から
+// samples/s と ns/sample を報告する
+void reportThroughput(benchmark::State& state, const Params& p) {
+  const double samplesPerIteration =
+      static_cast<double>(p.blockSize * p.instances);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(samplesPerIteration));
+  state.counters["ns_per_sample"] = benchmark::Counter(
+      samplesPerIteration * 1e-9,
+      benchmark::Counter::kIsIterationInvariantRate |
+          benchmark::Counter::kInvert);
+}
+
+// 全インスタンスに同じ入力ブロックを流す
+template <typename Stage>
+void runStages(benchmark::State& state, const Params& p,
+               std::vector<Stage>& stages) {
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  for (auto _ : state) {
+    for (auto& stage : stages) {
+      stage.process(input.data(), output.data(), p.blockSize);
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+void BM_DelayLine(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<DelayLine> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(static_cast<int>(p.sampleRate * 0.03f));
+  }
+  runStages(state, p, stages);
+}
+
+// 1サンプルずつの write / read
+void BM_DelayLinePerSample(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<DelayLine> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(static_cast<int>(p.sampleRate * 0.03f));
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  for (auto _ : state) {
+    for (auto& stage : stages) {
+      for (size_t i = 0; i < p.blockSize; ++i) {
+        output[i] = stage.read();
+        stage.write(input[i]);
+      }
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+void BM_CombFilter(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<CombFilter> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(p.sampleRate, 0.0297f, 0.84f, 0.4f);
+  }
+  runStages(state, p, stages);
+}
+
+void BM_AllpassFilter(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<AllpassFilter> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(p.sampleRate, 0.0098f, 0.7f,
+                        static_cast<int>(p.sampleRate * 0.02f));
+  }
+  runStages(state, p, stages);
+}
+
+// stages 段の直列オールパスを、AllpassFilter を並べて1段ずつ呼ぶ
+// (diffuser = 0) か、AllpassDiffuser でまとめて処理する (diffuser = 1)
+void BM_AllpassDiffuser(benchmark::State& state) {
+  const Params p = getParams(state);
+  const auto numStages = static_cast<size_t>(state.range(3));
+  const bool useDiffuser = state.range(4) != 0;
+  const int maxDelaySamples = static_cast<int>(p.sampleRate * 0.02f);
+  std::vector<AllpassDiffuser> diffusers;
+  std::vector<std::vector<AllpassFilter>> chains(p.instances);
+  for (size_t i = 0; i < p.instances; ++i) {
+    diffusers.emplace_back(p.sampleRate, numStages, maxDelaySamples);
+    for (size_t s = 0; s < numStages; ++s) {
+      chains[i].emplace_back(p.sampleRate,
+                             reverb_tuning::kDiffuserDelayTimes[s], 0.7f,
+                             maxDelaySamples);
+    }
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  for (auto _ : state) {
+    for (size_t i = 0; i < p.instances; ++i) {
+      if (useDiffuser) {
+        diffusers[i].process(input.data(), output.data(), p.blockSize);
+      } else {
+        std::copy(input.begin(), input.end(), output.begin());
+        for (AllpassFilter& allpass : chains[i]) {
+          allpass.process(output.data(), output.data(), p.blockSize);
+        }
+      }
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+// 変調した遅延を補間して読むオールパス。
+// interp = 補間方式 (DelayLine::Interpolation の値)
+void BM_AllpassFilterModulated(benchmark::State& state) {
+  const Params p = getParams(state);
+  const auto interpolation =
+      static_cast<DelayLine::Interpolation>(state.range(3));
+  std::vector<AllpassFilter> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(p.sampleRate, 0.0098f, 0.7f,
+                        static_cast<int>(p.sampleRate * 0.02f));
+    stages.back().setModulation(12.0f, 1.07f, interpolation);
+  }
+  runStages(state, p, stages);
+}
+
+void BM_Reverb(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<Reverb> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(p.sampleRate);
+  }
+  runStages(state, p, stages);
+}
+
+// 入力が止まったバス。残響が鳴り終わるまで無音を流してから測るので、
+// コム・オールパスは止まっている (BM_Reverb と比べる)
+void BM_ReverbIdle(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<Reverb> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(p.sampleRate);
+  }
+  const std::vector<float> input(p.blockSize, 0.0f);
+  std::vector<float> output(p.blockSize);
+  const std::vector<float> noise = makeNoise(p.blockSize);
+  for (auto& stage : stages) {
+    stage.process(noise.data(), output.data(), p.blockSize);
+    while (!stage.isSilent()) {
+      stage.process(input.data(), output.data(), p.blockSize);
+    }
+  }
+  for (auto _ : state) {
+    for (auto& stage : stages) {
+      stage.process(input.data(), output.data(), p.blockSize);
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+// Reverb と同じ構成をコンパイル時に固定したもの。BM_Reverb と比べる
+// Sample = 演算の型、Storage = 遅延バッファの型 (StaticReverb.h)
+template <typename Sample = float, typename Storage = Sample>
+void BM_StaticReverb(benchmark::State& state) {
+  using StaticReverbType = StaticSchroederReverb<48000, Sample, Storage>;
+  const Params p = getParams(state);
+  std::vector<std::unique_ptr<StaticReverbType>> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.push_back(std::make_unique<StaticReverbType>(p.sampleRate));
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  for (auto _ : state) {
+    for (auto& stage : stages) {
+      stage->process(input.data(), output.data(), p.blockSize);
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+// lines = 遅延線の本数。BM_Reverb (コム4本 + オールパス2本) と比べる
+void BM_FdnReverb(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<FdnReverb> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(p.sampleRate, static_cast<size_t>(state.range(3)));
+  }
+  runStages(state, p, stages);
+}
+
+// background = 残響をワーカーで計算するか。時間は音声スレッドの CPU 時間
+// なので、background = 1 では初期反射とミックスの分だけになる (BM_Reverb と
+// 比べる)。decay = 1.0 (最も長い残響)
+void BM_HybridReverb(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<std::unique_ptr<HybridReverb>> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.push_back(std::make_unique<HybridReverb>(
+        p.sampleRate, HybridReverb::kDefaultTailBlockSize,
+        state.range(3) != 0));
+    stages.back()->setDecay(1.0f);
+    stages.back()->reset();
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  for (auto _ : state) {
+    for (auto& stage : stages) {
+      stage->process(input.data(), output.data(), p.blockSize);
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+// seconds = IR の長さ (減衰するノイズ)。background = 末尾をワーカーで
+// 計算するか。background = 0 は全ての計算を1スレッドで行うので、
+// 畳み込み全体のコストになる
+void BM_ConvolutionReverb(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<float> ir =
+      makeNoise(static_cast<size_t>(p.sampleRate * state.range(3)));
+  for (size_t i = 0; i < ir.size(); ++i) {
+    ir[i] *= 0.3f * std::exp(-6.9f * static_cast<float>(i) / ir.size());
+  }
+  std::vector<std::unique_ptr<ConvolutionReverb>> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.push_back(std::make_unique<ConvolutionReverb>(
+        p.sampleRate, ir.data(), ir.size(),
+        ConvolutionReverb::kDefaultHeadSize,
+        ConvolutionReverb::kDefaultTailBlockSize, state.range(4) != 0));
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  for (auto _ : state) {
+    for (auto& stage : stages) {
+      stage->process(input.data(), output.data(), p.blockSize);
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+// modulation = 0 (変調なし) と 1 (最大) で、補間の分のコストを比べる
+void BM_ReverbModulated(benchmark::State& state) {
+  const Params p = getParams(state);
+  std::vector<Reverb> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(p.sampleRate);
+    stages.back().setModulation(static_cast<float>(state.range(3)));
+    stages.back().reset();
+  }
+  runStages(state, p, stages);
+}
+
+// 毎ブロック、オートメーションで目標値を変える。
+// automated = 0 (変えない), 1 (decay), 2 (decay と damping)
+void BM_ReverbAutomated(benchmark::State& state) {
+  const Params p = getParams(state);
+  const int64_t automated = state.range(3);
+  std::vector<Reverb> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.emplace_back(p.sampleRate);
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  size_t block = 0;
+  for (auto _ : state) {
+    // ランプが途切れないよう、2つの値を交互に目標にする
+    const float value = (++block % 2 == 0) ? 0.3f : 0.7f;
+    for (auto& stage : stages) {
+      if (automated >= 1) {
+        stage.setDecay(value);
+      }
+      if (automated >= 2) {
+        stage.setDamping(value);
+      }
+      stage.process(input.data(), output.data(), p.blockSize);
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+// 全インスタンスの遅延バッファを1つのアリーナに並べたプール
+void BM_ReverbPool(benchmark::State& state) {
+  const Params p = getParams(state);
+  ReverbPool pool(p.sampleRate, p.instances);
+  for (size_t i = 0; i < p.instances; ++i) {
+    pool.acquire();
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  const std::vector<const float*> inputs(p.instances, input.data());
+  const std::vector<float*> outputs(p.instances, output.data());
+  for (auto _ : state) {
+    pool.processActive(inputs.data(), outputs.data(), p.blockSize);
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+// ワーカースレッド数を変えて、同じインスタンス群を並列に処理する
+void BM_ParallelRenderer(benchmark::State& state) {
+  const Params p = getParams(state);
+  ParallelRenderer renderer(static_cast<size_t>(state.range(3)),
+                            p.sampleRate);
+  ReverbPool pool(p.sampleRate, p.instances);
+  std::vector<Reverb*> instances;
+  for (size_t i = 0; i < p.instances; ++i) {
+    instances.push_back(&pool.get(pool.acquire()));
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize * p.instances);
+  const std::vector<const float*> inputs(p.instances, input.data());
+  std::vector<float*> outputs;
+  for (size_t i = 0; i < p.instances; ++i) {
+    outputs.push_back(output.data() + i * p.blockSize);
+  }
+  for (auto _ : state) {
+    renderer.render(instances.data(), inputs.data(), outputs.data(),
+                    p.instances, p.blockSize);
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+  state.counters["deadline_misses"] = renderer.getStats().deadlineMisses;
+}
+
+// instances 個のソースを1つの共有 Reverb に送る。
+// predelay = 1 なら半分のソースにプリディレイを掛ける。
+// ns/sample はソース1つあたりなので、BM_Reverb (ソースごとの Reverb) と比べる
+void BM_ReverbSendBus(benchmark::State& state) {
+  const Params p = getParams(state);
+  const bool preDelay = state.range(3) != 0;
+  ReverbSendBus bus(p.sampleRate, 1, p.instances, 0.05f);
+  for (size_t i = 0; i < p.instances; ++i) {
+    bus.addSource(0, 0.1f, (preDelay && i % 2 == 1) ? 0.02f : 0.0f);
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  const std::vector<const float*> inputs(p.instances, input.data());
+  float* outputs[] = {output.data()};
+  for (auto _ : state) {
+    bus.process(inputs.data(), outputs, p.blockSize);
+    benchmark::DoNotOptimize(output.data());
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+// コム -> オールパス x 2 を、具象型のまま直接呼ぶ (graph = 0) か
+// EffectChain のノードとしてブロックごとの仮想呼び出しで呼ぶ (graph = 1)
+struct SerialStages {
+  SerialStages(float sampleRate, bool useChain)
+      : comb(sampleRate, 0.0297f, 0.84f, 0.4f),
+        allpass1(sampleRate, 0.0098f, 0.7f,
+                 static_cast<int>(sampleRate * 0.02f)),
+        allpass2(sampleRate, 0.0031f, 0.7f,
+                 static_cast<int>(sampleRate * 0.02f)),
+        useChain(useChain) {}
+
+  void process(const float* input, float* output, size_t numSamples) {
+    if (useChain) {
+      chain.process(input, output, numSamples);
+      return;
+    }
+    comb.process(input, output, numSamples);
+    allpass1.process(output, output, numSamples);
+    allpass2.process(output, output, numSamples);
+  }
+
+  CombFilter comb;
+  AllpassFilter allpass1;
+  AllpassFilter allpass2;
+  EffectChain chain;
+  bool useChain;
+};
+
+void BM_EffectChain(benchmark::State& state) {
+  const Params p = getParams(state);
+  const bool useChain = state.range(3) != 0;
+  std::vector<std::unique_ptr<SerialStages>> stages;
+  for (size_t i = 0; i < p.instances; ++i) {
+    stages.push_back(std::make_unique<SerialStages>(p.sampleRate, useChain));
+    SerialStages& s = *stages.back();
+    s.chain.add(s.comb);
+    s.chain.add(s.allpass1);
+    s.chain.add(s.allpass2);
+  }
+  const std::vector<float> input = makeNoise(p.blockSize);
+  std::vector<float> output(p.blockSize);
+  for (auto _ : state) {
+    for (auto& s : stages) {
+      s->process(input.data(), output.data(), p.blockSize);
+      benchmark::DoNotOptimize(output.data());
+    }
+    benchmark::ClobberMemory();
+  }
+  reportThroughput(state, p);
+}
+
+void applyArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"block", "sr", "instances"})
+      ->ArgsProduct({kBlockSizes, kSampleRates, kInstanceCounts});
+}
+
+// 個別に確保した Reverb とプールを同じ条件で比べる
+void applyBatchArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"block", "sr", "instances"})
+      ->ArgsProduct({{64, 256}, {48000}, kBatchInstanceCounts});
+}
+
+}  // namespace
+
+BENCHMARK(BM_DelayLine)->Apply(applyArgs);
+BENCHMARK(BM_DelayLinePerSample)->Apply(applyArgs);
+BENCHMARK(BM_CombFilter)->Apply(applyArgs);
+BENCHMARK(BM_AllpassFilter)->Apply(applyArgs);
+BENCHMARK(BM_AllpassFilterModulated)
+    ->ArgNames({"block", "sr", "instances", "interp"})
+    ->ArgsProduct({{64, 256}, {48000}, {1, 16}, {0, 1, 2}});
+BENCHMARK(BM_AllpassDiffuser)
+    ->ArgNames({"block", "sr", "instances", "stages", "diffuser"})
+    ->ArgsProduct({{64, 256}, {48000}, {1, 16}, {2, 4, 8}, {0, 1}});
+BENCHMARK(BM_Reverb)->Apply(applyArgs)->Apply(applyBatchArgs);
+BENCHMARK(BM_ReverbIdle)
+    ->ArgNames({"block", "sr", "instances"})
+    ->ArgsProduct({{64, 256}, {48000}, {1, 16, 1024}});
+// StaticSchroederReverb<48000> は 48kHz まで
+BENCHMARK(BM_StaticReverb<>)
+    ->Name("BM_StaticReverb")
+    ->ArgNames({"block", "sr", "instances"})
+    ->ArgsProduct({kBlockSizes, {44100, 48000}, kInstanceCounts});
+// 遅延バッファの型ごとの比較。インスタンスが多いと Q15 (メモリ半分) の
+// キャッシュの効果が出る
+BENCHMARK_TEMPLATE(BM_StaticReverb, float, int16_t)
+    ->ArgNames({"block", "sr", "instances"})
+    ->ArgsProduct({{256}, {48000}, {1, 16, 256}});
+BENCHMARK_TEMPLATE(BM_StaticReverb, float, float)
+    ->ArgNames({"block", "sr", "instances"})
+    ->ArgsProduct({{256}, {48000}, {1, 16, 256}});
+BENCHMARK_TEMPLATE(BM_StaticReverb, double, float)
+    ->ArgNames({"block", "sr", "instances"})
+    ->ArgsProduct({{256}, {48000}, {1, 16, 256}});
+BENCHMARK_TEMPLATE(BM_StaticReverb, double, int32_t)
+    ->ArgNames({"block", "sr", "instances"})
+    ->ArgsProduct({{256}, {48000}, {1, 16, 256}});
+BENCHMARK(BM_FdnReverb)
+    ->ArgNames({"block", "sr", "instances", "lines"})
+    ->ArgsProduct({{64, 256}, {48000}, {1, 16}, {8, 16}});
+BENCHMARK(BM_ConvolutionReverb)
+    ->ArgNames({"block", "sr", "instances", "seconds", "background"})
+    ->ArgsProduct({{64, 256}, {48000}, {1}, {1, 3}, {0, 1}})
+    ->UseRealTime();
+BENCHMARK(BM_HybridReverb)
+    ->ArgNames({"block", "sr", "instances", "background"})
+    ->ArgsProduct({{64, 256}, {48000}, {1}, {0, 1}});
+BENCHMARK(BM_ReverbModulated)
+    ->ArgNames({"block", "sr", "instances", "modulation"})
+    ->ArgsProduct({{64, 256}, {48000}, {1, 16}, {0, 1}});
+BENCHMARK(BM_ReverbAutomated)
+    ->ArgNames({"block", "sr", "instances", "automated"})
+    ->ArgsProduct({{64, 256}, {48000}, {16, 256}, {0, 1, 2}});
+BENCHMARK(BM_ReverbPool)->Apply(applyBatchArgs);
+BENCHMARK(BM_ParallelRenderer)
+    ->ArgNames({"block", "sr", "instances", "threads"})
+    ->ArgsProduct({{64, 256}, {48000}, {256, 1024}, {1, 2, 4, 8}})
+    ->UseRealTime();
+
+BENCHMARK(BM_ReverbSendBus)
+    ->ArgNames({"block", "sr", "instances", "predelay"})
+    ->ArgsProduct({{256}, {48000}, {10, 100, 1000}, {0, 1}});
+// BM_ReverbSendBus と同じソース数で、ソースごとに Reverb を持つ場合
+BENCHMARK(BM_Reverb)
+    ->ArgNames({"block", "sr", "instances"})
+    ->ArgsProduct({{256}, {48000}, {10, 100, 1000}});
+BENCHMARK(BM_EffectChain)
+    ->ArgNames({"block", "sr", "instances", "graph"})
+    ->ArgsProduct({{1, 32, 256}, {48000}, {1, 16}, {0, 1}});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,118 @@
+#include "AllpassDiffuser.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "DenormalGuard.h"
+#include "ReverbTuning.h"
+
+static_assert(AllpassDiffuser::kMaxStages <=
+                  reverb_tuning::kMaxDiffuserStages,
+              "既定の遅延時間が足りない");
+
+namespace {
+// 最大遅延 + 書き込み1サンプル分が収まる2のべき乗のサンプル数
+uint32_t bufferLength(int maxDelaySamples) {
+  uint32_t length = 1;
+  while (length < static_cast<uint32_t>(std::max(maxDelaySamples, 1)) + 1) {
+    length <<= 1;
+  }
+  return length;
+}
+}  // namespace
+
+AllpassDiffuser::AllpassDiffuser(float sampleRate, size_t maxStages,
+                                 int maxDelaySamples, FloatArena* arena)
+    : sampleRate_(sampleRate),
+      maxDelaySamples_(std::max(maxDelaySamples, 1)),
+      stages_(std::clamp<size_t>(maxStages, 1, kMaxStages)),
+      numStages_(stages_.size()),
+      mask_(bufferLength(maxDelaySamples_) - 1),
+      writeIndex_(0) {
+  const size_t stride = FloatArena::alignedSize(mask_ + 1);
+  float* buffer = arena ? arena->allocate(stride * stages_.size()) : nullptr;
+  if (buffer == nullptr) {
+    storage_.assign(stride * stages_.size(), 0.0f);
+    buffer = storage_.data();
+  }
+  for (size_t s = 0; s < stages_.size(); ++s) {
+    stages_[s].buffer = buffer + s * stride;
+    setDelayTime(s, reverb_tuning::kDiffuserDelayTimes[s]);
+    setGain(s, reverb_tuning::kAllpassGain);
+  }
+  reset();
+}
+
+size_t AllpassDiffuser::requiredSize(size_t maxStages, int maxDelaySamples) {
+  return std::clamp<size_t>(maxStages, 1, kMaxStages) *
+         FloatArena::alignedSize(bufferLength(std::max(maxDelaySamples, 1)));
+}
+
+void AllpassDiffuser::process(const float* input, float* output,
+                              size_t numSamples) {
+  const DenormalGuard denormalGuard;
+  // 全ての段を output の上で in-place に処理する
+  if (input != output) {
+    std::copy_n(input, numSamples, output);
+  }
+  for (size_t s = 0; s < numStages_; ++s) {
+    processStage(stages_[s], output, numSamples);
+  }
+  writeIndex_ += static_cast<uint32_t>(numSamples);
+}
+
+void AllpassDiffuser::processStage(const Stage& stage, float* data,
+                                   size_t numSamples) const {
+  const size_t length = mask_ + 1;
+  const float g = stage.gain;
+  uint32_t w = writeIndex_;
+  while (numSamples > 0) {
+    // 読む区間 [w - D, w - D + n) と書く区間 [w, w + n) がどちらも
+    // 折り返さず、n <= D で重ならない長さ
+    const size_t readPos = (w - stage.delay) & mask_;
+    const size_t writePos = w & mask_;
+    const size_t n = std::min({numSamples, static_cast<size_t>(stage.delay),
+                               length - readPos, length - writePos});
+    const float* delayed = stage.buffer + readPos;
+    float* v = stage.buffer + writePos;
+    for (size_t i = 0; i < n; ++i) {
+      const float x = data[i];
+      const float d = delayed[i];
+      v[i] = x + g * d;
+      data[i] = -g * x + d;
+    }
+    data += n;
+    numSamples -= n;
+    w += static_cast<uint32_t>(n);
+  }
+}
+
+void AllpassDiffuser::reset() {
+  for (const Stage& stage : stages_) {
+    std::fill_n(stage.buffer, mask_ + 1, 0.0f);
+  }
+  writeIndex_ = 0;
+}
+
+void AllpassDiffuser::setNumStages(size_t numStages) {
+  numStages = std::min(numStages, stages_.size());
+  for (size_t s = numStages_; s < numStages; ++s) {
+    std::fill_n(stages_[s].buffer, mask_ + 1, 0.0f);
+  }
+  numStages_ = numStages;
+}
+
+void AllpassDiffuser::setDelaySamples(size_t stage, int delaySamples) {
+  stages_[stage].delay =
+      static_cast<uint32_t>(std::clamp(delaySamples, 1, maxDelaySamples_));
+}
+
+void AllpassDiffuser::setDelayTime(size_t stage, float delayTime) {
+  // AllpassFilter と同じく最も近いサンプル数に丸める
+  setDelaySamples(stage,
+                  static_cast<int>(std::round(sampleRate_ * delayTime)));
+}
+
+void AllpassDiffuser::setGain(size_t stage, float gain) {
+  stages_[stage].gain = std::clamp(gain, -0.99f, 0.99f);
+}
@@ -0,0 +1,81 @@
+#ifndef ALLPASSDIFFUSER_H
+#define ALLPASSDIFFUSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AudioEffect.h"
+#include "FloatArena.h"
+
+// 直列のオールパス (拡散器) をブロック単位でまとめて処理する段
+//
+// 各段は AllpassFilter と同じ Schroeder オールパス:
+//   v[n] = x[n] + g * v[n - D]
+//   y[n] = -g * x[n] + v[n - D]
+// ブロックの長さが D 以下なら、v[n - D] は全て前のブロックまでに書いた値
+// なので、ブロック内のサンプルは互いに独立になる。そこで1段ずつブロック
+// 全体を通し、遅延バッファの連続した区間を直接読み書きする (内側のループは
+// ベクトル化される)。ブロックが D より長いときや、バッファの端で折り返す
+// ときは、その境目で区切る。AllpassFilter を並べる場合と違い、
+// DelayLine との間のコピーと、64 サンプルごとの区切りがない。
+//
+// 段の数・遅延・ゲインは実行時に変えられる。遅延バッファは maxStages 段分、
+// maxDelaySamples までをコンストラクタで確保するので、set 系のメソッドと
+// process はメモリ確保をしない。遅延の変調はしない (Reverb の変調する
+// オールパスは AllpassFilter のまま)。
+class AllpassDiffuser final : public AudioEffect {
+ public:
+  static constexpr size_t kMaxStages = 8;
+
+  // maxStages 段 (kMaxStages まで) を kDiffuserDelayTimes の遅延と
+  // kAllpassGain で用意する。arena を渡すと遅延バッファをそこから切り出す
+  AllpassDiffuser(float sampleRate, size_t maxStages, int maxDelaySamples,
+                  FloatArena* arena = nullptr);
+
+  AllpassDiffuser(const AllpassDiffuser&) = delete;
+  AllpassDiffuser& operator=(const AllpassDiffuser&) = delete;
+  AllpassDiffuser(AllpassDiffuser&&) = default;
+  AllpassDiffuser& operator=(AllpassDiffuser&&) = default;
+
+  // この構成で確保する遅延バッファの float 数
+  static size_t requiredSize(size_t maxStages, int maxDelaySamples);
+
+  // input と output は同じバッファでもよい
+  void process(const float* input, float* output,
+               size_t numSamples) override;
+  void reset() override;
+
+  // 先頭から numStages 段 ([0, maxStages]) を使う。
+  // 新たに使い始める段は無音から始める
+  void setNumStages(size_t numStages);
+  // 遅延は [1, maxDelaySamples] に、ゲインは [-0.99, 0.99] に丸める
+  void setDelaySamples(size_t stage, int delaySamples);
+  void setDelayTime(size_t stage, float delayTime);
+  void setGain(size_t stage, float gain);
+
+  size_t getNumStages() const { return numStages_; }
+  size_t getMaxStages() const { return stages_.size(); }
+  int getDelaySamples(size_t stage) const { return stages_[stage].delay; }
+  float getGain(size_t stage) const { return stages_[stage].gain; }
+
+ private:
+  struct Stage {
+    float* buffer;  // 長さ mask_ + 1 の循環バッファ (v[n] を書く)
+    uint32_t delay;
+    float gain;
+  };
+
+  // 1段分を data の上で in-place に処理する
+  void processStage(const Stage& stage, float* data, size_t numSamples) const;
+
+  float sampleRate_;
+  int maxDelaySamples_;
+  std::vector<float> storage_;  // アリーナを使わない場合のバッファ
+  std::vector<Stage> stages_;
+  size_t numStages_;
+  uint32_t mask_;        // 段ごとのバッファ長 - 1 (バッファ長は2のべき乗)
+  uint32_t writeIndex_;  // 全ての段で共通の書き込み位置
+};
+
+#endif  // ALLPASSDIFFUSER_H
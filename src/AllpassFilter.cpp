@@ -3,10 +3,14 @@
 #include <algorithm>  // std::max, std::min
 #include <cmath>      // std::round
 
+#include "DenormalGuard.h"
+
 // コンストラクタ例
 AllpassFilter::AllpassFilter(float initialSampleRate, float initialDelayTime,
-                             float initialGain, int maxDelaySamplesForDelayLine)
-    : delayLine_(maxDelaySamplesForDelayLine),
+                             float initialGain, int maxDelaySamplesForDelayLine,
+                             FloatArena* arena)
+    : delayLine_(maxDelaySamplesForDelayLine, maxDelaySamplesForDelayLine + 1,
+                 arena),
       currentSampleRate_(initialSampleRate),
       delayTime_(0.0f),
       gain_(0.0f) {
@@ -15,24 +19,106 @@ AllpassFilter::AllpassFilter(float initialSampleRate, float initialDelayTime,
 }
 
 float AllpassFilter::process(float inputXn) {
-  float d_out_n = delayLine_.read();
+  float yn;
+  process(&inputXn, &yn, 1);
+  return yn;
+}
 
-  float yn = -gain_ * inputXn + d_out_n;
+void AllpassFilter::process(const float* input, float* output,
+                            size_t numSamples) {
+  const DenormalGuard denormalGuard;
+  if (modDepth_ > 0.0f) {
+    processModulated(input, output, numSamples);
+    return;
+  }
+  // CombFilter と同様、遅延長以下のチャンクに分割して処理する
+  const size_t delaySamples =
+      static_cast<size_t>(std::max(delayLine_.getDelaySamples(), 1));
+  const size_t maxChunk = std::min(kChunkSize, delaySamples);
+  float d_out[kChunkSize];
+  float d_in[kChunkSize];
 
-  float d_in_n = inputXn + gain_ * d_out_n;
-  // (オプション) ディレイラインへの書き込み値をクリップ (発振防止のため)
-  // d_in_n = std::max(-1.0f, std::min(1.0f, d_in_n));
-  delayLine_.write(d_in_n);
+  while (numSamples > 0) {
+    const size_t n = std::min(numSamples, maxChunk);
+    delayLine_.read(d_out, n);
 
-  return yn;
+    for (size_t i = 0; i < n; ++i) {
+      const float xn = input[i];
+      d_in[i] = xn + gain_ * d_out[i];
+      // (オプション) ディレイラインへの書き込み値をクリップ (発振防止のため)
+      // d_in[i] = std::max(-1.0f, std::min(1.0f, d_in[i]));
+      output[i] = -gain_ * xn + d_out[i];
+    }
+
+    delayLine_.write(d_in, n);
+    input += n;
+    output += n;
+    numSamples -= n;
+  }
+}
+
+void AllpassFilter::processModulated(const float* input, float* output,
+                                     size_t numSamples) {
+  // 丸めない中心の遅延。ブロック内でまだ書いていない位置を読まないよう、
+  // チャンクは最短の遅延より短くする
+  const float center = currentSampleRate_ * delayTime_;
+  const float minDelay = std::max(center - modDepth_, 2.0f);
+  const size_t maxChunk =
+      std::min(kChunkSize, static_cast<size_t>(minDelay) - 1);
+  float d_out[kChunkSize];
+  float d_in[kChunkSize];
+
+  while (numSamples > 0) {
+    // LFO のセグメントの境目でも区切る
+    const size_t n =
+        std::min({numSamples, maxChunk, lfo_.samplesUntilSegmentEnd()});
+    // セグメント内では LFO は直線なので、遅延も直線になる
+    delayLine_.readInterpolated(
+        center + modDepth_ * lfo_.getSegmentStart(),
+        modDepth_ * lfo_.getSegmentSlope(), d_out, n, interpolation_,
+        lfo_.getPosition());
+    lfo_.advance(n);
+
+    for (size_t i = 0; i < n; ++i) {
+      const float xn = input[i];
+      d_in[i] = xn + gain_ * d_out[i];
+      output[i] = -gain_ * xn + d_out[i];
+    }
+
+    delayLine_.write(d_in, n);
+    input += n;
+    output += n;
+    numSamples -= n;
+  }
+}
+
+size_t AllpassFilter::requiredSize(int maxDelaySamplesForDelayLine) {
+  return DelayLine::requiredSize(maxDelaySamplesForDelayLine,
+                                 maxDelaySamplesForDelayLine + 1);
 }
 
-void AllpassFilter::reset() { delayLine_.clear(); }
+void AllpassFilter::reset() {
+  delayLine_.clear();
+  lfo_.reset();
+}
+
+void AllpassFilter::setModulation(float depthSamples, float rateHz,
+                                  DelayLine::Interpolation interpolation) {
+  setModulationDepth(depthSamples);
+  setModulationRate(rateHz);
+  interpolation_ = interpolation;
+}
+
+void AllpassFilter::setModulationRate(float rateHz) {
+  modRate_ = rateHz;
+  lfo_.setFrequency(modRate_ / currentSampleRate_);
+}
 
 void AllpassFilter::updateParameters(float newSampleRate, float newDelayTime,
                                      float newGain) {
   currentSampleRate_ = newSampleRate;
   delayTime_ = newDelayTime;
+  lfo_.setFrequency(modRate_ / currentSampleRate_);
 
   int delaySamples =
       static_cast<int>(std::round(currentSampleRate_ * delayTime_));
@@ -1,25 +1,61 @@
 #ifndef ALLPASSFILTER_H
 #define ALLPASSFILTER_H
 
+#include <algorithm>
+#include <cstddef>
+
+#include "AudioEffect.h"
 #include "DelayLine.h"  // 作成済みのDelayLine
+#include "Lfo.h"
 
-class AllpassFilter {
+class AllpassFilter final : public AudioEffect {
  public:
   // コンストラクタ (例: 最大遅延長も指定する方が柔軟かも)
+  // arena を渡すと遅延バッファをそこから切り出す
   AllpassFilter(float initialSampleRate, float initialDelayTime,
-                float initialGain, int maxDelaySamplesForDelayLine);
+                float initialGain, int maxDelaySamplesForDelayLine,
+                FloatArena* arena = nullptr);
   // または、CombFilterと同様のインターフェースで
   // AllpassFilter(float sampleRate, float delayTime, float gain);
 
   float process(float sample);
-  void reset();
+  // ブロック処理。input と output は同じバッファでもよい
+  void process(const float* input, float* output,
+               size_t numSamples) override;
+  void reset() override;
   void updateParameters(float newSampleRate, float newDelayTime, float newGain);
 
+  // 遅延を LFO (rateHz の正弦波) で ±depthSamples だけ揺らす。
+  // 変調中は遅延を丸めず、小数の遅延を interpolation で補間して読む。
+  // depthSamples が 0 なら変調しない (整数遅延の処理に戻る)
+  void setModulation(float depthSamples, float rateHz,
+                     DelayLine::Interpolation interpolation =
+                         DelayLine::Interpolation::Linear);
+  // LFO の周波数だけ・揺れ幅だけを変える (補間方法はそのまま)
+  void setModulationRate(float rateHz);
+  void setModulationDepth(float depthSamples) {
+    modDepth_ = std::max(0.0f, depthSamples);
+  }
+
+  // アリーナから切り出す遅延バッファの float 数
+  static size_t requiredSize(int maxDelaySamplesForDelayLine);
+
  private:
+  // 一度に DelayLine から読み出す最大サンプル数 (スタック上の作業領域)
+  static constexpr size_t kChunkSize = 64;
+
+  void processModulated(const float* input, float* output, size_t numSamples);
+
   DelayLine delayLine_;
   float currentSampleRate_;
   float delayTime_;
   float gain_;  // Schroeder Allpass の 'g'
+
+  // 変調
+  Lfo lfo_;
+  float modDepth_ = 0.0f;  // 揺れ幅 (サンプル)。0 なら変調しない
+  float modRate_ = 0.0f;   // Hz
+  DelayLine::Interpolation interpolation_ = DelayLine::Interpolation::Linear;
 };
 
 #endif  // ALLPASSFILTER_H
\ No newline at end of file
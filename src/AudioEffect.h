@@ -1,9 +1,18 @@
 #pragma once
+#include <cstddef>
 
+// エフェクトグラフ (EffectChain.h) のノードの共通インターフェース
+//
+// 仮想呼び出しはブロックに1回だけなので、間接呼び出しのコストはブロック長で
+// 薄まる。サンプル単位の process(float) は具象クラスにだけ置く。
+// 具象クラスは final にし、具象型から呼んだときは仮想呼び出しにならない
+// (Reverb の中のオールパスなど) ようにする。
 class AudioEffect {
  public:
-  ~AudioEffect() = default;
-  virtual float process(float sample);
-  virtual void reset();
-  virtual void setSampleRate(float newSampleRate);
-};
\ No newline at end of file
+  virtual ~AudioEffect() = default;
+
+  // ブロック処理。input と output は同じバッファでもよい
+  virtual void process(const float* input, float* output,
+                       size_t numSamples) = 0;
+  virtual void reset() = 0;
+};
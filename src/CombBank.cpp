@@ -0,0 +1,653 @@
+#include "CombBank.h"
+
+#include <algorithm>
+
+#include "DenormalGuard.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define COMBBANK_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define COMBBANK_NEON 1
+#include <arm_neon.h>
+#endif
+
+// AVX2 カーネルは target 属性付きでコンパイルできる場合だけ用意する
+#if defined(COMBBANK_X86) && (defined(__GNUC__) || defined(__clang__))
+#define COMBBANK_AVX2 1
+#endif
+
+namespace {
+// 1チャンネルあたりのレーン数 (4の倍数)
+size_t laneStride(size_t numCombs) {
+  return (std::clamp<size_t>(numCombs, 1, CombBank::kMaxCombs) + 3) / 4 * 4;
+}
+
+size_t clampChannels(size_t numChannels, size_t stride) {
+  return std::clamp<size_t>(numChannels, 1, CombBank::kMaxLanes / stride);
+}
+
+// 最大遅延 + 書き込み1フレーム分が収まる2のべき乗のフレーム数
+uint32_t frameCount(int maxDelaySamples) {
+  uint32_t frames = 1;
+  while (frames < static_cast<uint32_t>(std::max(maxDelaySamples, 1)) + 1) {
+    frames <<= 1;
+  }
+  return frames;
+}
+}  // namespace
+
+CombBank::CombBank(size_t numCombs, int maxDelaySamples, size_t numChannels,
+                   FloatArena* arena)
+    : numCombs_(std::clamp<size_t>(numCombs, 1, kMaxCombs)),
+      numChannels_(1),
+      stride_(laneStride(numCombs)),
+      lanes_(0),
+      buffer_(nullptr),
+      mask_(0),
+      writeIndex_(0),
+      modulated_(false),
+      isa_(Isa::Scalar),
+      kernel_(&CombBank::processScalar<false>) {
+  numChannels_ = clampChannels(numChannels, stride_);
+  lanes_ = stride_ * numChannels_;
+
+  const uint32_t frames = frameCount(maxDelaySamples);
+  mask_ = frames - 1;
+  const size_t size = requiredSize(numCombs, maxDelaySamples, numChannels);
+  if (arena != nullptr) {
+    buffer_ = arena->allocate(size);
+  }
+  if (buffer_ == nullptr) {
+    storage_.assign(size, 0.0f);
+    buffer_ = storage_.data();
+  }
+
+  for (size_t k = 0; k < kMaxLanes; ++k) {
+    gain_[k] = 0.0f;
+    damping_[k] = 0.0f;
+    store_[k] = 0.0f;
+    weight_[k] = (k < lanes_ && k % stride_ < numCombs_) ? 1.0f : 0.0f;
+    delay_[k] = 1;
+    modDepth_[k] = 0.0f;
+    modBase_[k] = 0.0f;
+    modSlope_[k] = 0.0f;
+    modDelay_[k] = 1;
+    lfo_[k].reset();
+  }
+  setIsa(detectIsa(lanes_));
+}
+
+size_t CombBank::requiredSize(size_t numCombs, int maxDelaySamples,
+                              size_t numChannels) {
+  const size_t stride = laneStride(numCombs);
+  return static_cast<size_t>(frameCount(maxDelaySamples)) * stride *
+         clampChannels(numChannels, stride);
+}
+
+void CombBank::process(const float* input, float* output, size_t numSamples) {
+  process(&input, 1, &output, 1, numSamples);
+}
+
+void CombBank::process(const float* const* inputs, size_t inputStride,
+                       float* const* outputs, size_t outputStride,
+                       size_t numSamples) {
+  const DenormalGuard denormalGuard;
+  // カーネルはチャンネルごとの総和を acc に書く。
+  // 出力はチャンク全体の処理後に書くので、入出力が同じでもよい
+  alignas(16) Accumulator acc[kMaxChannels];
+  const float* in[kMaxChannels];
+  size_t offset = 0;
+  while (offset < numSamples) {
+    size_t n = std::min(kChunkSize, numSamples - offset);
+    if (modulated_) {
+      // LFO のセグメントの境目で区切り、セグメントごとの係数を求める
+      n = std::min(n, lfo_[0].samplesUntilSegmentEnd());
+      const size_t position = lfo_[0].getPosition();
+      for (size_t k = 0; k < lanes_; ++k) {
+        modBase_[k] = static_cast<float>(delay_[k]) +
+                      modDepth_[k] * lfo_[k].getSegmentStart();
+        modSlope_[k] = modDepth_[k] * lfo_[k].getSegmentSlope();
+        modDelay_[k] = static_cast<int32_t>(modulatedDelay(k, position));
+      }
+      // さらに、どのレーンでも遅延の整数部が変わらない長さに縮める。
+      // 遅延はチャンク内で単調なので、最後のサンプルだけ調べればよい
+      if (!integerDelaysHeld(position + n - 1)) {
+        size_t held = 1;  // 最初のサンプルは必ず同じ
+        size_t changed = n;
+        while (changed - held > 1) {
+          const size_t middle = (held + changed) / 2;
+          if (integerDelaysHeld(position + middle - 1)) {
+            held = middle;
+          } else {
+            changed = middle;
+          }
+        }
+        n = held;
+      }
+    }
+    for (size_t ch = 0; ch < numChannels_; ++ch) {
+      in[ch] = inputs[ch] + offset * inputStride;
+    }
+
+    (this->*kernel_)(in, inputStride, acc, n);
+
+    if (modulated_) {
+      for (size_t k = 0; k < lanes_; ++k) {
+        lfo_[k].advance(n);
+      }
+    }
+
+    for (size_t ch = 0; ch < numChannels_; ++ch) {
+      float* out = outputs[ch] + offset * outputStride;
+      for (size_t i = 0; i < n; ++i) {
+        out[i * outputStride] = acc[ch][i];
+      }
+    }
+    writeIndex_ += static_cast<uint32_t>(n);
+    offset += n;
+  }
+  // 入力が止まった後も非正規化数がフィードバックに残らないようにする
+  for (size_t k = 0; k < lanes_; ++k) {
+    store_[k] = DenormalGuard::flushState(store_[k]);
+  }
+}
+
+float CombBank::modulatedDelay(size_t lane, size_t position) const {
+  const float d =
+      modBase_[lane] + modSlope_[lane] * static_cast<float>(position);
+  return std::min(std::max(d, 1.0f), static_cast<float>(mask_));
+}
+
+bool CombBank::integerDelaysHeld(size_t position) const {
+  for (size_t k = 0; k < lanes_; ++k) {
+    if (static_cast<int32_t>(modulatedDelay(k, position)) != modDelay_[k]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void CombBank::reset() {
+  const size_t size = (static_cast<size_t>(mask_) + 1) * lanes_;
+  std::fill(buffer_, buffer_ + size, 0.0f);
+  std::fill(store_, store_ + kMaxLanes, 0.0f);
+  for (Lfo& lfo : lfo_) {
+    lfo.reset();
+  }
+  writeIndex_ = 0;
+}
+
+void CombBank::setDelaySamples(size_t comb, int delaySamples,
+                               size_t channel) {
+  if (comb >= numCombs_ || channel >= numChannels_) {
+    return;
+  }
+  delay_[lane(comb, channel)] =
+      std::clamp(delaySamples, 1, static_cast<int>(mask_));
+}
+
+void CombBank::setGain(size_t comb, float gain, size_t channel) {
+  if (comb < numCombs_ && channel < numChannels_) {
+    gain_[lane(comb, channel)] = gain;
+  }
+}
+
+void CombBank::setDamping(size_t comb, float damping, size_t channel) {
+  if (comb < numCombs_ && channel < numChannels_) {
+    damping_[lane(comb, channel)] = damping;
+  }
+}
+
+void CombBank::setModulation(size_t comb, float depthSamples,
+                             float cyclesPerSample, size_t channel) {
+  if (comb >= numCombs_ || channel >= numChannels_) {
+    return;
+  }
+  setModulationRate(comb, cyclesPerSample, channel);
+  setModulationDepth(comb, depthSamples, channel);
+}
+
+void CombBank::setModulationRate(size_t comb, float cyclesPerSample,
+                                 size_t channel) {
+  if (comb < numCombs_ && channel < numChannels_) {
+    lfo_[lane(comb, channel)].setFrequency(cyclesPerSample);
+  }
+}
+
+void CombBank::setModulationDepth(size_t comb, float depthSamples,
+                                  size_t channel) {
+  if (comb >= numCombs_ || channel >= numChannels_) {
+    return;
+  }
+  modDepth_[lane(comb, channel)] = std::max(0.0f, depthSamples);
+  // 全レーンの depth が 0 なら、補間しない元のカーネルに戻す
+  const bool modulated = std::any_of(modDepth_, modDepth_ + lanes_,
+                                     [](float depth) { return depth > 0.0f; });
+  if (modulated != modulated_) {
+    modulated_ = modulated;
+    selectKernel();
+  }
+}
+
+bool CombBank::setIsa(Isa isa) {
+  if (!isSupported(isa, lanes_)) {
+    return false;
+  }
+  isa_ = isa;
+  selectKernel();
+  return true;
+}
+
+void CombBank::selectKernel() {
+  const size_t groups = lanes_ / 4;
+  const size_t modulated = modulated_ ? 1 : 0;
+  switch (isa_) {
+#if defined(COMBBANK_X86)
+    case Isa::SSE2: {
+      static constexpr Kernel kernels[2][8] = {
+          {&CombBank::processSse2<1, false>, &CombBank::processSse2<2, false>,
+           &CombBank::processSse2<3, false>, &CombBank::processSse2<4, false>,
+           &CombBank::processSse2<5, false>, &CombBank::processSse2<6, false>,
+           &CombBank::processSse2<7, false>, &CombBank::processSse2<8, false>},
+          {&CombBank::processSse2<1, true>, &CombBank::processSse2<2, true>,
+           &CombBank::processSse2<3, true>, &CombBank::processSse2<4, true>,
+           &CombBank::processSse2<5, true>, &CombBank::processSse2<6, true>,
+           &CombBank::processSse2<7, true>, &CombBank::processSse2<8, true>}};
+      kernel_ = kernels[modulated][groups - 1];
+      break;
+    }
+#endif
+#if defined(COMBBANK_AVX2)
+    case Isa::AVX2: {
+      static constexpr Kernel kernels[2][4] = {
+          {&CombBank::processAvx2<1, false>, &CombBank::processAvx2<2, false>,
+           &CombBank::processAvx2<3, false>, &CombBank::processAvx2<4, false>},
+          {&CombBank::processAvx2<1, true>, &CombBank::processAvx2<2, true>,
+           &CombBank::processAvx2<3, true>, &CombBank::processAvx2<4, true>}};
+      kernel_ = kernels[modulated][groups / 2 - 1];
+      break;
+    }
+#endif
+#if defined(COMBBANK_NEON)
+    case Isa::NEON: {
+      static constexpr Kernel kernels[2][8] = {
+          {&CombBank::processNeon<1, false>, &CombBank::processNeon<2, false>,
+           &CombBank::processNeon<3, false>, &CombBank::processNeon<4, false>,
+           &CombBank::processNeon<5, false>, &CombBank::processNeon<6, false>,
+           &CombBank::processNeon<7, false>, &CombBank::processNeon<8, false>},
+          {&CombBank::processNeon<1, true>, &CombBank::processNeon<2, true>,
+           &CombBank::processNeon<3, true>, &CombBank::processNeon<4, true>,
+           &CombBank::processNeon<5, true>, &CombBank::processNeon<6, true>,
+           &CombBank::processNeon<7, true>, &CombBank::processNeon<8, true>}};
+      kernel_ = kernels[modulated][groups - 1];
+      break;
+    }
+#endif
+    default:
+      kernel_ = modulated_ ? &CombBank::processScalar<true>
+                           : &CombBank::processScalar<false>;
+      break;
+  }
+}
+
+bool CombBank::isSupported(Isa isa, size_t lanes) {
+  switch (isa) {
+    case Isa::Scalar:
+      return true;
+    case Isa::SSE2:
+#if defined(COMBBANK_X86)
+      return true;
+#else
+      return false;
+#endif
+    case Isa::AVX2:
+#if defined(COMBBANK_AVX2)
+      // 8レーン単位で処理するので、レーン数が8の倍数のときだけ使う
+      return lanes % 8 == 0 && __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    case Isa::NEON:
+#if defined(COMBBANK_NEON)
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+CombBank::Isa CombBank::detectIsa(size_t lanes) {
+  for (Isa isa : {Isa::AVX2, Isa::SSE2, Isa::NEON}) {
+    if (isSupported(isa, lanes)) {
+      return isa;
+    }
+  }
+  return Isa::Scalar;
+}
+
+// 各レーンの1次ローパスはサンプルごとの依存 (レイテンシ) が支配的なので、
+// サンプル方向のループの内側で全レーンを回し、レーン間で並列に進める。
+//
+// 変調版は遅延 d = modBase + modSlope * p を [1, mask] に丸め、
+// 整数部 di と小数部 f に分けて (w - di) と (w - di - 1) を線形補間する。
+// di はチャンク内で変わらないように process でチャンクを区切ってあるので
+// (modDelay_)、読み出し位置の計算は変調しない場合と同じになる。さらに
+// (w - di - 1) は前のサンプルの (w - di) と同じ位置なので、SIMD 版は
+// 前のサンプルで読んだ値を使い回し、読み出しの回数も変調しない場合と揃える。
+// di + 1 が mask + 1 (= フレーム数) になっても、書き込み前の
+// フレーム w にはちょうどフレーム数前のサンプルが残っているので読んでよい。
+
+// --- スカラー版 (基準実装) ---
+template <bool Modulated>
+void CombBank::processScalar(const float* const* inputs, size_t inputStride,
+                             Accumulator* acc, size_t numSamples) {
+  float* buf = buffer_;
+  const size_t position = lfo_[0].getPosition();
+  for (size_t i = 0; i < numSamples; ++i) {
+    const uint32_t w = writeIndex_ + static_cast<uint32_t>(i);
+    float* frame = buf + static_cast<size_t>(w & mask_) * lanes_;
+    auto tapAt = [&](size_t lane, uint32_t delay) {
+      return frameAt(w, delay)[lane];
+    };
+    for (size_t ch = 0; ch < numChannels_; ++ch) {
+      const float x = inputs[ch][i * inputStride];
+      float sum = 0.0f;
+      for (size_t k = ch * stride_; k < (ch + 1) * stride_; ++k) {
+        float delayed;
+        if constexpr (Modulated) {
+          const uint32_t di = modDelay_[k];
+          const float f = modulatedDelay(k, position + i) -
+                          static_cast<float>(modDelay_[k]);
+          const float a = tapAt(k, di);
+          delayed = a + f * (tapAt(k, di + 1) - a);
+        } else {
+          delayed = tapAt(k, delay_[k]);
+        }
+        store_[k] = delayed * (1.0f - damping_[k]) + store_[k] * damping_[k];
+        const float y = x + gain_[k] * store_[k];
+        frame[k] = y;
+        sum += y * weight_[k];
+      }
+      acc[ch][i] = sum;
+    }
+  }
+}
+
+// --- SSE2 版: 4レーンずつ ---
+#if defined(COMBBANK_X86)
+namespace {
+inline float horizontalSum(__m128 v) {
+  __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+  __m128 sums = _mm_add_ps(v, shuf);
+  shuf = _mm_movehl_ps(shuf, sums);
+  return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+}
+}  // namespace
+
+template <size_t Groups, bool Modulated>
+void CombBank::processSse2(const float* const* inputs, size_t inputStride,
+                           Accumulator* acc, size_t numSamples) {
+  float* buf = buffer_;
+  const int32_t* delays = Modulated ? modDelay_ : delay_;
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 maxDelay = _mm_set1_ps(static_cast<float>(mask_));
+  const size_t position = lfo_[0].getPosition();
+  __m128 gain[Groups], damp[Groups], oneMinusDamp[Groups], weight[Groups],
+      store[Groups];
+  // 変調の係数と、遅延の整数部 (float)、前のサンプルで読んだ値
+  __m128 modBase[Groups], modSlope[Groups], delayF[Groups], prevTap[Groups];
+  // グループごとのチャンネルと、チャンネル最後のグループかどうか
+  size_t channel[Groups];
+  bool lastInChannel[Groups];
+  for (size_t g = 0; g < Groups; ++g) {
+    gain[g] = _mm_load_ps(gain_ + 4 * g);
+    damp[g] = _mm_load_ps(damping_ + 4 * g);
+    oneMinusDamp[g] = _mm_sub_ps(one, damp[g]);
+    weight[g] = _mm_load_ps(weight_ + 4 * g);
+    store[g] = _mm_load_ps(store_ + 4 * g);
+    channel[g] = 4 * g / stride_;
+    lastInChannel[g] = (4 * g + 4) % stride_ == 0;
+    if constexpr (Modulated) {
+      const size_t k = 4 * g;
+      modBase[g] = _mm_load_ps(modBase_ + k);
+      modSlope[g] = _mm_load_ps(modSlope_ + k);
+      delayF[g] = _mm_cvtepi32_ps(
+          _mm_load_si128(reinterpret_cast<const __m128i*>(modDelay_ + k)));
+      auto first = [&](size_t lane) {
+        return frameAt(writeIndex_, modDelay_[lane] + 1)[lane];
+      };
+      prevTap[g] = _mm_setr_ps(first(k), first(k + 1), first(k + 2),
+                               first(k + 3));
+    }
+  }
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    const uint32_t w = writeIndex_ + static_cast<uint32_t>(i);
+    float* frame = buf + static_cast<size_t>(w & mask_) * lanes_;
+    auto tap = [&](size_t lane) {
+      const uint32_t r = (w - delays[lane]) & mask_;
+      return buf[static_cast<size_t>(r) * lanes_ + lane];
+    };
+    const __m128 p = _mm_set1_ps(static_cast<float>(position + i));
+    __m128 sum = _mm_setzero_ps();
+    for (size_t g = 0; g < Groups; ++g) {
+      const size_t k = 4 * g;
+      const size_t ch = channel[g];
+      __m128 delayed = _mm_setr_ps(tap(k), tap(k + 1), tap(k + 2), tap(k + 3));
+      if constexpr (Modulated) {
+        const __m128 d = _mm_min_ps(
+            _mm_max_ps(_mm_add_ps(modBase[g], _mm_mul_ps(modSlope[g], p)),
+                       one),
+            maxDelay);
+        const __m128 f = _mm_sub_ps(d, delayF[g]);
+        const __m128 a = delayed;
+        delayed = _mm_add_ps(a, _mm_mul_ps(f, _mm_sub_ps(prevTap[g], a)));
+        prevTap[g] = a;
+      }
+      store[g] = _mm_add_ps(_mm_mul_ps(delayed, oneMinusDamp[g]),
+                            _mm_mul_ps(store[g], damp[g]));
+      const __m128 x = _mm_set1_ps(inputs[ch][i * inputStride]);
+      const __m128 y = _mm_add_ps(x, _mm_mul_ps(gain[g], store[g]));
+      _mm_storeu_ps(frame + k, y);
+      sum = _mm_add_ps(sum, _mm_mul_ps(y, weight[g]));
+      if (lastInChannel[g]) {
+        acc[ch][i] = horizontalSum(sum);
+        sum = _mm_setzero_ps();
+      }
+    }
+  }
+
+  for (size_t g = 0; g < Groups; ++g) {
+    _mm_store_ps(store_ + 4 * g, store[g]);
+  }
+}
+#endif
+
+// --- AVX2 版: 8レーンずつ ---
+// vgatherdps は多くの CPU でスカラーロード8回より遅いため、
+// 読み出しは SSE2 版と同じくスカラーロードで集める。
+// 8レーンの前半と後半が別チャンネルになる場合もあるので、
+// 入力は半分ずつブロードキャストし、総和も半分ずつチャンネルに振り分ける
+#if defined(COMBBANK_AVX2)
+template <size_t Octets, bool Modulated>
+void CombBank::processAvx2(const float* const* inputs, size_t inputStride,
+                           Accumulator* acc, size_t numSamples) {
+  float* buf = buffer_;
+  const int32_t* delays = Modulated ? modDelay_ : delay_;
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 maxDelay = _mm256_set1_ps(static_cast<float>(mask_));
+  const size_t position = lfo_[0].getPosition();
+  __m256 gain[Octets], damp[Octets], oneMinusDamp[Octets], weight[Octets],
+      store[Octets];
+  // 変調の係数と、遅延の整数部 (float)、前のサンプルで読んだ値
+  __m256 modBase[Octets], modSlope[Octets], delayF[Octets], prevTap[Octets];
+  // 前半・後半それぞれのチャンネルと、チャンネル最後の4レーンかどうか
+  size_t channelLo[Octets], channelHi[Octets];
+  bool lastLo[Octets], lastHi[Octets];
+  for (size_t o = 0; o < Octets; ++o) {
+    gain[o] = _mm256_load_ps(gain_ + 8 * o);
+    damp[o] = _mm256_load_ps(damping_ + 8 * o);
+    oneMinusDamp[o] = _mm256_sub_ps(one, damp[o]);
+    weight[o] = _mm256_load_ps(weight_ + 8 * o);
+    store[o] = _mm256_load_ps(store_ + 8 * o);
+    channelLo[o] = 8 * o / stride_;
+    channelHi[o] = (8 * o + 4) / stride_;
+    lastLo[o] = (8 * o + 4) % stride_ == 0;
+    lastHi[o] = (8 * o + 8) % stride_ == 0;
+    if constexpr (Modulated) {
+      const size_t k = 8 * o;
+      modBase[o] = _mm256_load_ps(modBase_ + k);
+      modSlope[o] = _mm256_load_ps(modSlope_ + k);
+      delayF[o] = _mm256_cvtepi32_ps(
+          _mm256_load_si256(reinterpret_cast<const __m256i*>(modDelay_ + k)));
+      auto first = [&](size_t lane) {
+        return frameAt(writeIndex_, modDelay_[lane] + 1)[lane];
+      };
+      prevTap[o] = _mm256_setr_ps(first(k), first(k + 1), first(k + 2),
+                                  first(k + 3), first(k + 4), first(k + 5),
+                                  first(k + 6), first(k + 7));
+    }
+  }
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    const uint32_t w = writeIndex_ + static_cast<uint32_t>(i);
+    float* frame = buf + static_cast<size_t>(w & mask_) * lanes_;
+    auto tap = [&](size_t lane) {
+      const uint32_t r = (w - delays[lane]) & mask_;
+      return buf[static_cast<size_t>(r) * lanes_ + lane];
+    };
+    const __m256 p = _mm256_set1_ps(static_cast<float>(position + i));
+    __m128 sum = _mm_setzero_ps();
+    for (size_t o = 0; o < Octets; ++o) {
+      const size_t k = 8 * o;
+      const size_t chLo = channelLo[o];
+      const size_t chHi = channelHi[o];
+      __m256 delayed =
+          _mm256_setr_ps(tap(k), tap(k + 1), tap(k + 2), tap(k + 3),
+                         tap(k + 4), tap(k + 5), tap(k + 6), tap(k + 7));
+      if constexpr (Modulated) {
+        const __m256 d = _mm256_min_ps(
+            _mm256_max_ps(
+                _mm256_add_ps(modBase[o], _mm256_mul_ps(modSlope[o], p)), one),
+            maxDelay);
+        const __m256 f = _mm256_sub_ps(d, delayF[o]);
+        const __m256 a = delayed;
+        delayed =
+            _mm256_add_ps(a, _mm256_mul_ps(f, _mm256_sub_ps(prevTap[o], a)));
+        prevTap[o] = a;
+      }
+      store[o] = _mm256_add_ps(_mm256_mul_ps(delayed, oneMinusDamp[o]),
+                               _mm256_mul_ps(store[o], damp[o]));
+      const __m256 x = _mm256_insertf128_ps(
+          _mm256_castps128_ps256(_mm_set1_ps(inputs[chLo][i * inputStride])),
+          _mm_set1_ps(inputs[chHi][i * inputStride]), 1);
+      const __m256 y = _mm256_add_ps(x, _mm256_mul_ps(gain[o], store[o]));
+      _mm256_storeu_ps(frame + k, y);
+
+      const __m256 weighted = _mm256_mul_ps(y, weight[o]);
+      sum = _mm_add_ps(sum, _mm256_castps256_ps128(weighted));
+      if (lastLo[o]) {
+        acc[chLo][i] = horizontalSum(sum);
+        sum = _mm_setzero_ps();
+      }
+      sum = _mm_add_ps(sum, _mm256_extractf128_ps(weighted, 1));
+      if (lastHi[o]) {
+        acc[chHi][i] = horizontalSum(sum);
+        sum = _mm_setzero_ps();
+      }
+    }
+  }
+
+  for (size_t o = 0; o < Octets; ++o) {
+    _mm256_store_ps(store_ + 8 * o, store[o]);
+  }
+}
+#endif
+
+// --- NEON 版: 4レーンずつ ---
+#if defined(COMBBANK_NEON)
+template <size_t Groups, bool Modulated>
+void CombBank::processNeon(const float* const* inputs, size_t inputStride,
+                           Accumulator* acc, size_t numSamples) {
+  float* buf = buffer_;
+  const int32_t* delays = Modulated ? modDelay_ : delay_;
+  const float32x4_t one = vdupq_n_f32(1.0f);
+  const float32x4_t maxDelay = vdupq_n_f32(static_cast<float>(mask_));
+  const size_t position = lfo_[0].getPosition();
+  float32x4_t gain[Groups], damp[Groups], oneMinusDamp[Groups],
+      weight[Groups], store[Groups];
+  // 変調の係数と、遅延の整数部 (float)、前のサンプルで読んだ値
+  float32x4_t modBase[Groups], modSlope[Groups], delayF[Groups],
+      prevTap[Groups];
+  // グループごとのチャンネルと、チャンネル最後のグループかどうか
+  size_t channel[Groups];
+  bool lastInChannel[Groups];
+  for (size_t g = 0; g < Groups; ++g) {
+    gain[g] = vld1q_f32(gain_ + 4 * g);
+    damp[g] = vld1q_f32(damping_ + 4 * g);
+    oneMinusDamp[g] = vsubq_f32(one, damp[g]);
+    weight[g] = vld1q_f32(weight_ + 4 * g);
+    store[g] = vld1q_f32(store_ + 4 * g);
+    channel[g] = 4 * g / stride_;
+    lastInChannel[g] = (4 * g + 4) % stride_ == 0;
+    if constexpr (Modulated) {
+      const size_t k = 4 * g;
+      modBase[g] = vld1q_f32(modBase_ + k);
+      modSlope[g] = vld1q_f32(modSlope_ + k);
+      delayF[g] = vcvtq_f32_s32(vld1q_s32(modDelay_ + k));
+      float first[4];
+      for (size_t j = 0; j < 4; ++j) {
+        first[j] = frameAt(writeIndex_, modDelay_[k + j] + 1)[k + j];
+      }
+      prevTap[g] = vld1q_f32(first);
+    }
+  }
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    const uint32_t w = writeIndex_ + static_cast<uint32_t>(i);
+    float* frame = buf + static_cast<size_t>(w & mask_) * lanes_;
+    auto tap = [&](size_t lane) {
+      const uint32_t r = (w - delays[lane]) & mask_;
+      return buf + static_cast<size_t>(r) * lanes_ + lane;
+    };
+    const float32x4_t p = vdupq_n_f32(static_cast<float>(position + i));
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    for (size_t g = 0; g < Groups; ++g) {
+      const size_t k = 4 * g;
+      const size_t ch = channel[g];
+      float32x4_t delayed = vdupq_n_f32(0.0f);
+      delayed = vld1q_lane_f32(tap(k), delayed, 0);
+      delayed = vld1q_lane_f32(tap(k + 1), delayed, 1);
+      delayed = vld1q_lane_f32(tap(k + 2), delayed, 2);
+      delayed = vld1q_lane_f32(tap(k + 3), delayed, 3);
+      if constexpr (Modulated) {
+        const float32x4_t d = vminq_f32(
+            vmaxq_f32(vaddq_f32(modBase[g], vmulq_f32(modSlope[g], p)), one),
+            maxDelay);
+        const float32x4_t f = vsubq_f32(d, delayF[g]);
+        const float32x4_t a = delayed;
+        delayed = vaddq_f32(a, vmulq_f32(f, vsubq_f32(prevTap[g], a)));
+        prevTap[g] = a;
+      }
+      store[g] = vaddq_f32(vmulq_f32(delayed, oneMinusDamp[g]),
+                           vmulq_f32(store[g], damp[g]));
+      const float32x4_t x = vdupq_n_f32(inputs[ch][i * inputStride]);
+      const float32x4_t y = vaddq_f32(x, vmulq_f32(gain[g], store[g]));
+      vst1q_f32(frame + k, y);
+      sum = vaddq_f32(sum, vmulq_f32(y, weight[g]));
+      if (lastInChannel[g]) {
+        acc[ch][i] = vaddvq_f32(sum);
+        sum = vdupq_n_f32(0.0f);
+      }
+    }
+  }
+
+  for (size_t g = 0; g < Groups; ++g) {
+    vst1q_f32(store_ + 4 * g, store[g]);
+  }
+}
+#endif
@@ -0,0 +1,173 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FloatArena.h"
+#include "Lfo.h"
+
+// AVX2 カーネルは関数単位で target 属性を付けてコンパイルする
+// (ビルド全体を -mavx2 にせず、実行時に CPU を見て切り替えるため)
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define COMBBANK_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define COMBBANK_TARGET_AVX2
+#endif
+
+// 並列コムフィルタ群 (structure-of-arrays)
+// Reverb の各コムフィルタは互いに独立なので、1コム = 1レーンとして
+// SIMD レジスタに並べ、読み出し・ダンピング・フィードバックを全コム同時に行う。
+//
+// 遅延バッファは全コムで共有する書き込み位置を持ち、
+// [フレーム][レーン] のインターリーブ配置にする。
+// 書き込みは1フレーム分の連続ストア、読み出しはレーンごとに
+// (writeIndex - delay[lane]) の位置から集める (gather)。
+//
+// 複数チャンネルを扱う場合は、チャンネルごとに4の倍数のレーンを割り当てて
+// 同じフレームに並べる。全チャンネルの状態が連続したメモリにあるので、
+// 1回のパスで全チャンネルを処理できる。
+//
+// arena を渡すと遅延バッファをそこから切り出す (ReverbPool 用)。
+//
+// 各レーンの計算は CombFilter::process と同じ:
+//   store = delayed * (1 - damping) + store * damping
+//   y     = x + gain * store
+// 出力はチャンネルごとの y の総和。
+//
+// setModulation でレーンごとの遅延を LFO で揺らせる (コーラス状の変調)。
+// 変調中は遅延をサンプルごとに小数で求め、隣り合う2フレームを線形補間して
+// 読む。遅延の計算と補間はレーン方向に SIMD 化し、増えるスカラー処理は
+// レーンごとの2点の読み出しだけにしている。
+class CombBank {
+ public:
+  enum class Isa { Scalar, SSE2, AVX2, NEON };
+
+  static constexpr size_t kMaxCombs = 8;   // 1チャンネルあたり
+  static constexpr size_t kMaxLanes = 32;  // 全チャンネル合計
+  static constexpr size_t kMaxChannels = kMaxLanes / 4;
+
+  // maxDelaySamples: 設定しうる最大の遅延サンプル数
+  CombBank(size_t numCombs, int maxDelaySamples, size_t numChannels = 1,
+           FloatArena* arena = nullptr);
+
+  CombBank(const CombBank&) = delete;
+  CombBank& operator=(const CombBank&) = delete;
+  CombBank(CombBank&&) = default;
+  CombBank& operator=(CombBank&&) = default;
+
+  // この構成で確保する遅延バッファの float 数
+  static size_t requiredSize(size_t numCombs, int maxDelaySamples,
+                             size_t numChannels = 1);
+
+  // チャンネル0の出力の総和を output に書く。
+  // input と output は同じバッファでもよい
+  void process(const float* input, float* output, size_t numSamples);
+  // チャンネルごとの先頭ポインタとストライドで入出力する (コピー不要)
+  //   planar:      inputs[ch] = planes[ch],        stride = 1
+  //   interleaved: inputs[ch] = interleaved + ch,  stride = numChannels
+  void process(const float* const* inputs, size_t inputStride,
+               float* const* outputs, size_t outputStride, size_t numSamples);
+  void reset();
+
+  void setDelaySamples(size_t comb, int delaySamples, size_t channel = 0);
+  void setGain(size_t comb, float gain, size_t channel = 0);
+  void setDamping(size_t comb, float damping, size_t channel = 0);
+  // 遅延を LFO (cyclesPerSample = Hz / サンプルレート の正弦波) で
+  // ±depthSamples だけ揺らす。全レーンの depth が 0 なら変調しない
+  void setModulation(size_t comb, float depthSamples, float cyclesPerSample,
+                     size_t channel = 0);
+  // setModulation の周波数だけ・揺れ幅だけを変える (オートメーションで
+  // 揺れ幅だけが変わるとき用)
+  void setModulationRate(size_t comb, float cyclesPerSample,
+                         size_t channel = 0);
+  void setModulationDepth(size_t comb, float depthSamples, size_t channel = 0);
+  int getDelaySamples(size_t comb, size_t channel = 0) const {
+    return delay_[lane(comb, channel)];
+  }
+  float getGain(size_t comb, size_t channel = 0) const {
+    return gain_[lane(comb, channel)];
+  }
+  size_t getNumCombs() const { return numCombs_; }
+  size_t getNumChannels() const { return numChannels_; }
+
+  bool isModulated() const { return modulated_; }
+
+  // 実行時に選ばれた命令セット。setIsa で強制できる (テスト・比較用)
+  Isa getIsa() const { return isa_; }
+  // 対応していない命令セットを指定した場合は false を返し、変更しない
+  bool setIsa(Isa isa);
+  static bool isSupported(Isa isa, size_t lanes);
+  static Isa detectIsa(size_t lanes);
+
+ private:
+  // 一度にカーネルへ渡すサンプル数。チャンネルごとの総和をスタック上に置く
+  static constexpr size_t kChunkSize = 64;
+  using Accumulator = float[kChunkSize];
+  // inputs から numSamples (<= kChunkSize) 個を処理し、
+  // チャンネルごとの総和を acc に書く
+  using Kernel = void (CombBank::*)(const float* const*, size_t,
+                                    Accumulator*, size_t);
+
+  size_t lane(size_t comb, size_t channel) const {
+    return channel * stride_ + comb;
+  }
+  // 書き込み位置 w から delay フレーム前のフレームの先頭
+  const float* frameAt(uint32_t w, uint32_t delay) const {
+    return buffer_ + static_cast<size_t>((w - delay) & mask_) * lanes_;
+  }
+  // LFO のセグメント内の位置 position での、変調した遅延 ([1, mask_])
+  float modulatedDelay(size_t lane, size_t position) const;
+  // position まで、全レーンの遅延の整数部が modDelay_ のままか
+  bool integerDelaysHeld(size_t position) const;
+
+  // isa_ と変調の有無に合うカーネルを選ぶ
+  void selectKernel();
+
+  // SIMD 版はグループ数 (4レーン単位、AVX2 は8レーン単位) を
+  // テンプレート引数にして、全グループの状態をレジスタに置いたまま回す。
+  // Modulated のときは遅延を小数で求めて線形補間で読む
+  template <bool Modulated>
+  void processScalar(const float* const* inputs, size_t inputStride,
+                     Accumulator* acc, size_t numSamples);
+  template <size_t Groups, bool Modulated>
+  void processSse2(const float* const* inputs, size_t inputStride,
+                   Accumulator* acc, size_t numSamples);
+  template <size_t Octets, bool Modulated>
+  COMBBANK_TARGET_AVX2 void processAvx2(const float* const* inputs,
+                                        size_t inputStride, Accumulator* acc,
+                                        size_t numSamples);
+  template <size_t Groups, bool Modulated>
+  void processNeon(const float* const* inputs, size_t inputStride,
+                   Accumulator* acc, size_t numSamples);
+
+  size_t numCombs_;
+  size_t numChannels_;
+  size_t stride_;  // 1チャンネルあたりのレーン数 (numCombs_ を4の倍数に)
+  size_t lanes_;   // 全レーン数 = stride_ * numChannels_
+
+  std::vector<float> storage_;  // アリーナを使わない場合のバッファ
+  float* buffer_;               // [フレーム][レーン]
+  uint32_t mask_;              // フレーム数 - 1 (フレーム数は2のべき乗)
+  uint32_t writeIndex_;
+
+  // 余ったレーンは gain 0 / weight 0 にして総和に含めない
+  alignas(32) float gain_[kMaxLanes];
+  alignas(32) float damping_[kMaxLanes];
+  alignas(32) float store_[kMaxLanes];
+  alignas(32) float weight_[kMaxLanes];
+  alignas(32) int32_t delay_[kMaxLanes];
+
+  // 変調: サンプル位置 p (LFO のセグメント内) の遅延は
+  //   modBase_ + modSlope_ * p  (= delay + depth * LFO の値)
+  Lfo lfo_[kMaxLanes];
+  alignas(32) float modDepth_[kMaxLanes];
+  alignas(32) float modBase_[kMaxLanes];
+  alignas(32) float modSlope_[kMaxLanes];
+  // 今のチャンクでの遅延の整数部 (チャンク内では変わらない)
+  alignas(32) int32_t modDelay_[kMaxLanes];
+  bool modulated_;
+
+  Isa isa_;
+  Kernel kernel_;
+};
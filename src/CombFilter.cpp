@@ -1,21 +1,52 @@
 #include "CombFilter.h"
 
+#include <algorithm>
+
+#include "DenormalGuard.h"
+
 CombFilter::CombFilter(float sampleRate, float delayTime, float gain,
                        float dumping)
     : delayLine((int)(sampleRate * delayTime), sampleRate * 2),
       currentSampleRate(sampleRate),
       delayTime(delayTime),
       gain(gain),
-      dumping_(dumping) {}
+      dumping_(dumping),
+      store_(0.0f) {}
 
 float CombFilter::process(float sample) {
-  float delayed_output = delayLine.read();
-  // ★ダンピング処理（ローパスフィルタ）
-  store_ = delayed_output * (1.0f - dumping_) + store_ * dumping_;
+  float output;
+  process(&sample, &output, 1);
+  return output;
+}
+
+void CombFilter::process(const float* input, float* output,
+                         size_t numSamples) {
+  const DenormalGuard denormalGuard;
+  // 遅延長より長いブロックは読み出し前に書き込みが必要になるので、
+  // 遅延長 (と作業領域) 以下のチャンクに分割して処理する
+  const size_t delaySamples =
+      static_cast<size_t>(std::max(delayLine.getDelaySamples(), 1));
+  const size_t maxChunk = std::min(kChunkSize, delaySamples);
+  float delayed[kChunkSize];
 
-  float processed = sample + gain * store_;
-  delayLine.write(processed);
-  return processed;
+  while (numSamples > 0) {
+    const size_t n = std::min(numSamples, maxChunk);
+    delayLine.read(delayed, n);
+
+    float store = store_;
+    for (size_t i = 0; i < n; ++i) {
+      // ★ダンピング処理（ローパスフィルタ）
+      store = delayed[i] * (1.0f - dumping_) + store * dumping_;
+      output[i] = input[i] + gain * store;
+    }
+    // 入力が止まった後も非正規化数がフィードバックに残らないようにする
+    store_ = DenormalGuard::flushState(store);
+
+    delayLine.write(output, n);
+    input += n;
+    output += n;
+    numSamples -= n;
+  }
 }
 
 void CombFilter::setup(float sampleRate, float delayTime) {}
@@ -30,10 +61,15 @@ void CombFilter::updateParameters(float sampleRate, float delayTime,
 }
 
 void CombFilter::setSampleRate(float newSampleRate) {
-  this->currentSampleRate = newSampleRate;
+  // 遅延時間 (秒) はそのままで、確保済みのバッファの中で遅延長を換算し直す
+  // (キャパシティはコンストラクタのレートで2秒分)
+  updateParameters(newSampleRate, delayTime, gain);
 }
 
 void CombFilter::updateDumping(float newDumping) {
   this->dumping_ = newDumping;
 }
-void CombFilter::reset() { delayLine.clear(); }
\ No newline at end of file
+void CombFilter::reset() {
+  delayLine.clear();
+  store_ = 0.0f;
+}
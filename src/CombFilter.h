@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+
 #include "AudioEffect.h"
 #include "DelayLine.h"
 
@@ -10,13 +12,16 @@
 //               |                     |
 //               +----<----[Gain g]<---+
 
-class CombFilter {
+class CombFilter final : public AudioEffect {
  public:
   CombFilter(float sampleRate, float delayTime, float gain, float dumping);
 
   void setup(float sampleRate, float delayTime);
   float process(float sample);
-  void reset();
+  // ブロック処理。input と output は同じバッファでもよい
+  void process(const float* input, float* output,
+               size_t numSamples) override;
+  void reset() override;
   void setSampleRate(float newSampleRate);
   void updateParameters(float sampleRate, float delayTime, float gain);
   void updateDumping(float newDumping);
@@ -24,10 +29,13 @@ class CombFilter {
   float getGain() { return gain; }
 
  private:
+  // 一度に DelayLine から読み出す最大サンプル数 (スタック上の作業領域)
+  static constexpr size_t kChunkSize = 64;
+
   DelayLine delayLine;
   float currentSampleRate;
   float delayTime;
   float gain;
   float dumping_;
   float store_;
-};
\ No newline at end of file
+};
@@ -0,0 +1,305 @@
+#include "ConvolutionReverb.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "ReverbTuning.h"
+
+using namespace reverb_tuning;
+
+ConvolutionReverb::UniformConvolver::UniformConvolver(const float* ir,
+                                                      size_t begin, size_t end,
+                                                      size_t blockSize)
+    : blockSize_(blockSize),
+      numBins_(blockSize + 1),
+      numPartitions_((end - begin + blockSize - 1) / blockSize),
+      fft_(2 * blockSize),
+      filterRe_(numPartitions_ * numBins_),
+      filterIm_(numPartitions_ * numBins_),
+      inputRe_(numPartitions_ * numBins_),
+      inputIm_(numPartitions_ * numBins_),
+      sumRe_(numBins_),
+      sumIm_(numBins_),
+      timeDomain_(2 * blockSize) {
+  // 逆 FFT は FFT 長倍になるので、その分をスペクトルに掛けておく
+  const float normalize = 1.0f / static_cast<float>(2 * blockSize_);
+  for (size_t p = 0; p < numPartitions_; ++p) {
+    const size_t offset = begin + p * blockSize_;
+    const size_t count = std::min(blockSize_, end - offset);
+    std::fill(timeDomain_.begin(), timeDomain_.end(), 0.0f);
+    for (size_t i = 0; i < count; ++i) {
+      timeDomain_[i] = ir[offset + i] * normalize;
+    }
+    fft_.forward(timeDomain_.data(), &filterRe_[p * numBins_],
+                 &filterIm_[p * numBins_]);
+  }
+}
+
+void ConvolutionReverb::UniformConvolver::processBlock(const float* frame,
+                                                       float* out) {
+  newest_ = newest_ == 0 ? numPartitions_ - 1 : newest_ - 1;
+  fft_.forward(frame, &inputRe_[newest_ * numBins_],
+               &inputIm_[newest_ * numBins_]);
+
+  // 分割 p には p ブロック前の入力のスペクトルを掛ける
+  std::fill(sumRe_.begin(), sumRe_.end(), 0.0f);
+  std::fill(sumIm_.begin(), sumIm_.end(), 0.0f);
+  float* sumRe = sumRe_.data();
+  float* sumIm = sumIm_.data();
+  size_t slot = newest_;
+  for (size_t p = 0; p < numPartitions_; ++p) {
+    const float* xRe = &inputRe_[slot * numBins_];
+    const float* xIm = &inputIm_[slot * numBins_];
+    const float* hRe = &filterRe_[p * numBins_];
+    const float* hIm = &filterIm_[p * numBins_];
+    for (size_t k = 0; k < numBins_; ++k) {
+      sumRe[k] += xRe[k] * hRe[k] - xIm[k] * hIm[k];
+      sumIm[k] += xRe[k] * hIm[k] + xIm[k] * hRe[k];
+    }
+    slot = slot + 1 == numPartitions_ ? 0 : slot + 1;
+  }
+
+  // 巡回畳み込みの後半だけが線形畳み込みと一致する
+  fft_.inverse(sumRe, sumIm, timeDomain_.data());
+  std::copy_n(timeDomain_.begin() + blockSize_, blockSize_, out);
+}
+
+void ConvolutionReverb::UniformConvolver::clear() {
+  std::fill(inputRe_.begin(), inputRe_.end(), 0.0f);
+  std::fill(inputIm_.begin(), inputIm_.end(), 0.0f);
+}
+
+ConvolutionReverb::ConvolutionReverb(float sampleRate,
+                                     const float* impulseResponse,
+                                     size_t length, size_t headSize,
+                                     size_t tailBlockSize, bool backgroundTail)
+    : length_(length),
+      headSize_(std::bit_floor(
+          std::clamp(headSize, kMinHeadSize, kMaxHeadSize))),
+      tailBlockSize_(std::bit_floor(std::max(tailBlockSize, 4 * headSize_))),
+      head_(headSize_, 0.0f),
+      headFrame_(2 * headSize_, 0.0f),
+      wet_(headSize_),
+      backgroundTail_(backgroundTail),
+      wetLevel_(kDefaultWetLevel, smoothingSamples(sampleRate)) {
+  std::copy_n(impulseResponse, std::min(length_, headSize_), head_.begin());
+
+  // ブロック長 S の段は IR の時刻 S から 4S まで。ブロック長が末尾に
+  // 届く段は作らず、手前の段を末尾の始まり (2T) まで伸ばす
+  const size_t tailBegin = 2 * tailBlockSize_;
+  size_t begin = headSize_;
+  for (size_t blockSize = headSize_; begin < std::min(length_, tailBegin);
+       blockSize *= 4) {
+    const bool last = 4 * blockSize >= tailBlockSize_;
+    const size_t end = std::min(length_, last ? tailBegin : 4 * blockSize);
+    stages_.push_back({UniformConvolver(impulseResponse, begin, end, blockSize),
+                       std::vector<float>(2 * blockSize, 0.0f),
+                       std::vector<float>(blockSize, 0.0f)});
+    begin = end;
+  }
+
+  if (length_ > tailBegin) {
+    tail_ = std::make_unique<UniformConvolver>(impulseResponse, tailBegin,
+                                               length_, tailBlockSize_);
+    for (int i = 0; i < 2; ++i) {
+      tailInput_[i].assign(tailBlockSize_, 0.0f);
+      tailOutput_[i].assign(tailBlockSize_, 0.0f);
+    }
+    tailFrame_.assign(2 * tailBlockSize_, 0.0f);
+    if (backgroundTail_) {
+      worker_ = std::thread(&ConvolutionReverb::tailWorkerLoop, this);
+    }
+  }
+
+  reset();
+}
+
+ConvolutionReverb::~ConvolutionReverb() {
+  if (worker_.joinable()) {
+    stop_.store(true, std::memory_order_relaxed);
+    tailPosted_.fetch_add(1, std::memory_order_release);
+    tailPosted_.notify_one();
+    worker_.join();
+  }
+}
+
+float ConvolutionReverb::process(float sample) {
+  float output;
+  process(&sample, &output, 1);
+  return output;
+}
+
+void ConvolutionReverb::process(const float* input, float* output,
+                                size_t numSamples) {
+  wetLevel_.pollTarget();
+  float* wet = wet_.data();
+  while (numSamples > 0) {
+    const size_t offset = position_ & (headSize_ - 1);
+    const size_t n = std::min(numSamples, headSize_ - offset);
+    processChunk(input, wet, n);
+
+    if (wetLevel_.isRamping()) {
+      for (size_t i = 0; i < n; ++i) {
+        const float wetLevel = wetLevel_.advance(1);
+        output[i] = ((1.0f - wetLevel) * input[i]) + (wetLevel * wet[i]);
+      }
+    } else {
+      const float wetLevel = wetLevel_.getCurrent();
+      const float dryLevel = 1.0f - wetLevel;
+      for (size_t i = 0; i < n; ++i) {
+        output[i] = (dryLevel * input[i]) + (wetLevel * wet[i]);
+      }
+    }
+    input += n;
+    output += n;
+    numSamples -= n;
+  }
+}
+
+void ConvolutionReverb::processChunk(const float* input, float* wet,
+                                     size_t numSamples) {
+  const size_t offset = position_ & (headSize_ - 1);
+  float* current = headFrame_.data() + headSize_ + offset;
+  std::copy_n(input, numSamples, current);
+
+  // 先頭区間の直接畳み込み。タップを外側に回すと、内側のループは
+  // 隣り合うサンプルについての積和になり SIMD 化できる
+  std::fill_n(wet, numSamples, 0.0f);
+  for (size_t k = 0; k < headSize_; ++k) {
+    const float h = head_[k];
+    const float* x = current - k;
+    for (size_t i = 0; i < numSamples; ++i) {
+      wet[i] += h * x[i];
+    }
+  }
+
+  // 前のブロックで計算しておいた各段の出力を足し、入力をためる
+  for (Stage& stage : stages_) {
+    const size_t blockSize = stage.convolver.getBlockSize();
+    const size_t stageOffset = position_ & (blockSize - 1);
+    const float* stageOutput = stage.output.data() + stageOffset;
+    for (size_t i = 0; i < numSamples; ++i) {
+      wet[i] += stageOutput[i];
+    }
+    std::copy_n(input, numSamples,
+                stage.frame.data() + blockSize + stageOffset);
+    if (stageOffset + numSamples == blockSize) {
+      stage.convolver.processBlock(stage.frame.data(), stage.output.data());
+      std::copy_n(stage.frame.begin() + blockSize, blockSize,
+                  stage.frame.begin());
+    }
+  }
+
+  if (tail_) {
+    // 末尾のブロック J (reset() から数えて) の結果は、入力ブロック J の
+    // 2ブロック後 (J + 2) で使う。末尾区間は IR の 2T から始まるので、
+    // ブロック J を渡してから J + 2 の先頭まで、ワーカーに T サンプル分の
+    // 猶予ができる (1ブロック後だと J を渡した直後に待つことになる)。
+    // ブロック長はどの段のブロック長の倍数でもあるので、チャンクが末尾の
+    // ブロックの境目をまたぐことはない
+    const uint64_t tailBlock = position_ / tailBlockSize_;
+    const size_t tailOffset = position_ & (tailBlockSize_ - 1);
+    const uint32_t block = tailBase_ + static_cast<uint32_t>(tailBlock);
+    if (tailBlock >= 2) {
+      if (tailOffset == 0) {
+        waitForTail(block - 2);
+      }
+      const float* tailOutput = tailOutput_[block & 1].data() + tailOffset;
+      for (size_t i = 0; i < numSamples; ++i) {
+        wet[i] += tailOutput[i];
+      }
+    }
+    std::copy_n(input, numSamples, tailInput_[block & 1].data() + tailOffset);
+    if (tailOffset + numSamples == tailBlockSize_) {
+      postTailBlock();
+    }
+  }
+
+  position_ += numSamples;
+  if (offset + numSamples == headSize_) {
+    std::copy_n(headFrame_.begin() + headSize_, headSize_,
+                headFrame_.begin());
+  }
+}
+
+void ConvolutionReverb::postTailBlock() {
+  tailBlocks_.increment();
+  const uint32_t block = tailPosted_.load(std::memory_order_relaxed);
+  if (!backgroundTail_) {
+    processTailBlock(block);
+    tailPosted_.store(block + 1, std::memory_order_relaxed);
+    tailDone_.store(block + 1, std::memory_order_relaxed);
+    return;
+  }
+  tailPosted_.store(block + 1, std::memory_order_release);
+  tailPosted_.notify_one();
+}
+
+void ConvolutionReverb::waitForTail(uint32_t block) {
+  // 番号の一周 (約2^32ブロック) を考えて差で比べる
+  const auto finished = [block](uint32_t done) {
+    return static_cast<int32_t>(done - block) > 0;
+  };
+  uint32_t done = tailDone_.load(std::memory_order_acquire);
+  if (finished(done)) {
+    return;
+  }
+  lateTailBlocks_.increment();
+  do {
+    tailDone_.wait(done, std::memory_order_acquire);
+    done = tailDone_.load(std::memory_order_acquire);
+  } while (!finished(done));
+}
+
+void ConvolutionReverb::processTailBlock(uint32_t block) {
+  std::copy_n(tailInput_[block & 1].begin(), tailBlockSize_,
+              tailFrame_.begin() + tailBlockSize_);
+  tail_->processBlock(tailFrame_.data(), tailOutput_[block & 1].data());
+  std::copy_n(tailFrame_.begin() + tailBlockSize_, tailBlockSize_,
+              tailFrame_.begin());
+}
+
+void ConvolutionReverb::tailWorkerLoop() {
+  uint32_t done = 0;
+  for (;;) {
+    tailPosted_.wait(done, std::memory_order_acquire);
+    if (stop_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    const uint32_t posted = tailPosted_.load(std::memory_order_acquire);
+    while (done != posted) {
+      processTailBlock(done);
+      ++done;
+      tailDone_.store(done, std::memory_order_release);
+      tailDone_.notify_one();
+    }
+  }
+}
+
+void ConvolutionReverb::reset() {
+  if (tail_) {
+    // ワーカーが手を離してから末尾の状態を消す
+    const uint32_t posted = tailPosted_.load(std::memory_order_relaxed);
+    uint32_t done = tailDone_.load(std::memory_order_acquire);
+    while (done != posted) {
+      tailDone_.wait(done, std::memory_order_acquire);
+      done = tailDone_.load(std::memory_order_acquire);
+    }
+    tail_->clear();
+    std::fill(tailFrame_.begin(), tailFrame_.end(), 0.0f);
+    tailBase_ = posted;
+  }
+  std::fill(headFrame_.begin(), headFrame_.end(), 0.0f);
+  for (Stage& stage : stages_) {
+    stage.convolver.clear();
+    std::fill(stage.frame.begin(), stage.frame.end(), 0.0f);
+    std::fill(stage.output.begin(), stage.output.end(), 0.0f);
+  }
+  position_ = 0;
+  // 無音から始めるので、パラメータはランプせずに目標値へ切り替える
+  wetLevel_.snap();
+}
+
+void ConvolutionReverb::setWetLevel(float level) {
+  wetLevel_.setTarget(std::clamp(level, 0.0f, 1.0f));
+}
@@ -0,0 +1,176 @@
+#ifndef CONVOLUTIONREVERB_H
+#define CONVOLUTIONREVERB_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "Fft.h"
+#include "RelaxedCounter.h"
+#include "SmoothedParameter.h"
+
+// 測定したインパルス応答 (IR) を畳み込むリバーブ
+//
+// IR を長さの違う区間に分け (非一様分割)、区間ごとに方法を変える:
+//
+//   [0, H)         先頭: 直接畳み込み (FIR)。レイテンシ 0
+//   [H, 4H)        ブロック長 H の一様分割 overlap-save
+//   [4H, 16H) ...  ブロック長を4倍ずつ伸ばした一様分割 overlap-save
+//   ... [?, 2T)    最後の段はブロック長 T の手前で止め、2T まで伸ばす
+//   [2T, 末尾)     ブロック長 T の一様分割 overlap-save (ワーカースレッド)
+//
+// H = headSize, T = tailBlockSize。各区間は周波数領域遅延線
+// (過去の入力ブロックのスペクトル) と区間のスペクトルの複素積和で計算する。
+// ブロック長 S の段は IR の時刻 S から始まるので、入力ブロックが揃った
+// 時点で計算すれば、次のブロックの出力にちょうど間に合う。
+//
+// レイテンシの予算:
+//   - 出力の遅れは 0 サンプル (先頭は直接畳み込み)
+//   - process() の仕事は H サンプルごとに発生し、ブロック長 S の段は
+//     S サンプルごとに FFT 2回と積和をまとめて行う。全ての段の境目が
+//     重なるブロックが最も重い (ホストのブロック長が H 以上なら平均化される)
+//   - 末尾はワーカーに渡してから使い始めるまでに T サンプル
+//     (T / sampleRate 秒、48kHz, T = 4096 で約 85ms) の猶予がある。
+//     間に合わなかったときは process() が待ち、lateTailBlocks に数える
+//   - 末尾の積和は遅延線のスペクトルを読む速さで決まり、1サンプルあたり
+//     約 16 * IR長 / T バイトになる。T を大きくするほど末尾は軽くなるが、
+//     process() の中の段が増える
+//
+// IR とバッファはコンストラクタで確保し、process() はメモリ確保も
+// mutex も使わない。ワーカーとは std::atomic の wait / notify で
+// ブロック番号をやり取りし、入出力は2面のバッファを交互に使う。
+class ConvolutionReverb {
+ public:
+  struct Stats {
+    uint32_t tailBlocks;      // ワーカーに渡した末尾のブロック数
+    uint32_t lateTailBlocks;  // 末尾の計算を待った回数
+  };
+
+  static constexpr size_t kMinHeadSize = 16;
+  static constexpr size_t kMaxHeadSize = 1024;
+  static constexpr size_t kDefaultHeadSize = 64;
+  static constexpr size_t kDefaultTailBlockSize = 4096;
+
+  // impulseResponse (length サンプル) はコピーして持つ。
+  // headSize は [kMinHeadSize, kMaxHeadSize] の2のべき乗に切り下げ、
+  // tailBlockSize は headSize * 4 以上の2のべき乗に切り下げる。
+  // backgroundTail が false なら末尾も process() の中で計算する
+  // (オフライン処理や、出力を決定的に比べたいテスト用)
+  ConvolutionReverb(float sampleRate, const float* impulseResponse,
+                    size_t length, size_t headSize = kDefaultHeadSize,
+                    size_t tailBlockSize = kDefaultTailBlockSize,
+                    bool backgroundTail = true);
+  ~ConvolutionReverb();
+
+  ConvolutionReverb(const ConvolutionReverb&) = delete;
+  ConvolutionReverb& operator=(const ConvolutionReverb&) = delete;
+
+  float process(float sample);
+  // ブロック処理。input と output は同じバッファでもよい
+  void process(const float* input, float* output, size_t numSamples);
+  // ワーカーの計算が終わるのを待ってから、全ての状態を消す
+  void reset();
+
+  void setWetLevel(float level);  // 0.0 (dry) to 1.0 (wet)
+
+  size_t getLength() const { return length_; }
+  size_t getHeadSize() const { return headSize_; }
+  size_t getTailBlockSize() const { return tailBlockSize_; }
+  // process() の中で計算する一様分割の段の数 (末尾を除く)
+  size_t getNumStages() const { return stages_.size(); }
+  bool hasTail() const { return tail_ != nullptr; }
+
+  Stats getStats() const {
+    return {tailBlocks_.load(), lateTailBlocks_.load()};
+  }
+  void resetStats() {
+    tailBlocks_.reset();
+    lateTailBlocks_.reset();
+  }
+
+ private:
+  // IR の1区間を blockSize ごとに分けた一様分割の畳み込み (overlap-save)
+  class UniformConvolver {
+   public:
+    // ir の [begin, end) を畳み込む
+    UniformConvolver(const float* ir, size_t begin, size_t end,
+                     size_t blockSize);
+
+    size_t getBlockSize() const { return blockSize_; }
+    // frame: 直前と今回の入力ブロック (2 * blockSize)
+    // out: 区間との畳み込みのうち、今回のブロックの時刻の分 (blockSize)
+    void processBlock(const float* frame, float* out);
+    void clear();
+
+   private:
+    size_t blockSize_;
+    size_t numBins_;
+    size_t numPartitions_;
+    RealFft fft_;
+    // 区間のスペクトル [分割][ビン] (逆 FFT の正規化込み)
+    std::vector<float> filterRe_;
+    std::vector<float> filterIm_;
+    // 周波数領域遅延線 [スロット][ビン]。newest_ が最新の入力
+    std::vector<float> inputRe_;
+    std::vector<float> inputIm_;
+    size_t newest_ = 0;
+    std::vector<float> sumRe_;
+    std::vector<float> sumIm_;
+    std::vector<float> timeDomain_;
+  };
+
+  // process() の中で計算する段
+  struct Stage {
+    UniformConvolver convolver;
+    std::vector<float> frame;   // 直前と今回の入力ブロック
+    std::vector<float> output;  // 今回のブロックの出力
+  };
+
+  // numSamples は headSize_ のブロックの境目をまたがない
+  void processChunk(const float* input, float* wet, size_t numSamples);
+  void postTailBlock();
+  void waitForTail(uint32_t block);
+  // ワーカー (または同期モードでは process()) が block 番目の末尾を計算する
+  void processTailBlock(uint32_t block);
+  void tailWorkerLoop();
+
+  size_t length_;
+  size_t headSize_;
+  size_t tailBlockSize_;
+
+  // 先頭区間 (headSize_ サンプル、短い IR は0で埋める)
+  std::vector<float> head_;
+  // 直前と今回の入力ブロック (2 * headSize_)
+  std::vector<float> headFrame_;
+  std::vector<Stage> stages_;
+  std::vector<float> wet_;
+  // reset() からの経過サンプル数
+  uint64_t position_ = 0;
+
+  // 末尾区間 (IR が 2 * tailBlockSize_ 以下なら null)
+  std::unique_ptr<UniformConvolver> tail_;
+  // 入力と出力は2面ずつ。ブロック番号の偶奇で使い分ける
+  std::vector<float> tailInput_[2];
+  std::vector<float> tailOutput_[2];
+  // ワーカー専用の overlap-save フレーム
+  std::vector<float> tailFrame_;
+  // reset() の時点で渡し済みだったブロック数
+  uint32_t tailBase_ = 0;
+  bool backgroundTail_;
+
+  // 渡したブロック数と、計算が終わったブロック数
+  alignas(64) std::atomic<uint32_t> tailPosted_{0};
+  alignas(64) std::atomic<uint32_t> tailDone_{0};
+  std::atomic<bool> stop_{false};
+  std::thread worker_;
+
+  SmoothedParameter wetLevel_;
+
+  RelaxedCounter tailBlocks_;
+  RelaxedCounter lateTailBlocks_;
+};
+
+#endif  // CONVOLUTIONREVERB_H
@@ -1,65 +1,377 @@
 #pragma once
-#include <ring_buffer/ring_buffer.h>
-
-#include <exception>
-#include <iostream>
-#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
+#include "FloatArena.h"
+#include "RelaxedCounter.h"
+
+// 単一スレッド用のディレイライン
+// 2のべき乗長の float バッファを循環させ、インデックスはマスクで折り返す。
+// 書き込み位置と読み出し位置は単調増加するカウンタで、
+// (writeIndex_ - readIndex_) がバッファに溜まっているサンプル数になる。
+//
+// メモリ確保はコンストラクタでの一度だけ。構築後に呼べるメソッドはすべて
+// メモリ確保・ロック・I/O を行わない (オーディオスレッドから呼んでよい)。
+// 異常はカウンタに記録し、getStatus() で別スレッドから参照できる。
+//
+// arena を渡すとバッファをそこから切り出す (ReverbPool 用)。
+// アリーナが足りない場合は自前で確保する。
+//
+// readInterpolated で、書き込み位置から小数サンプルだけ遡った位置を
+// 補間して読める (LFO で遅延を揺らす変調タップ用)。
+// addTap で、読み出し位置を進めずに任意の遅延の位置を足し込める
+// (初期反射のマルチタップ用)。addAt はその逆で、書き込み済みの領域の
+// 任意の位置に足し込む (送り側のマルチタップ。共有バスのプリディレイ用)。
 class DelayLine {
  public:
-  // キャパシティは、バイト単位！ delaysample * sizeof(float)
-  DelayLine(int delaySamples, int capacity)
-      : rb(std::make_unique<Ring_Buffer>(capacity * sizeof(float))),
-        currentDelaySamples(delaySamples) {
+  // 小数の遅延を読むときの補間方法
+  enum class Interpolation {
+    Linear,    // 2点の線形補間。最も軽いが、高域がわずかに落ちる
+    Allpass,   // 1次オールパス補間。振幅は平坦だが、状態を持つ
+    Lagrange,  // 4点3次ラグランジュ補間
+  };
+
+  struct Status {
+    uint32_t underruns;      // 空のバッファから読み出そうとした回数
+    uint32_t overruns;       // 満杯のバッファに書き込もうとした回数
+    uint32_t clampedDelays;  // キャパシティを超える遅延長が指定された回数
+  };
+
+  // キャパシティはサンプル数。内部で2のべき乗に切り上げる
+  DelayLine(int delaySamples, int capacity, FloatArena* arena = nullptr)
+      : size_(requiredSize(delaySamples, capacity)),
+        buffer_(arena ? arena->allocate(size_) : nullptr),
+        mask_(size_ - 1),
+        writeIndex_(0),
+        readIndex_(0),
+        currentDelaySamples(std::max(delaySamples, 0)) {
+    if (buffer_ == nullptr) {
+      storage_.resize(size_);
+      buffer_ = storage_.data();
+    }
     clear();
   }
-  // キャパシティは、バイト単位！ delaysample * sizeof(float)
-  DelayLine(int delaySamples)
-      : currentDelaySamples(delaySamples),
-        rb(std::make_unique<Ring_Buffer>((delaySamples + 1) * sizeof(float))) {
-    clear();
+  DelayLine(int delaySamples) : DelayLine(delaySamples, delaySamples + 1) {}
+
+  // バッファは自身かアリーナが持つので、コピーはできない (ムーブは可)
+  DelayLine(const DelayLine&) = delete;
+  DelayLine& operator=(const DelayLine&) = delete;
+  DelayLine(DelayLine&&) = default;
+  DelayLine& operator=(DelayLine&&) = default;
+
+  // この遅延長・キャパシティで確保するバッファのサンプル数
+  static size_t requiredSize(int delaySamples, int capacity) {
+    return roundUpToPowerOfTwo(
+        std::max(capacity, std::max(delaySamples, 0) + 1));
   }
 
   void write(float sample) {
-    bool res = rb->put(sample);
-    if (!res) {
-      std::cout << "failed to write samples to rb" << std::endl;
+    if (writeIndex_ - readIndex_ >= size_) {
+      overruns_.increment();
+      return;
     }
+    buffer_[writeIndex_ & mask_] = sample;
+    ++writeIndex_;
   }
 
   float read() {
-    float sample;
-    if (rb->get(sample)) {
-      return sample;
-    } else {
-      std::cout << "failed to read sample" << std::endl;
+    if (writeIndex_ == readIndex_) {
+      underruns_.increment();
       return 0.;
     }
+    const float sample = buffer_[readIndex_ & mask_];
+    ++readIndex_;
+    return sample;
+  }
+
+  // ブロック単位の書き込み。折り返しがあっても高々2回の連続コピーで済む
+  void write(const float* samples, size_t numSamples) {
+    if (writeIndex_ - readIndex_ + numSamples > size_) {
+      overruns_.increment();
+      return;
+    }
+    const size_t pos = writeIndex_ & mask_;
+    const size_t first = std::min(numSamples, size_ - pos);
+    std::copy(samples, samples + first, buffer_ + pos);
+    std::copy(samples + first, samples + numSamples, buffer_);
+    writeIndex_ += numSamples;
+  }
+
+  // ブロック単位の読み出し。numSamples は遅延サンプル数以下であること
+  void read(float* samples, size_t numSamples) {
+    if (writeIndex_ - readIndex_ < numSamples) {
+      underruns_.increment();
+      std::fill(samples, samples + numSamples, 0.f);
+      return;
+    }
+    const size_t pos = readIndex_ & mask_;
+    const size_t first = std::min(numSamples, size_ - pos);
+    std::copy(buffer_ + pos, buffer_ + pos + first, samples);
+    std::copy(buffer_, buffer_ + (numSamples - first),
+              samples + first);
+    readIndex_ += numSamples;
+  }
+
+  // 書き込み位置から delay サンプル遡った位置のブロックに gain を掛けて
+  // samples に足す (マルチタップ用)。読み出し位置は進めないので、同じ
+  // ブロックについて何度でも呼べる。readInterpolated と同じく、この
+  // ブロックを write する前に呼ぶ。delay は [numSamples, getCapacity()]
+  void addTap(int delay, float gain, float* samples, size_t numSamples) const {
+    const size_t pos = (writeIndex_ - static_cast<size_t>(delay)) & mask_;
+    const size_t first = std::min(numSamples, size_ - pos);
+    const float* head = buffer_ + pos;
+    for (size_t i = 0; i < first; ++i) {
+      samples[i] += gain * head[i];
+    }
+    for (size_t i = first; i < numSamples; ++i) {
+      samples[i] += gain * buffer_[i - first];
+    }
+  }
+
+  // 読み出し位置から delay サンプル先のブロックに samples の gain 倍を
+  // 足し込む。次からの read で delay サンプル後に出てくるので、
+  // ソースごとに違う遅延を1本の遅延線で掛けられる (送り側のマルチタップ)。
+  // 足し込む位置は書き込み済みであること: delay + numSamples が
+  // バッファに溜まっているサンプル数以下 (超える分は足さない)
+  void addAt(int delay, float gain, const float* samples, size_t numSamples) {
+    const size_t stored = writeIndex_ - readIndex_;
+    const auto offset = static_cast<size_t>(std::max(delay, 0));
+    if (offset >= stored) {
+      return;
+    }
+    numSamples = std::min(numSamples, stored - offset);
+    const size_t pos = (readIndex_ + offset) & mask_;
+    const size_t first = std::min(numSamples, size_ - pos);
+    float* head = buffer_ + pos;
+    for (size_t i = 0; i < first; ++i) {
+      head[i] += gain * samples[i];
+    }
+    for (size_t i = first; i < numSamples; ++i) {
+      buffer_[i - first] += gain * samples[i];
+    }
+  }
+
+  // 無音を numSamples 書き込む (addAt で足し込む領域を用意する)
+  void writeSilence(size_t numSamples) {
+    if (writeIndex_ - readIndex_ + numSamples > size_) {
+      overruns_.increment();
+      return;
+    }
+    fillZeros(writeIndex_, numSamples);
+    writeIndex_ += numSamples;
+  }
+
+  // 小数の遅延でブロックを読み出す。i 番目のサンプルの遅延は
+  // delay + delayIncrement * (rampOffset + i)
+  // (LFO のセグメント内では遅延は直線になる。セグメントの途中から読むときは
+  // rampOffset にその位置を渡すと、区切り方によらず同じ遅延になる)。
+  // read と同じく読み出し位置を numSamples 進めるので、続けて
+  // write(samples, numSamples) を呼ぶ。遅延は
+  // [numSamples + 1, getCapacity() - 3] に丸める
+  // (ブロック内でまだ書いていない位置や、上書き済みの位置を読まないため)
+  void readInterpolated(float delay, float delayIncrement, float* samples,
+                        size_t numSamples, Interpolation interpolation,
+                        size_t rampOffset = 0) {
+    if (numSamples == 0) {
+      return;
+    }
+    if (writeIndex_ - readIndex_ < numSamples) {
+      underruns_.increment();
+      std::fill(samples, samples + numSamples, 0.f);
+      return;
+    }
+    const float maxDelay = std::max(static_cast<float>(size_) - 3.f, 1.f);
+    const float minDelay =
+        std::min(static_cast<float>(numSamples + 1), maxDelay);
+    // 位置は int にしてから float にする (size_t からの変換はベクトル化できない)
+    auto delayAt = [=](size_t i) {
+      const auto position = static_cast<int32_t>(rampOffset + i);
+      return std::clamp(delay + delayIncrement * static_cast<float>(position),
+                        minDelay, maxDelay);
+    };
+    // delay サンプル前の値 (ブロックの i 番目から見て)。
+    // samples への書き込みのたびにメンバを読み直さないよう、ローカルに置く
+    const float* buffer = buffer_;
+    const size_t mask = mask_;
+    const size_t w = writeIndex_;
+    auto tap = [buffer, mask, w](size_t i, size_t delay) {
+      return buffer[(w + i - delay) & mask];
+    };
+    // 遅延は直線なので、両端の整数部が同じならブロック全体で同じ。
+    // そのうえ読む範囲が折り返さなければ、連続した区間をそのまま読む
+    // (ベクトル化できる)。結果は1サンプルずつ読む場合と同じ
+    const size_t k = static_cast<uint32_t>(delayAt(0));
+    const bool sameK = k == static_cast<uint32_t>(delayAt(numSamples - 1));
+    const float kf = static_cast<float>(k);
+    auto linear = [](float f, float a, float b) { return a + f * (b - a); };
+    // 遅延 k - 1, k, k + 1, k + 2 の4点を通る3次式
+    auto lagrange = [](float f, float x0, float x1, float x2, float x3) {
+      const float fm1 = f - 1.0f;
+      const float fm2 = f - 2.0f;
+      const float fp1 = f + 1.0f;
+      return -f * fm1 * fm2 * (1.0f / 6.0f) * x0 +
+             fp1 * fm1 * fm2 * 0.5f * x1 - fp1 * f * fm2 * 0.5f * x2 +
+             fp1 * f * fm1 * (1.0f / 6.0f) * x3;
+    };
+    switch (interpolation) {
+      case Interpolation::Linear: {
+        // older[i] = tap(i, k + 1), older[i + 1] = tap(i, k)
+        const size_t start = (w - k - 1) & mask;
+        if (sameK && start + numSamples + 1 <= size_) {
+          const float* older = buffer + start;
+          for (size_t i = 0; i < numSamples; ++i) {
+            samples[i] = linear(delayAt(i) - kf, older[i + 1], older[i]);
+          }
+          break;
+        }
+        for (size_t i = 0; i < numSamples; ++i) {
+          const float d = delayAt(i);
+          const size_t di = static_cast<uint32_t>(d);
+          samples[i] = linear(d - static_cast<float>(di), tap(i, di),
+                              tap(i, di + 1));
+        }
+        break;
+      }
+      case Interpolation::Allpass: {
+        // y = eta * x[k] + x[k + 1] - eta * y[-1]。小数部を [0.5, 1.5) に
+        // 取ると eta が 0 付近に収まり、ナイキスト付近で鳴かない。
+        // 前の出力に依存するので1サンプルずつ処理する
+        float state = allpassState_;
+        for (size_t i = 0; i < numSamples; ++i) {
+          const float d = delayAt(i);
+          const size_t di = static_cast<uint32_t>(d - 0.5f);
+          const float f = d - static_cast<float>(di);
+          const float eta = (1.0f - f) / (1.0f + f);
+          state = eta * (tap(i, di) - state) + tap(i, di + 1);
+          samples[i] = state;
+        }
+        allpassState_ = state;
+        break;
+      }
+      case Interpolation::Lagrange: {
+        // older[i + 3 - j] = tap(i, k - 1 + j)
+        const size_t start = (w - k - 2) & mask;
+        if (sameK && start + numSamples + 3 <= size_) {
+          const float* older = buffer + start;
+          for (size_t i = 0; i < numSamples; ++i) {
+            samples[i] = lagrange(delayAt(i) - kf, older[i + 3],
+                                  older[i + 2], older[i + 1], older[i]);
+          }
+          break;
+        }
+        for (size_t i = 0; i < numSamples; ++i) {
+          const float d = delayAt(i);
+          const size_t di = static_cast<uint32_t>(d);
+          samples[i] =
+              lagrange(d - static_cast<float>(di), tap(i, di - 1),
+                       tap(i, di), tap(i, di + 1), tap(i, di + 2));
+        }
+        break;
+      }
+    }
+    readIndex_ += numSamples;
+  }
+
+  // 純粋な遅延として処理する: output[i] = input[i - delaySamples]
+  // 遅延長より長いブロックは遅延長ごとに分割して read -> write する
+  void process(const float* input, float* output, size_t numSamples) {
+    const size_t maxChunk =
+        static_cast<size_t>(std::max(currentDelaySamples, 1));
+    while (numSamples > 0) {
+      const size_t n = std::min(numSamples, maxChunk);
+      read(output, n);
+      write(input, n);
+      input += n;
+      output += n;
+      numSamples -= n;
+    }
+  }
+
+  int getDelaySamples() const { return currentDelaySamples; }
+  int getCapacity() const { return static_cast<int>(size_); }
+
+  Status getStatus() const {
+    return {underruns_.load(), overruns_.load(), clampedDelays_.load()};
+  }
+  void resetStatus() {
+    underruns_.reset();
+    overruns_.reset();
+    clampedDelays_.reset();
   }
+
+  // 遅延を短くする場合は古いサンプルを捨て、長くする場合は無音を追加する
+  // キャパシティに収まらない遅延長は収まる最大値に丸める
   void updateDelaySample(int newDelaySamples) {
+    newDelaySamples = clampDelay(newDelaySamples);
     if (currentDelaySamples > newDelaySamples) {
-      rb->discard((size_t)(currentDelaySamples - newDelaySamples));
+      const size_t discard =
+          static_cast<size_t>(currentDelaySamples - newDelaySamples);
+      readIndex_ += std::min(discard, writeIndex_ - readIndex_);
     } else {
-      std::vector<float> zeros(newDelaySamples - currentDelaySamples, 0.f);
-      rb->put(zeros.data(), zeros.size());
+      size_t count =
+          static_cast<size_t>(newDelaySamples - currentDelaySamples);
+      const size_t room = size_ - (writeIndex_ - readIndex_);
+      if (count > room) {
+        overruns_.increment();
+        count = room;
+      }
+      fillZeros(writeIndex_, count);
+      writeIndex_ += count;
     }
     currentDelaySamples = newDelaySamples;
   }
   void clear() {
-    if (rb->size_used() > 0) {
-      bool res = rb->discard(rb->size_used());
-    }
-    std::vector<float> zeros(currentDelaySamples, 0.f);
-
-    rb->put(zeros.data(), zeros.size());
+    std::fill(buffer_, buffer_ + size_, 0.f);
+    allpassState_ = 0.f;
+    readIndex_ = 0;
+    writeIndex_ = static_cast<size_t>(currentDelaySamples);
   }
+  // 確保済みのバッファを再利用して、新しい遅延長で無音から始め直す
   void reset(int newDelaySamples) {
-    rb = std::make_unique<Ring_Buffer>((newDelaySamples + 1) * sizeof(float));
+    currentDelaySamples = clampDelay(newDelaySamples);
+    clear();
   }
 
  private:
-  // 固定長リングバッファ
-  std::unique_ptr<Ring_Buffer> rb;
+  int clampDelay(int delaySamples) {
+    // 読み出し前に書き込みを1つ受け付ける余地を残す
+    const int maxDelay = static_cast<int>(size_) - 1;
+    if (delaySamples > maxDelay) {
+      clampedDelays_.increment();
+      return maxDelay;
+    }
+    return std::max(delaySamples, 0);
+  }
+
+  // 書き込み位置 start から count サンプルを無音で埋める
+  void fillZeros(size_t start, size_t count) {
+    const size_t pos = start & mask_;
+    const size_t first = std::min(count, size_ - pos);
+    std::fill_n(buffer_ + pos, first, 0.f);
+    std::fill_n(buffer_, count - first, 0.f);
+  }
+
+  static size_t roundUpToPowerOfTwo(int n) {
+    size_t size = 1;
+    while (size < static_cast<size_t>(std::max(n, 1))) {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  // 2のべき乗長の循環バッファ (storage_ かアリーナ上の領域を指す)
+  std::vector<float> storage_;
+  size_t size_;
+  float* buffer_;
+  size_t mask_;
+  size_t writeIndex_;
+  size_t readIndex_;
   int currentDelaySamples;
-};
\ No newline at end of file
+  float allpassState_ = 0.f;  // オールパス補間の直前の出力
+
+  RelaxedCounter underruns_;
+  RelaxedCounter overruns_;
+  RelaxedCounter clampedDelays_;
+};
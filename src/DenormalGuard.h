@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#include <immintrin.h>
+#define DENORMALGUARD_X86 1
+#elif defined(__aarch64__)
+#define DENORMALGUARD_ARM64 1
+#endif
+
+// スコープの間だけ非正規化数 (denormal) を0として扱う
+//
+// フィードバックのあるフィルタは入力が止まると状態が指数的に小さくなり、
+// いずれ非正規化数になる。x86 では非正規化数の演算がマイクロコードで
+// 処理され、10-100倍遅くなる (無音のバスで CPU 使用率が跳ね上がる)。
+//   x86:     MXCSR の FTZ (結果を0に) と DAZ (入力を0とみなす) を立てる
+//   AArch64: FPCR の FZ を立てる
+//   その他:  何もしない (状態を0に丸める側の対策に任せる)
+// 既にフラグが立っていれば何もしないので、ネストしても安い。
+// フラグはスレッドごとなので、ブロック処理の入口で作る。
+class DenormalGuard {
+ public:
+  DenormalGuard() {
+#if defined(DENORMALGUARD_X86)
+    saved_ = _mm_getcsr();
+    if ((saved_ & kFlushFlags) != kFlushFlags) {
+      _mm_setcsr(saved_ | kFlushFlags);
+      changed_ = true;
+    }
+#elif defined(DENORMALGUARD_ARM64)
+    uint64_t fpcr;
+    asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+    saved_ = fpcr;
+    if ((fpcr & kFlushFlags) == 0) {
+      asm volatile("msr fpcr, %0" : : "r"(fpcr | kFlushFlags));
+      changed_ = true;
+    }
+#endif
+  }
+
+  ~DenormalGuard() {
+#if defined(DENORMALGUARD_X86)
+    if (changed_) {
+      _mm_setcsr(saved_);
+    }
+#elif defined(DENORMALGUARD_ARM64)
+    if (changed_) {
+      asm volatile("msr fpcr, %0" : : "r"(saved_));
+    }
+#endif
+  }
+
+  DenormalGuard(const DenormalGuard&) = delete;
+  DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+  // 非正規化数を0にする。ガードが効かない環境でも、ブロックの終わりに
+  // フィルタの状態をこれで丸めれば、フィードバックで非正規化数が
+  // 生き残らない (ガードが効いていれば何も変わらない)
+  static float flushState(float x) {
+    constexpr float kMin = std::numeric_limits<float>::min();
+    return (x > -kMin && x < kMin) ? 0.0f : x;
+  }
+
+ private:
+#if defined(DENORMALGUARD_X86)
+  static constexpr unsigned kFlushFlags = 0x8040;  // FTZ | DAZ
+  unsigned saved_ = 0;
+#elif defined(DENORMALGUARD_ARM64)
+  static constexpr uint64_t kFlushFlags = uint64_t{1} << 24;  // FZ
+  uint64_t saved_ = 0;
+#endif
+  bool changed_ = false;
+};
@@ -0,0 +1,138 @@
+#include "EffectChain.h"
+
+#include <algorithm>
+
+// --- BufferPool ---
+BufferPool::BufferPool(size_t numBuffers, size_t blockSize)
+    : blockSize_(std::max<size_t>(blockSize, 1)),
+      arena_(numBuffers * FloatArena::alignedSize(blockSize_)) {
+  free_.reserve(numBuffers);
+  for (size_t i = 0; i < numBuffers; ++i) {
+    free_.push_back(arena_.allocate(blockSize_));
+  }
+  // 先頭のバッファから払い出す
+  std::reverse(free_.begin(), free_.end());
+}
+
+float* BufferPool::acquire() {
+  if (free_.empty()) {
+    return nullptr;
+  }
+  float* buffer = free_.back();
+  free_.pop_back();
+  return buffer;
+}
+
+// --- EffectChain ---
+void EffectChain::process(const float* input, float* output,
+                          size_t numSamples) {
+  if (nodes_.empty()) {
+    if (input != output) {
+      std::copy_n(input, numSamples, output);
+    }
+    return;
+  }
+  // 最初のノードが input -> output、以降は output の上で処理する
+  nodes_[0]->process(input, output, numSamples);
+  for (size_t i = 1; i < nodes_.size(); ++i) {
+    nodes_[i]->process(output, output, numSamples);
+  }
+}
+
+void EffectChain::reset() {
+  for (AudioEffect* node : nodes_) {
+    node->reset();
+  }
+}
+
+// --- EffectParallel ---
+void EffectParallel::process(const float* input, float* output,
+                             size_t numSamples) {
+  float* branchOutput = pool_->acquire();
+  float* sum = pool_->acquire();
+  if (sum == nullptr) {
+    if (branchOutput != nullptr) {
+      pool_->release(branchOutput);
+    }
+    starvedBlocks_.increment();
+    std::fill_n(output, numSamples, 0.0f);
+    return;
+  }
+
+  const size_t blockSize = pool_->getBlockSize();
+  while (numSamples > 0) {
+    const size_t n = std::min(numSamples, blockSize);
+    std::fill_n(sum, n, 0.0f);
+    // 枝の出力は input と別のバッファに書くので、input == output でも
+    // 全ての枝が同じ入力を読む
+    for (const Branch& branch : branches_) {
+      branch.effect->process(input, branchOutput, n);
+      for (size_t i = 0; i < n; ++i) {
+        sum[i] += branch.gain * branchOutput[i];
+      }
+    }
+    std::copy_n(sum, n, output);
+    input += n;
+    output += n;
+    numSamples -= n;
+  }
+  pool_->release(sum);
+  pool_->release(branchOutput);
+}
+
+void EffectParallel::reset() {
+  for (const Branch& branch : branches_) {
+    branch.effect->reset();
+  }
+}
+
+// --- EffectBus ---
+EffectBus::EffectBus(AudioEffect& effect, size_t maxBlockSize)
+    : effect_(&effect), input_(maxBlockSize, 0.0f), wet_(maxBlockSize, 0.0f) {}
+
+void EffectBus::send(const float* input, float gain, size_t numSamples,
+                     size_t offset) {
+  if (offset >= input_.size()) {
+    return;
+  }
+  const size_t n = std::min(numSamples, input_.size() - offset);
+  float* bus = input_.data() + offset;
+  for (size_t i = 0; i < n; ++i) {
+    bus[i] += gain * input[i];
+  }
+  pending_ = std::max(pending_, offset + n);
+}
+
+void EffectBus::processReturn(float* output, size_t numSamples,
+                              float returnGain) {
+  const size_t n = std::min(numSamples, input_.size());
+  // センドがなくても、残響の続きを出すためにエフェクトは毎ブロック通す
+  effect_->process(input_.data(), wet_.data(), n);
+  for (size_t i = 0; i < n; ++i) {
+    output[i] += returnGain * wet_[i];
+  }
+  std::fill_n(input_.begin(), pending_, 0.0f);
+  pending_ = 0;
+  ++blockIndex_;
+}
+
+void EffectBus::reset() {
+  effect_->reset();
+  std::fill_n(input_.begin(), pending_, 0.0f);
+  pending_ = 0;
+  ++blockIndex_;
+}
+
+// --- EffectSend ---
+void EffectSend::process(const float* input, float* output,
+                         size_t numSamples) {
+  if (bus_->getBlockIndex() != blockIndex_) {
+    blockIndex_ = bus_->getBlockIndex();
+    offset_ = 0;
+  }
+  bus_->send(input, gain_, numSamples, offset_);
+  offset_ += numSamples;
+  if (input != output) {
+    std::copy_n(input, numSamples, output);
+  }
+}
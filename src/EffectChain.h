@@ -0,0 +1,181 @@
+#ifndef EFFECTCHAIN_H
+#define EFFECTCHAIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "AudioEffect.h"
+#include "FloatArena.h"
+#include "RelaxedCounter.h"
+
+// AudioEffect を組み合わせるエフェクトグラフ
+//
+//   EffectChain:    直列。ノードを順に in-place で通す
+//   EffectParallel: 並列。各枝に同じ入力を通し、ゲインを掛けて足す
+//   EffectBus / EffectSend: 共有バスへのセンドとリターン
+//                   (複数のチェーンから1つのリバーブへ送るなど)
+// どれも AudioEffect なので、入れ子にできる。仮想呼び出しはノードごとに
+// ブロック1回。ノードの間の作業バッファは BufferPool から借りるので、
+// process() はメモリ確保をしない (グラフの組み立ては音声スレッドの外で行う)。
+
+// 同じ長さの作業バッファを前もって確保しておくプール
+// acquire / release はスタックの出し入れだけで、メモリ確保をしない。
+class BufferPool {
+ public:
+  BufferPool(size_t numBuffers, size_t blockSize);
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  // blockSize 個の float のバッファ (中身は不定)。空きがなければ nullptr
+  float* acquire();
+  // acquire と逆の順に返す
+  void release(float* buffer) { free_.push_back(buffer); }
+
+  size_t getBlockSize() const { return blockSize_; }
+  size_t getNumFree() const { return free_.size(); }
+
+ private:
+  size_t blockSize_;
+  FloatArena arena_;
+  std::vector<float*> free_;  // 末尾から取り出す
+};
+
+// 直列のチェーン。空なら入力をそのまま出す
+class EffectChain final : public AudioEffect {
+ public:
+  // effect はチェーンより長く生存させる
+  void add(AudioEffect& effect) { nodes_.push_back(&effect); }
+  // チェーンが持つノードを作って末尾に加える
+  template <typename Effect, typename... Args>
+  Effect& emplace(Args&&... args) {
+    auto effect = std::make_unique<Effect>(std::forward<Args>(args)...);
+    Effect& ref = *effect;
+    owned_.push_back(std::move(effect));
+    add(ref);
+    return ref;
+  }
+
+  void process(const float* input, float* output,
+               size_t numSamples) override;
+  void reset() override;
+
+  size_t size() const { return nodes_.size(); }
+
+ private:
+  std::vector<AudioEffect*> nodes_;
+  std::vector<std::unique_ptr<AudioEffect>> owned_;
+};
+
+// 並列の枝。出力は sum(gain_i * branch_i(input))
+//
+// 処理中は pool から2本 (枝の出力と総和) を借り、入れ子の EffectParallel は
+// さらに2本ずつ借りる。ブロックは pool のブロック長ごとに分けて処理する。
+// 借りられなかったブロックは無音を出し、starvedBlocks に数える
+// (pool の本数は入れ子の深さ x 2 以上にする)。
+class EffectParallel final : public AudioEffect {
+ public:
+  struct Stats {
+    uint32_t starvedBlocks;  // バッファが借りられず無音を出した回数
+  };
+
+  explicit EffectParallel(BufferPool& pool) : pool_(&pool) {}
+
+  void addBranch(AudioEffect& effect, float gain = 1.0f) {
+    branches_.push_back({&effect, gain});
+  }
+  template <typename Effect, typename... Args>
+  Effect& emplaceBranch(float gain, Args&&... args) {
+    auto effect = std::make_unique<Effect>(std::forward<Args>(args)...);
+    Effect& ref = *effect;
+    owned_.push_back(std::move(effect));
+    addBranch(ref, gain);
+    return ref;
+  }
+  // 音声スレッドから (process の合間に) 呼ぶ
+  void setBranchGain(size_t branch, float gain) {
+    branches_[branch].gain = gain;
+  }
+
+  void process(const float* input, float* output,
+               size_t numSamples) override;
+  void reset() override;
+
+  size_t getNumBranches() const { return branches_.size(); }
+  Stats getStats() const { return {starvedBlocks_.load()}; }
+  void resetStats() { starvedBlocks_.reset(); }
+
+ private:
+  struct Branch {
+    AudioEffect* effect;
+    float gain;
+  };
+
+  BufferPool* pool_;
+  std::vector<Branch> branches_;
+  std::vector<std::unique_ptr<AudioEffect>> owned_;
+  RelaxedCounter starvedBlocks_;
+};
+
+// 共有バス。EffectSend が入力を足し込み、全てのセンドの後に
+// processReturn() がバスのエフェクトを1回だけ通して出力に足す。
+// 1ブロックの手順:
+//   1. 各ソースのチェーンを処理する (中の EffectSend がバスに足す)
+//   2. bus.processReturn(mix, numSamples)
+// センドと processReturn の numSamples は同じにし、maxBlockSize 以下にする
+// (超えた分はバスに送らない)。
+class EffectBus {
+ public:
+  // effect はバスより長く生存させる。ふつうは wet だけを出す設定にする
+  // (Reverb なら setWetLevel(1.0f))
+  EffectBus(AudioEffect& effect, size_t maxBlockSize);
+
+  // input * gain をバスの入力の offset サンプル目から足す
+  void send(const float* input, float gain, size_t numSamples,
+            size_t offset = 0);
+  // バスの入力をエフェクトに通して output に returnGain 倍で足し、
+  // バスの入力を空にする
+  void processReturn(float* output, size_t numSamples,
+                     float returnGain = 1.0f);
+  void reset();
+
+  size_t getMaxBlockSize() const { return input_.size(); }
+  // processReturn / reset のたびに進む番号 (EffectSend がブロックの
+  // 区切りを知るのに使う)
+  uint64_t getBlockIndex() const { return blockIndex_; }
+
+ private:
+  AudioEffect* effect_;
+  std::vector<float> input_;  // センドの総和
+  std::vector<float> wet_;    // エフェクトの出力
+  size_t pending_ = 0;        // 今のブロックで input_ に足した長さ
+  uint64_t blockIndex_ = 0;
+};
+
+// チェーンの途中に置くセンド。信号はそのまま通し、gain 倍をバスに送る。
+// EffectParallel の中でブロックが分けられても、同じブロックの続きは
+// バスの続きの位置に足す
+class EffectSend final : public AudioEffect {
+ public:
+  EffectSend(EffectBus& bus, float gain) : bus_(&bus), gain_(gain) {}
+
+  void process(const float* input, float* output,
+               size_t numSamples) override;
+  void reset() override { offset_ = 0; }
+
+  // 音声スレッドから (process の合間に) 呼ぶ
+  void setGain(float gain) { gain_ = gain; }
+  float getGain() const { return gain_; }
+
+ private:
+  EffectBus* bus_;
+  float gain_;
+  // 今のバスのブロックと、その中で送った長さ
+  uint64_t blockIndex_ = UINT64_MAX;
+  size_t offset_ = 0;
+};
+
+#endif  // EFFECTCHAIN_H
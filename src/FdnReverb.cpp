@@ -0,0 +1,304 @@
+#include "FdnReverb.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#include "DenormalGuard.h"
+#include "ReverbTuning.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define FDNREVERB_SSE2 1
+#include <immintrin.h>
+#endif
+
+using namespace reverb_tuning;
+
+namespace {
+// 遅延線の最大遅延 (最も長い遅延時間)
+constexpr float kMaxFdnDelayTime =
+    *std::max_element(std::begin(kFdnDelayTimes), std::end(kFdnDelayTimes));
+}  // namespace
+
+FdnReverb::FdnReverb(float sampleRate, size_t numLines)
+    : sampleRate_(sampleRate),
+      numLines_(std::bit_floor(std::clamp(numLines, kMinLines, kMaxLines))),
+      wetLevel_(kDefaultWetLevel, smoothingSamples(sampleRate)),
+      decay_(kDefaultDecay, smoothingSamples(sampleRate)),
+      damping_(kDefaultDamping, smoothingSamples(sampleRate)) {
+  const int capacity = delaySamples(sampleRate_, kMaxFdnDelayTime) + 1;
+  lines_.reserve(numLines_);
+  int minDelay = capacity;
+  for (size_t i = 0; i < numLines_; ++i) {
+    const int delay =
+        std::max(delaySamples(sampleRate_, kFdnDelayTimes[i]), 1);
+    lines_.emplace_back(delay, capacity);
+    minDelay = std::min(minDelay, delay);
+  }
+  maxChunk_ = std::min(kChunkSize, static_cast<size_t>(minDelay));
+
+  reset();
+}
+
+float FdnReverb::process(float sample) {
+  float output;
+  process(&sample, &output, 1);
+  return output;
+}
+
+void FdnReverb::process(const float* input, float* output,
+                        size_t numSamples) {
+  const DenormalGuard denormalGuard;
+  wetLevel_.pollTarget();
+  decay_.pollTarget();
+  damping_.pollTarget();
+  float wet[kChunkSize];
+
+  while (numSamples > 0) {
+    // decay / damping の変化中は、ランプの段の境目でも区切る
+    const size_t n = std::min(
+        {numSamples, maxChunk_,
+         decay_.samplesUntilNextStep(kSmoothingStepSize),
+         damping_.samplesUntilNextStep(kSmoothingStepSize)});
+    updateLineParameters();
+
+    switch (numLines_) {
+      case 4:
+        processChunk<4>(input, wet, n);
+        break;
+      case 8:
+        processChunk<8>(input, wet, n);
+        break;
+      default:
+        processChunk<16>(input, wet, n);
+        break;
+    }
+    decay_.advance(n);
+    damping_.advance(n);
+
+    if (wetLevel_.isRamping()) {
+      for (size_t i = 0; i < n; ++i) {
+        const float wetLevel = wetLevel_.advance(1);
+        output[i] = ((1.0f - wetLevel) * input[i]) + (wetLevel * wet[i]);
+      }
+    } else {
+      const float wetLevel = wetLevel_.getCurrent();
+      const float dryLevel = 1.0f - wetLevel;
+      for (size_t i = 0; i < n; ++i) {
+        output[i] = (dryLevel * input[i]) + (wetLevel * wet[i]);
+      }
+    }
+
+    input += n;
+    output += n;
+    numSamples -= n;
+  }
+}
+
+// 線の数をテンプレート引数にして、線方向のループを展開する
+// (ダンピングの状態がレジスタに載り、butterfly の段も定数回になる)
+template <size_t NumLines>
+void FdnReverb::processChunk(const float* input, float* wet,
+                             size_t numSamples) {
+  for (size_t l = 0; l < NumLines; ++l) {
+    lines_[l].read(block_[l], numSamples);
+  }
+#if defined(FDNREVERB_SSE2)
+  processLinesSse2<NumLines>(input, wet, numSamples);
+#else
+  processLinesScalar<NumLines>(input, wet, numSamples);
+#endif
+  for (size_t l = 0; l < NumLines; ++l) {
+    lines_[l].write(block_[l], numSamples);
+  }
+}
+
+// 入力はそのまま全ての線に足し、出力は符号を交互に変えて全ての線から
+// 取って 1/sqrt(N) で正規化する (Reverb と同程度の残響の音量になる)
+
+// --- スカラー版 (基準実装) ---
+template <size_t NumLines>
+void FdnReverb::processLinesScalar(const float* input, float* wet,
+                                   size_t numSamples) {
+  const float outputGain = 1.0f / std::sqrt(static_cast<float>(NumLines));
+  const float damping = lineDamping_;
+  for (size_t i = 0; i < numSamples; ++i) {
+    float v[NumLines];
+    float out = 0.0f;
+    for (size_t l = 0; l < NumLines; ++l) {
+      // ダンピング (1次ローパス)
+      store_[l] = block_[l][i] * (1.0f - damping) + store_[l] * damping;
+      v[l] = store_[l];
+      out += (l % 2 == 0) ? outputGain * v[l] : -outputGain * v[l];
+    }
+    wet[i] = out;
+
+    // 高速ウォルシュ・アダマール変換。段ごとに、span 離れた2本の線を
+    // (a + b, a - b) に置き換える。正規化 (1/sqrt(N)) は gain_ に含める
+    for (size_t span = 1; span < NumLines; span *= 2) {
+      for (size_t base = 0; base < NumLines; base += 2 * span) {
+        for (size_t l = base; l < base + span; ++l) {
+          const float a = v[l];
+          const float b = v[l + span];
+          v[l] = a + b;
+          v[l + span] = a - b;
+        }
+      }
+    }
+
+    for (size_t l = 0; l < NumLines; ++l) {
+      block_[l][i] = gain_[l] * v[l] + input[i];
+    }
+  }
+}
+
+// --- SSE2 版 ---
+// block_ の [線][サンプル] を 4x4 ずつ転置して [サンプル][線] の frames_ に
+// 並べ、1サンプルの線を 4本ずつレジスタに載せて処理する。
+// ダンピングは全ての線を同時に進め、アダマール変換の span 1, 2 の段は
+// レジスタ内のシャッフル、span 4 以上の段はレジスタ同士の足し引きになる。
+// 終わったら転置して block_ に戻す。
+#if defined(FDNREVERB_SSE2)
+template <size_t NumLines>
+void FdnReverb::processLinesSse2(const float* input, float* wet,
+                                 size_t numSamples) {
+  constexpr size_t kGroups = NumLines / 4;
+  // 転置は4サンプル単位 (block_ は kChunkSize まであるので、はみ出しても
+  // 読み書きできる。はみ出した分は遅延線に書かない)
+  const size_t padded = (numSamples + 3) / 4 * 4;
+  auto transpose = [](const float* in[4], float* out[4]) {
+    __m128 r0 = _mm_load_ps(in[0]);
+    __m128 r1 = _mm_load_ps(in[1]);
+    __m128 r2 = _mm_load_ps(in[2]);
+    __m128 r3 = _mm_load_ps(in[3]);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_store_ps(out[0], r0);
+    _mm_store_ps(out[1], r1);
+    _mm_store_ps(out[2], r2);
+    _mm_store_ps(out[3], r3);
+  };
+  for (size_t g = 0; g < kGroups; ++g) {
+    for (size_t i = 0; i < padded; i += 4) {
+      const float* rows[4] = {block_[4 * g] + i, block_[4 * g + 1] + i,
+                              block_[4 * g + 2] + i, block_[4 * g + 3] + i};
+      float* frames[4] = {frames_[i] + 4 * g, frames_[i + 1] + 4 * g,
+                          frames_[i + 2] + 4 * g, frames_[i + 3] + 4 * g};
+      transpose(rows, frames);
+    }
+  }
+
+  const float outputGain = 1.0f / std::sqrt(static_cast<float>(NumLines));
+  const __m128 damping = _mm_set1_ps(lineDamping_);
+  const __m128 feed = _mm_set1_ps(1.0f - lineDamping_);
+  // span 1, 2 の butterfly: v * sign + (隣と入れ替えた v)
+  const __m128 sign1 = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+  const __m128 sign2 = _mm_setr_ps(1.0f, 1.0f, -1.0f, -1.0f);
+  __m128 store[kGroups];
+  __m128 gain[kGroups];
+  for (size_t g = 0; g < kGroups; ++g) {
+    store[g] = _mm_loadu_ps(store_ + 4 * g);
+    gain[g] = _mm_loadu_ps(gain_ + 4 * g);
+  }
+
+  // 出力タップ (符号が交互の和) は、span 1 の段の後の奇数レーン
+  // (a0 - a1, a2 - a3) の和なので、その段の結果を足しておいて後で取り出す
+  alignas(16) float taps[kChunkSize][4];
+  for (size_t i = 0; i < numSamples; ++i) {
+    float* frame = frames_[i];
+    __m128 v[kGroups];
+    __m128 tap = _mm_setzero_ps();
+    for (size_t g = 0; g < kGroups; ++g) {
+      store[g] = _mm_add_ps(_mm_mul_ps(_mm_load_ps(frame + 4 * g), feed),
+                            _mm_mul_ps(store[g], damping));
+      v[g] = _mm_add_ps(_mm_mul_ps(store[g], sign1),
+                        _mm_shuffle_ps(store[g], store[g],
+                                       _MM_SHUFFLE(2, 3, 0, 1)));
+      tap = _mm_add_ps(tap, v[g]);
+      v[g] = _mm_add_ps(_mm_mul_ps(v[g], sign2),
+                        _mm_shuffle_ps(v[g], v[g], _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+    _mm_store_ps(taps[i], tap);
+    // span 4, 8 の段はグループ同士の butterfly (展開されるよう明示的に書く)
+    auto butterfly = [&v](size_t a, size_t b) {
+      const __m128 sum = _mm_add_ps(v[a], v[b]);
+      v[b] = _mm_sub_ps(v[a], v[b]);
+      v[a] = sum;
+    };
+    if constexpr (kGroups >= 2) {
+      for (size_t g = 0; g < kGroups; g += 2) {
+        butterfly(g, g + 1);
+      }
+    }
+    if constexpr (kGroups >= 4) {
+      butterfly(0, 2);
+      butterfly(1, 3);
+    }
+
+    const __m128 x = _mm_set1_ps(input[i]);
+    for (size_t g = 0; g < kGroups; ++g) {
+      _mm_store_ps(frame + 4 * g, _mm_add_ps(_mm_mul_ps(gain[g], v[g]), x));
+    }
+  }
+  for (size_t g = 0; g < kGroups; ++g) {
+    _mm_storeu_ps(store_ + 4 * g, store[g]);
+  }
+  for (size_t i = 0; i < numSamples; ++i) {
+    wet[i] = outputGain * (taps[i][1] + taps[i][3]);
+  }
+
+  for (size_t g = 0; g < kGroups; ++g) {
+    for (size_t i = 0; i < padded; i += 4) {
+      const float* frames[4] = {frames_[i] + 4 * g, frames_[i + 1] + 4 * g,
+                                frames_[i + 2] + 4 * g,
+                                frames_[i + 3] + 4 * g};
+      float* rows[4] = {block_[4 * g] + i, block_[4 * g + 1] + i,
+                        block_[4 * g + 2] + i, block_[4 * g + 3] + i};
+      transpose(frames, rows);
+    }
+  }
+}
+#endif
+
+void FdnReverb::reset() {
+  for (auto& line : lines_) {
+    line.clear();
+  }
+  std::fill(std::begin(store_), std::end(store_), 0.0f);
+  // 無音から始めるので、パラメータはランプせずに目標値へ切り替える
+  wetLevel_.snap();
+  decay_.snap();
+  damping_.snap();
+  applyLineParameters(decay_.getCurrent(), damping_.getCurrent());
+}
+
+void FdnReverb::setWetLevel(float level) {
+  wetLevel_.setTarget(std::clamp(level, 0.0f, 1.0f));
+}
+
+void FdnReverb::setDecay(float decay) {
+  decay_.setTarget(std::clamp(decay, 0.0f, 1.0f));
+}
+
+void FdnReverb::setDamping(float damping) {
+  damping_.setTarget(std::clamp(damping, 0.0f, 1.0f));
+}
+
+void FdnReverb::updateLineParameters() {
+  const float decay = decay_.getSteppedValue(kSmoothingStepSize);
+  const float damping = damping_.getSteppedValue(kSmoothingStepSize);
+  if (decay != lineDecay_ || damping != lineDamping_) {
+    applyLineParameters(decay, damping);
+  }
+}
+
+void FdnReverb::applyLineParameters(float decay, float damping) {
+  // アダマール行列の正規化もここで掛けておく
+  const float normalize = 1.0f / std::sqrt(static_cast<float>(numLines_));
+  for (size_t l = 0; l < numLines_; ++l) {
+    const float delayTime =
+        static_cast<float>(lines_[l].getDelaySamples()) / sampleRate_;
+    gain_[l] = fdnLineGain(decay, delayTime) * normalize;
+  }
+  lineDecay_ = decay;
+  lineDamping_ = damping;
+}
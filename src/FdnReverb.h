@@ -0,0 +1,101 @@
+#ifndef FDNREVERB_H
+#define FDNREVERB_H
+
+#include <cstddef>
+#include <vector>
+
+#include "DelayLine.h"
+#include "SmoothedParameter.h"
+
+// フィードバック・ディレイ・ネットワーク (FDN) リバーブ
+//
+//   x ──┬──> (+) ──> [遅延線 i] ──> [ダンピング] ──┬──> 出力タップ ──> wet
+//       │     ^                                    │
+//       │     └──── gain_i <── [アダマール行列] <──┘ (全ての線を混ぜる)
+//
+// 並列コム (Reverb) と違い、線の出力を直交行列で混ぜて全ての線に戻すので、
+// 少ない線でもエコーの密度がすぐに上がる。
+// 行列は正規化したアダマール行列で、高速ウォルシュ・アダマール変換
+// (O(N log N) の butterfly) で掛ける。
+//
+// ブロックは最短の遅延以下のチャンクに分けて処理する。チャンク内の
+// フィードバックは次のチャンク以降にしか届かないので、全ての線から
+// チャンクを読み出し、計算してから書き込めばよい。
+// x86 では読み出したチャンクを転置し、1サンプル分の線を SIMD レジスタに
+// 並べて、ダンピングと行列を4本ずつ同時に計算する (それ以外はスカラー版)。
+//
+// 各線のダンピングは CombFilter と同じ1次ローパス:
+//   store = delayed * (1 - damping) + store * damping
+// decay は Reverb のコムフィルタと同じ残響時間になるよう、
+// 線の長さに応じたゲインに換算する (reverb_tuning::fdnLineGain)。
+//
+// process / reset / setWetLevel / setDecay / setDamping は Reverb と同じ
+// 使い方で、パラメータは別スレッドから設定してよい (ランプで追従する)。
+class FdnReverb {
+ public:
+  static constexpr size_t kMinLines = 4;
+  static constexpr size_t kMaxLines = 16;
+
+  // numLines は [kMinLines, kMaxLines] の2のべき乗に切り下げる
+  FdnReverb(float sampleRate, size_t numLines = 8);
+
+  // 遅延線はコピーできないので、ムーブのみ
+  FdnReverb(const FdnReverb&) = delete;
+  FdnReverb& operator=(const FdnReverb&) = delete;
+  FdnReverb(FdnReverb&&) = default;
+  FdnReverb& operator=(FdnReverb&&) = default;
+
+  float process(float sample);
+  // ブロック処理。input と output は同じバッファでもよい
+  void process(const float* input, float* output, size_t numSamples);
+  void reset();
+
+  void setWetLevel(float level);   // 0.0 (dry) to 1.0 (wet)
+  void setDecay(float decay);      // 0.0 (short) to 1.0 (long)
+  void setDamping(float damping);  // 0.0 (bright) to 1.0 (dark)
+
+  size_t getNumLines() const { return numLines_; }
+  int getDelaySamples(size_t line) const {
+    return lines_[line].getDelaySamples();
+  }
+
+ private:
+  // 一度に処理する最大サンプル数 (作業領域の長さ)
+  static constexpr size_t kChunkSize = 64;
+
+  // numSamples は maxChunk_ 以下。NumLines は numLines_
+  template <size_t NumLines>
+  void processChunk(const float* input, float* wet, size_t numSamples);
+  // block_ に読み出した線の出力から、ダンピング・出力タップ・行列・
+  // ゲインと入力を計算し、遅延線に書き込む値を block_ に置く
+  template <size_t NumLines>
+  void processLinesScalar(const float* input, float* wet, size_t numSamples);
+  template <size_t NumLines>
+  void processLinesSse2(const float* input, float* wet, size_t numSamples);
+
+  void updateLineParameters();
+  void applyLineParameters(float decay, float damping);
+
+  float sampleRate_;
+  size_t numLines_;
+  size_t maxChunk_;  // 最短の遅延と kChunkSize の小さい方
+
+  std::vector<DelayLine> lines_;
+  // 線ごとのフィードバックゲイン (行列の正規化込み)
+  float gain_[kMaxLines] = {};
+  float store_[kMaxLines] = {};  // ダンピングの状態
+
+  // [線][サンプル] の作業領域 (SSE2 版では [サンプル][線] に転置して使う)
+  alignas(16) float block_[kMaxLines][kChunkSize] = {};
+  alignas(16) float frames_[kChunkSize][kMaxLines] = {};
+
+  // パラメータ (dry = 1 - wet の線形ミックス)
+  SmoothedParameter wetLevel_;
+  SmoothedParameter decay_;
+  SmoothedParameter damping_;
+  // 線に反映済みの decay / damping
+  float lineDecay_ = 0.0f;
+  float lineDamping_ = 0.0f;
+};
+
+#endif  // FDNREVERB_H
@@ -0,0 +1,183 @@
+#include "Fft.h"
+
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define FFT_SSE2 1
+#include <immintrin.h>
+#endif
+
+RealFft::RealFft(size_t size)
+    : size_(size),
+      half_(size / 2),
+      bitReverse_(half_),
+      realCos_(half_ + 1),
+      realSin_(half_ + 1),
+      workRe_(half_),
+      workIm_(half_) {
+  assert(size_ >= 2 && std::has_single_bit(size_));
+
+  const int bits = std::countr_zero(half_);
+  for (size_t i = 0; i < half_; ++i) {
+    unsigned reversed = 0;
+    for (int b = 0; b < bits; ++b) {
+      reversed |= ((i >> b) & 1u) << (bits - 1 - b);
+    }
+    bitReverse_[i] = reversed;
+  }
+
+  // 回転因子は double で求めてから丸める
+  stageCos_.reserve(half_);
+  stageSin_.reserve(half_);
+  for (size_t len = 2; len <= half_; len <<= 1) {
+    for (size_t j = 0; j < len / 2; ++j) {
+      const double angle = 2.0 * std::numbers::pi * j / len;
+      stageCos_.push_back(static_cast<float>(std::cos(angle)));
+      stageSin_.push_back(static_cast<float>(std::sin(angle)));
+    }
+  }
+  for (size_t k = 0; k <= half_; ++k) {
+    const double angle = 2.0 * std::numbers::pi * k / size_;
+    realCos_[k] = static_cast<float>(std::cos(angle));
+    realSin_[k] = static_cast<float>(std::sin(angle));
+  }
+}
+
+void RealFft::forward(const float* input, float* re, float* im) {
+  // 偶数番目を実部、奇数番目を虚部にした長さ half_ の複素数列を変換する
+  for (size_t m = 0; m < half_; ++m) {
+    workRe_[bitReverse_[m]] = input[2 * m];
+    workIm_[bitReverse_[m]] = input[2 * m + 1];
+  }
+  transform<false>();
+
+  // Z[k] と conj(Z[half - k]) から偶数列と奇数列のスペクトルを取り出し、
+  // X[k] = E[k] + exp(-2πik/size) O[k] でまとめる
+  // (k = 0 と k = half は Z[0] だけから決まる)
+  re[0] = workRe_[0] + workIm_[0];
+  im[0] = 0.0f;
+  re[half_] = workRe_[0] - workIm_[0];
+  im[half_] = 0.0f;
+  for (size_t k = 1; k < half_; ++k) {
+    const size_t b = half_ - k;
+    const float evenRe = 0.5f * (workRe_[k] + workRe_[b]);
+    const float evenIm = 0.5f * (workIm_[k] - workIm_[b]);
+    // O = (Z[k] - conj(Z[half - k])) / 2i
+    const float oddRe = 0.5f * (workIm_[k] + workIm_[b]);
+    const float oddIm = -0.5f * (workRe_[k] - workRe_[b]);
+    const float c = realCos_[k];
+    const float s = realSin_[k];
+    re[k] = evenRe + (c * oddRe + s * oddIm);
+    im[k] = evenIm + (c * oddIm - s * oddRe);
+  }
+}
+
+void RealFft::inverse(const float* re, const float* im, float* output) {
+  // forward の後処理を逆にたどって複素数列に戻す (2倍のまま)
+  for (size_t k = 0; k < half_; ++k) {
+    const size_t b = half_ - k;
+    const float evenRe = re[k] + re[b];
+    const float evenIm = im[k] - im[b];
+    const float diffRe = re[k] - re[b];
+    const float diffIm = im[k] + im[b];
+    // O = (X[k] - conj(X[half - k])) * exp(2πik/size)
+    const float c = realCos_[k];
+    const float s = realSin_[k];
+    const float oddRe = diffRe * c - diffIm * s;
+    const float oddIm = diffRe * s + diffIm * c;
+    // Z = E + iO
+    workRe_[bitReverse_[k]] = evenRe - oddIm;
+    workIm_[bitReverse_[k]] = evenIm + oddRe;
+  }
+  transform<true>();
+
+  for (size_t m = 0; m < half_; ++m) {
+    output[2 * m] = workRe_[m];
+    output[2 * m + 1] = workIm_[m];
+  }
+}
+
+template <bool Inverse>
+void RealFft::transform() {
+  float* re = workRe_.data();
+  float* im = workIm_.data();
+  size_t len = 2;
+  size_t table = 0;
+  if (half_ >= 4) {
+    // 最初の2段 (回転因子は 1 と ∓i だけ) は4点ずつまとめて計算する
+    for (size_t base = 0; base < half_; base += 4) {
+      float* r = re + base;
+      float* i = im + base;
+      const float r0 = r[0] + r[1], i0 = i[0] + i[1];
+      const float r1 = r[0] - r[1], i1 = i[0] - i[1];
+      const float r2 = r[2] + r[3], i2 = i[2] + i[3];
+      // (r[2] - r[3]) に ∓i を掛けたもの
+      const float r3 = Inverse ? i[3] - i[2] : i[2] - i[3];
+      const float i3 = Inverse ? r[2] - r[3] : r[3] - r[2];
+      r[0] = r0 + r2;
+      i[0] = i0 + i2;
+      r[2] = r0 - r2;
+      i[2] = i0 - i2;
+      r[1] = r1 + r3;
+      i[1] = i1 + i3;
+      r[3] = r1 - r3;
+      i[3] = i1 - i3;
+    }
+    len = 8;
+    table = 3;
+  }
+  for (; len <= half_; len <<= 1) {
+    const size_t span = len / 2;
+    const float* cosine = stageCos_.data() + table;
+    const float* sine = stageSin_.data() + table;
+    table += span;
+#ifdef FFT_SSE2
+    // 最初の2段の後は span が4の倍数なので、4組の butterfly を同時に計算する
+    if (span >= 4) {
+      const __m128 sign = _mm_set1_ps(Inverse ? 1.0f : -1.0f);
+      for (size_t base = 0; base < half_; base += len) {
+        float* aRe = re + base;
+        float* aIm = im + base;
+        float* bRe = aRe + span;
+        float* bIm = aIm + span;
+        for (size_t j = 0; j < span; j += 4) {
+          const __m128 wRe = _mm_loadu_ps(cosine + j);
+          const __m128 wIm = _mm_mul_ps(_mm_loadu_ps(sine + j), sign);
+          const __m128 xRe = _mm_loadu_ps(bRe + j);
+          const __m128 xIm = _mm_loadu_ps(bIm + j);
+          const __m128 tRe =
+              _mm_sub_ps(_mm_mul_ps(xRe, wRe), _mm_mul_ps(xIm, wIm));
+          const __m128 tIm =
+              _mm_add_ps(_mm_mul_ps(xRe, wIm), _mm_mul_ps(xIm, wRe));
+          const __m128 yRe = _mm_loadu_ps(aRe + j);
+          const __m128 yIm = _mm_loadu_ps(aIm + j);
+          _mm_storeu_ps(bRe + j, _mm_sub_ps(yRe, tRe));
+          _mm_storeu_ps(bIm + j, _mm_sub_ps(yIm, tIm));
+          _mm_storeu_ps(aRe + j, _mm_add_ps(yRe, tRe));
+          _mm_storeu_ps(aIm + j, _mm_add_ps(yIm, tIm));
+        }
+      }
+      continue;
+    }
+#endif
+    for (size_t base = 0; base < half_; base += len) {
+      float* aRe = re + base;
+      float* aIm = im + base;
+      float* bRe = aRe + span;
+      float* bIm = aIm + span;
+      for (size_t j = 0; j < span; ++j) {
+        const float wRe = cosine[j];
+        const float wIm = Inverse ? sine[j] : -sine[j];
+        const float tRe = bRe[j] * wRe - bIm[j] * wIm;
+        const float tIm = bRe[j] * wIm + bIm[j] * wRe;
+        bRe[j] = aRe[j] - tRe;
+        bIm[j] = aIm[j] - tIm;
+        aRe[j] += tRe;
+        aIm[j] += tIm;
+      }
+    }
+  }
+}
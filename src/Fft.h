@@ -0,0 +1,51 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <cstddef>
+#include <vector>
+
+// 実数列の FFT (長さは2のべき乗)
+//
+// 長さ N の実数列を、長さ N/2 の複素 FFT (基数2, 時間間引き) で変換し、
+// 後処理で N/2 + 1 個のビンに分ける。スペクトルは実部と虚部を別々の
+// 配列に置く (split 形式)。畳み込みの複素積和がビン方向にそのまま
+// SIMD 化できる。x86 では butterfly を SSE2 で4組ずつ計算する。
+//
+// 回転因子はコンストラクタで段ごとに連続した表にしておくので、
+// forward / inverse はメモリ確保をしない。作業領域を持つので、
+// 1つのインスタンスを複数のスレッドから同時に使ってはいけない。
+class RealFft {
+ public:
+  // size は2以上の2のべき乗
+  explicit RealFft(size_t size);
+
+  size_t getSize() const { return size_; }
+  size_t getNumBins() const { return size_ / 2 + 1; }
+
+  // input (size 個) → re, im (getNumBins() 個ずつ)
+  void forward(const float* input, float* re, float* im);
+  // re, im → output (size 個)。正規化しないので、
+  // inverse(forward(x)) は x の size 倍になる
+  void inverse(const float* re, const float* im, float* output);
+
+ private:
+  // 長さ half_ の複素 FFT (work に対してインプレース)
+  template <bool Inverse>
+  void transform();
+
+  size_t size_;
+  size_t half_;  // 複素 FFT の長さ (size / 2)
+
+  std::vector<unsigned> bitReverse_;
+  // 段ごとの回転因子 exp(-2πij/len) (長さ len/2 の表を順に並べる)
+  std::vector<float> stageCos_;
+  std::vector<float> stageSin_;
+  // 実数化の回転因子 exp(-2πik/size) (k = 0..half_)
+  std::vector<float> realCos_;
+  std::vector<float> realSin_;
+
+  std::vector<float> workRe_;
+  std::vector<float> workIm_;
+};
+
+#endif  // FFT_H
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 多数のインスタンスの遅延メモリを1回の確保から切り出すアリーナ
+// allocate はオフセットを進めるだけで、個々の領域は解放しない
+// (アリーナを使うオブジェクトより長く生存させること)。
+// 切り出す領域はキャッシュライン (64 バイト) 境界に揃える。
+class FloatArena {
+ public:
+  static constexpr size_t kAlignment = 16;  // float 16個 = 64 バイト
+
+  // 領域の確保に必要な float 数 (アライメント分を含む)
+  static size_t alignedSize(size_t numFloats) {
+    return (numFloats + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  // numFloats は alignedSize で求めたサイズの合計にする
+  explicit FloatArena(size_t numFloats)
+      : storage_(alignedSize(numFloats) + kAlignment - 1, 0.0f),
+        base_(alignPointer(storage_.data())),
+        capacity_(alignedSize(numFloats)),
+        used_(0) {}
+
+  FloatArena(const FloatArena&) = delete;
+  FloatArena& operator=(const FloatArena&) = delete;
+
+  // 0 で初期化済みの領域を返す。残りが足りなければ nullptr
+  float* allocate(size_t numFloats) {
+    const size_t size = alignedSize(numFloats);
+    if (size > capacity_ - used_) {
+      return nullptr;
+    }
+    float* p = base_ + used_;
+    used_ += size;
+    return p;
+  }
+
+  size_t getCapacity() const { return capacity_; }
+  size_t getUsed() const { return used_; }
+
+ private:
+  static float* alignPointer(float* p) {
+    constexpr uintptr_t bytes = kAlignment * sizeof(float);
+    const uintptr_t address = reinterpret_cast<uintptr_t>(p);
+    return p + ((bytes - address % bytes) % bytes) / sizeof(float);
+  }
+
+  std::vector<float> storage_;
+  float* base_;
+  size_t capacity_;
+  size_t used_;
+};
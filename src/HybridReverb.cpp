@@ -0,0 +1,211 @@
+#include "HybridReverb.h"
+
+#include <algorithm>
+#include <bit>
+
+using namespace reverb_tuning;
+
+namespace {
+int earlyDelaySamples(float sampleRate, size_t tap) {
+  return std::max(delaySamples(sampleRate, kEarlyTapTimes[tap]), 1);
+}
+}  // namespace
+
+HybridReverb::HybridReverb(float sampleRate, size_t tailBlockSize,
+                           bool backgroundTail)
+    : tailBlockSize_(std::bit_floor(
+          std::clamp(tailBlockSize, kMinTailBlockSize, kMaxTailBlockSize))),
+      // タップは短い順に並んでいるので、遅延線の遅延は最後のタップ
+      early_(earlyDelaySamples(sampleRate, kNumEarlyTaps - 1)),
+      tail_(sampleRate),
+      backgroundTail_(backgroundTail),
+      wetLevel_(kDefaultWetLevel, smoothingSamples(sampleRate)),
+      earlyLevel_(kDefaultEarlyLevel, smoothingSamples(sampleRate)) {
+  for (size_t t = 0; t < kNumEarlyTaps; ++t) {
+    earlyDelays_[t] = earlyDelaySamples(sampleRate, t);
+  }
+  maxChunk_ = std::min(kChunkSize, static_cast<size_t>(earlyDelays_[0]));
+
+  // 残響は wet だけを出し、ミックスはこちらで行う
+  tail_.setWetLevel(1.0f);
+  for (int i = 0; i < 2; ++i) {
+    tailInput_[i].assign(tailBlockSize_, 0.0f);
+    tailOutput_[i].assign(tailBlockSize_, 0.0f);
+  }
+  if (backgroundTail_) {
+    worker_ = std::thread(&HybridReverb::tailWorkerLoop, this);
+  }
+
+  reset();
+}
+
+HybridReverb::~HybridReverb() {
+  if (worker_.joinable()) {
+    stop_.store(true, std::memory_order_relaxed);
+    tailPosted_.fetch_add(1, std::memory_order_release);
+    tailPosted_.notify_one();
+    worker_.join();
+  }
+}
+
+float HybridReverb::process(float sample) {
+  float output;
+  process(&sample, &output, 1);
+  return output;
+}
+
+void HybridReverb::process(const float* input, float* output,
+                           size_t numSamples) {
+  wetLevel_.pollTarget();
+  earlyLevel_.pollTarget();
+  float wet[kChunkSize];
+  while (numSamples > 0) {
+    const size_t tailOffset = position_ & (tailBlockSize_ - 1);
+    const size_t n =
+        std::min({numSamples, maxChunk_, tailBlockSize_ - tailOffset});
+    processChunk(input, wet, n);
+
+    if (wetLevel_.isRamping()) {
+      for (size_t i = 0; i < n; ++i) {
+        const float wetLevel = wetLevel_.advance(1);
+        output[i] = ((1.0f - wetLevel) * input[i]) + (wetLevel * wet[i]);
+      }
+    } else {
+      const float wetLevel = wetLevel_.getCurrent();
+      const float dryLevel = 1.0f - wetLevel;
+      for (size_t i = 0; i < n; ++i) {
+        output[i] = (dryLevel * input[i]) + (wetLevel * wet[i]);
+      }
+    }
+    input += n;
+    output += n;
+    numSamples -= n;
+  }
+}
+
+void HybridReverb::processChunk(const float* input, float* wet,
+                                size_t numSamples) {
+  // 初期反射。チャンクは最短のタップ以下なので、どのタップもこのチャンクを
+  // 書く前の位置を読む
+  float longest[kChunkSize];
+  std::fill_n(wet, numSamples, 0.0f);
+  for (size_t t = 0; t + 1 < kNumEarlyTaps; ++t) {
+    early_.addTap(earlyDelays_[t], kEarlyTapGains[t] * kEarlyMixGain, wet,
+                  numSamples);
+  }
+  // 最も長いタップは遅延線の出力そのもの
+  early_.read(longest, numSamples);
+  const float longestGain = kEarlyTapGains[kNumEarlyTaps - 1] * kEarlyMixGain;
+  for (size_t i = 0; i < numSamples; ++i) {
+    wet[i] += longestGain * longest[i];
+  }
+  early_.write(input, numSamples);
+
+  if (earlyLevel_.isRamping()) {
+    for (size_t i = 0; i < numSamples; ++i) {
+      wet[i] *= earlyLevel_.advance(1);
+    }
+  } else {
+    const float earlyLevel = earlyLevel_.getCurrent();
+    for (size_t i = 0; i < numSamples; ++i) {
+      wet[i] *= earlyLevel;
+    }
+  }
+
+  // 残響。ブロック J の入力をためながら、ブロック J - 2 の結果を足す
+  // (ワーカーはその間にブロック J - 1 を計算している)
+  const uint64_t tailBlock = position_ / tailBlockSize_;
+  const size_t tailOffset = position_ & (tailBlockSize_ - 1);
+  const uint32_t block = tailBase_ + static_cast<uint32_t>(tailBlock);
+  if (tailBlock >= 2) {
+    if (tailOffset == 0) {
+      waitForTail(block - 2);
+    }
+    const float* tailOutput = tailOutput_[block & 1].data() + tailOffset;
+    for (size_t i = 0; i < numSamples; ++i) {
+      wet[i] += tailOutput[i];
+    }
+  }
+  std::copy_n(input, numSamples, tailInput_[block & 1].data() + tailOffset);
+  position_ += numSamples;
+  if (tailOffset + numSamples == tailBlockSize_) {
+    postTailBlock();
+  }
+}
+
+void HybridReverb::postTailBlock() {
+  tailBlocks_.increment();
+  const uint32_t block = tailPosted_.load(std::memory_order_relaxed);
+  if (!backgroundTail_) {
+    tail_.process(tailInput_[block & 1].data(), tailOutput_[block & 1].data(),
+                  tailBlockSize_);
+    tailPosted_.store(block + 1, std::memory_order_relaxed);
+    tailDone_.store(block + 1, std::memory_order_relaxed);
+    return;
+  }
+  tailPosted_.store(block + 1, std::memory_order_release);
+  tailPosted_.notify_one();
+}
+
+void HybridReverb::waitForTail(uint32_t block) {
+  // 番号の一周 (約2^32ブロック) を考えて差で比べる
+  const auto finished = [block](uint32_t done) {
+    return static_cast<int32_t>(done - block) > 0;
+  };
+  uint32_t done = tailDone_.load(std::memory_order_acquire);
+  if (finished(done)) {
+    return;
+  }
+  lateTailBlocks_.increment();
+  do {
+    tailDone_.wait(done, std::memory_order_acquire);
+    done = tailDone_.load(std::memory_order_acquire);
+  } while (!finished(done));
+}
+
+void HybridReverb::tailWorkerLoop() {
+  uint32_t done = 0;
+  for (;;) {
+    tailPosted_.wait(done, std::memory_order_acquire);
+    if (stop_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    const uint32_t posted = tailPosted_.load(std::memory_order_acquire);
+    while (done != posted) {
+      tail_.process(tailInput_[done & 1].data(), tailOutput_[done & 1].data(),
+                    tailBlockSize_);
+      ++done;
+      tailDone_.store(done, std::memory_order_release);
+      tailDone_.notify_one();
+    }
+  }
+}
+
+void HybridReverb::reset() {
+  // ワーカーが手を離してから残響の状態を消す
+  const uint32_t posted = tailPosted_.load(std::memory_order_relaxed);
+  uint32_t done = tailDone_.load(std::memory_order_acquire);
+  while (done != posted) {
+    tailDone_.wait(done, std::memory_order_acquire);
+    done = tailDone_.load(std::memory_order_acquire);
+  }
+  tail_.reset();
+  tailBase_ = posted;
+  early_.clear();
+  position_ = 0;
+  // 無音から始めるので、パラメータはランプせずに目標値へ切り替える
+  wetLevel_.snap();
+  earlyLevel_.snap();
+}
+
+void HybridReverb::setWetLevel(float level) {
+  wetLevel_.setTarget(std::clamp(level, 0.0f, 1.0f));
+}
+
+void HybridReverb::setEarlyLevel(float level) {
+  earlyLevel_.setTarget(std::clamp(level, 0.0f, 1.0f));
+}
+
+void HybridReverb::setDecay(float decay) { tail_.setDecay(decay); }
+
+void HybridReverb::setDamping(float damping) { tail_.setDamping(damping); }
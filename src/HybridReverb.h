@@ -0,0 +1,127 @@
+#ifndef HYBRIDREVERB_H
+#define HYBRIDREVERB_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "DelayLine.h"
+#include "RelaxedCounter.h"
+#include "Reverb.h"
+#include "ReverbTuning.h"
+#include "SmoothedParameter.h"
+
+// 初期反射 (音声スレッド) と Schroeder の残響 (ワーカースレッド) を
+// 組み合わせたリバーブ
+//
+//   x ──┬──> [マルチタップ遅延] ──> earlyLevel ──┐
+//       │                                       (+) ──> wet
+//       └──> [Reverb (コム + オールパス)] ──────┘
+//             2 * tailBlockSize サンプル遅れて届く
+//
+// 初期反射は1本の DelayLine から kEarlyTapTimes のタップを読むだけなので
+// 軽い。decay が大きいときに重くなる残響は、latency を許容できるので
+// ワーカースレッドで先に計算する。
+//
+// 残響は tailBlockSize (T) サンプルずつまとめてワーカーに渡し、ブロック J の
+// 結果はブロック J + 2 で使う (ConvolutionReverb の末尾と同じ)。
+// 入出力のバッファは2面ずつで、ブロック番号の偶奇で使い分ける
+// (ロックフリーのダブルバッファ)。ブロック番号は std::atomic の
+// wait / notify でやり取りする。出力は、残響を 2T サンプル遅らせた
+// 1スレッドの処理 (backgroundTail = false) と全く同じになる。
+//
+// ワーカーの締め切りは、ブロック J を渡してから J + 2 の先頭までの
+// T サンプル分の処理。ホストのブロック長が 2T 以下なら、J + 2 の先頭の前に
+// 必ずコールバックの合間があるので、ワーカーはその間 (48kHz, T = 256 で
+// 約 5.3ms 以上) に計算できる。ホストのブロック長が 2T を超えると、同じ
+// コールバックの中で渡したブロックを待つことになるので、T はホストの
+// ブロック長の半分以上にする。
+// 間に合わなかったときは process() が待ち、lateTailBlocks に数える。
+// バッファとスレッドはコンストラクタで用意し、process() はメモリ確保も
+// mutex も使わない。パラメータは Reverb と同じく別スレッドから設定してよい。
+class HybridReverb {
+ public:
+  struct Stats {
+    uint32_t tailBlocks;      // ワーカーに渡した残響のブロック数
+    uint32_t lateTailBlocks;  // 残響の計算を待った回数
+  };
+
+  static constexpr size_t kMinTailBlockSize = 32;
+  static constexpr size_t kMaxTailBlockSize = 4096;
+  static constexpr size_t kDefaultTailBlockSize = 256;
+
+  // tailBlockSize は [kMinTailBlockSize, kMaxTailBlockSize] の2のべき乗に
+  // 切り下げる。backgroundTail が false なら残響も process() の中で計算する
+  HybridReverb(float sampleRate, size_t tailBlockSize = kDefaultTailBlockSize,
+               bool backgroundTail = true);
+  ~HybridReverb();
+
+  HybridReverb(const HybridReverb&) = delete;
+  HybridReverb& operator=(const HybridReverb&) = delete;
+
+  float process(float sample);
+  // ブロック処理。input と output は同じバッファでもよい
+  void process(const float* input, float* output, size_t numSamples);
+  // ワーカーの計算が終わるのを待ってから、全ての状態を消す
+  void reset();
+
+  void setWetLevel(float level);    // 0.0 (dry) to 1.0 (wet)
+  void setEarlyLevel(float level);  // 0.0 (残響のみ) to 1.0
+  void setDecay(float decay);       // 0.0 (short) to 1.0 (long)
+  void setDamping(float damping);   // 0.0 (bright) to 1.0 (dark)
+
+  // 残響の遅れ (サンプル数)
+  size_t getTailLatency() const { return 2 * tailBlockSize_; }
+
+  Stats getStats() const {
+    return {tailBlocks_.load(), lateTailBlocks_.load()};
+  }
+  void resetStats() {
+    tailBlocks_.reset();
+    lateTailBlocks_.reset();
+  }
+
+ private:
+  // 一度に処理する最大サンプル数 (作業領域の長さ)
+  static constexpr size_t kChunkSize = 128;
+
+  // numSamples は maxChunk_ 以下で、残響のブロックの境目をまたがない
+  void processChunk(const float* input, float* wet, size_t numSamples);
+  void postTailBlock();
+  void waitForTail(uint32_t block);
+  void tailWorkerLoop();
+
+  size_t tailBlockSize_;
+  size_t maxChunk_;  // 最短のタップと kChunkSize の小さい方
+
+  // 初期反射。遅延線の遅延は最も長いタップ
+  DelayLine early_;
+  int earlyDelays_[reverb_tuning::kNumEarlyTaps] = {};
+
+  // ワーカー (同期モードでは process()) だけが触る残響
+  Reverb tail_;
+  std::vector<float> tailInput_[2];
+  std::vector<float> tailOutput_[2];
+  // reset() からの経過サンプル数
+  uint64_t position_ = 0;
+  // reset() の時点で渡し済みだったブロック数
+  uint32_t tailBase_ = 0;
+  bool backgroundTail_;
+
+  // 渡したブロック数と、計算が終わったブロック数
+  alignas(64) std::atomic<uint32_t> tailPosted_{0};
+  alignas(64) std::atomic<uint32_t> tailDone_{0};
+  std::atomic<bool> stop_{false};
+  std::thread worker_;
+
+  // パラメータ (dry = 1 - wet の線形ミックス)
+  SmoothedParameter wetLevel_;
+  SmoothedParameter earlyLevel_;
+
+  RelaxedCounter tailBlocks_;
+  RelaxedCounter lateTailBlocks_;
+};
+
+#endif  // HYBRIDREVERB_H
@@ -0,0 +1,73 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// 遅延の変調に使う正弦波 LFO
+// 正弦波は kSegmentLength サンプルごとにだけ計算し、その間は線形に補間する
+// (変調は数 Hz 以下なので、補間による誤差は聞こえない)。
+// 正弦波も多項式で近似する (誤差 0.001 程度。sin の呼び出しより十分軽い)。
+// 値はセグメント内の位置だけで決まるので、処理をどんなブロック長に
+// 分けても同じ値になる。
+class Lfo {
+ public:
+  static constexpr size_t kSegmentLength = 64;
+
+  // cyclesPerSample = 周波数 (Hz) / サンプルレート
+  // 次のセグメントから反映する (reset すれば最初から新しい周波数になる)
+  void setFrequency(float cyclesPerSample) {
+    increment_ =
+        std::max(cyclesPerSample, 0.0f) * static_cast<float>(kSegmentLength);
+  }
+
+  // 位相 phase (0.0-1.0) から始め直す
+  void reset(float phase = 0.0f) {
+    phase_ = phase - std::floor(phase);
+    position_ = 0;
+    end_ = sine(phase_);
+    nextSegment();
+  }
+
+  // 今のセグメントの position 番目 (0 to kSegmentLength) の値 (-1.0 to 1.0)
+  float valueAt(size_t position) const {
+    return start_ + slope_ * static_cast<float>(position);
+  }
+  float getSegmentStart() const { return start_; }
+  float getSegmentSlope() const { return slope_; }
+  size_t getPosition() const { return position_; }
+  size_t samplesUntilSegmentEnd() const { return kSegmentLength - position_; }
+
+  void advance(size_t numSamples) {
+    position_ += numSamples;
+    while (position_ >= kSegmentLength) {
+      position_ -= kSegmentLength;
+      nextSegment();
+    }
+  }
+
+ private:
+  // sin(2 * pi * phase) の近似 (phase は 0.0-1.0)。
+  // 放物線で近似してから、誤差を2次の補正で打ち消す
+  static float sine(float phase) {
+    const float x = 0.5f - phase;  // sin(2 * pi * phase) = sin(2 * pi * x)
+    const float y = 8.0f * x - 16.0f * x * std::abs(x);
+    return y + 0.225f * (y * std::abs(y) - y);
+  }
+
+  // 前のセグメントの終わりから、次の kSegmentLength サンプル後の値へ
+  void nextSegment() {
+    start_ = end_;
+    phase_ += increment_;
+    // 周波数は負にしないので、int への切り捨てで小数部を取り出せる
+    phase_ -= static_cast<float>(static_cast<int>(phase_));
+    end_ = sine(phase_);
+    slope_ = (end_ - start_) / static_cast<float>(kSegmentLength);
+  }
+
+  float phase_ = 0.0f;      // セグメントの終わりの位相
+  float increment_ = 0.0f;  // 1セグメントあたりの位相の進み
+  float start_ = 0.0f;
+  float end_ = 0.0f;
+  float slope_ = 0.0f;
+  size_t position_ = 0;  // セグメント内のサンプル位置
+};
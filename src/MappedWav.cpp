@@ -0,0 +1,354 @@
+#include "MappedWav.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "MultichannelReverb.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPEDWAV_HAS_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr uint16_t kFormatIeeeFloat = 0x0003;
+constexpr uint16_t kFormatExtensible = 0xFFFE;
+// RIFF ヘッダ + 16 バイトの fmt チャンク + data チャンクのヘッダ
+// (dr_wav が書くものと同じ形。PCM 領域が4バイト境界に揃う)
+constexpr size_t kHeaderSize = 44;
+// 処理済みのページをまとめて手放す間隔
+constexpr size_t kReleaseBytes = 4 << 20;
+
+// ファイルはリトルエンディアン。マップした領域をそのまま float として
+// 読むので、ホストもリトルエンディアンであることが前提
+constexpr bool kHostIsLittleEndian = std::endian::native == std::endian::little;
+
+template <typename T>
+T readLE(const uint8_t* p) {
+  T value;
+  std::memcpy(&value, p, sizeof(T));
+  return value;
+}
+
+template <typename T>
+void writeLE(uint8_t* p, T value) {
+  std::memcpy(p, &value, sizeof(T));
+}
+
+#ifdef MAPPEDWAV_HAS_MMAP
+size_t pageSize() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+// ファイルを size バイトにし、ディスク上の領域も確保する。ftruncate だけだと
+// 疎なファイルになり、マップへの書き込み中にディスクが尽きると SIGBUS になる
+bool reserveFile(int fd, size_t size) {
+#ifdef __APPLE__
+  fstore_t store = {F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(size),
+                    0};
+  if (fcntl(fd, F_PREALLOCATE, &store) != 0) {
+    return false;
+  }
+  return ftruncate(fd, static_cast<off_t>(size)) == 0;
+#else
+  return posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+#endif
+}
+#endif
+
+}  // namespace
+
+// --- MappedWavReader ---
+
+MappedWavReader::~MappedWavReader() { close(); }
+
+bool MappedWavReader::open(const std::string& path) {
+  close();
+#ifdef MAPPEDWAV_HAS_MMAP
+  if (!kHostIsLittleEndian) {
+    return false;
+  }
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd_, &st) != 0 || st.st_size < 12) {
+    close();
+    return false;
+  }
+  mapSize_ = static_cast<size_t>(st.st_size);
+  map_ = mmap(nullptr, mapSize_, PROT_READ, MAP_SHARED, fd_, 0);
+  if (map_ == MAP_FAILED) {
+    map_ = nullptr;
+    close();
+    return false;
+  }
+  madvise(map_, mapSize_, MADV_SEQUENTIAL);
+
+  const auto* bytes = static_cast<const uint8_t*>(map_);
+  if (std::memcmp(bytes, "RIFF", 4) != 0 ||
+      std::memcmp(bytes + 8, "WAVE", 4) != 0) {
+    close();
+    return false;
+  }
+
+  // チャンクを順に見て fmt と data を探す
+  uint16_t formatTag = 0;
+  uint16_t bitsPerSample = 0;
+  size_t dataSize = 0;
+  bool foundFormat = false;
+  bool foundData = false;
+  size_t pos = 12;
+  while (pos + 8 <= mapSize_ && !foundData) {
+    const uint8_t* chunk = bytes + pos;
+    const size_t chunkSize = readLE<uint32_t>(chunk + 4);
+    const size_t body = pos + 8;
+    if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 &&
+        body + 16 <= mapSize_) {
+      formatTag = readLE<uint16_t>(bytes + body);
+      channels_ = readLE<uint16_t>(bytes + body + 2);
+      sampleRate_ = static_cast<float>(readLE<uint32_t>(bytes + body + 4));
+      bitsPerSample = readLE<uint16_t>(bytes + body + 14);
+      // WAVE_FORMAT_EXTENSIBLE はサブフォーマット GUID の先頭が形式
+      if (formatTag == kFormatExtensible && chunkSize >= 40 &&
+          body + 26 <= mapSize_) {
+        formatTag = readLE<uint16_t>(bytes + body + 24);
+      }
+      foundFormat = true;
+    } else if (std::memcmp(chunk, "data", 4) == 0) {
+      dataOffset_ = body;
+      // 書きかけのファイルなどでサイズがおかしい場合はファイル末尾まで
+      dataSize = std::min(chunkSize, mapSize_ - std::min(body, mapSize_));
+      foundData = true;
+    }
+    pos = body + chunkSize + (chunkSize & 1);  // チャンクは2バイト境界
+  }
+
+  if (!foundFormat || !foundData || formatTag != kFormatIeeeFloat ||
+      bitsPerSample != 32 || channels_ == 0 || dataOffset_ % 4 != 0) {
+    close();
+    return false;
+  }
+  samples_ = reinterpret_cast<const float*>(bytes + dataOffset_);
+  numFrames_ = dataSize / (sizeof(float) * channels_);
+  return true;
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+void MappedWavReader::close() {
+#ifdef MAPPEDWAV_HAS_MMAP
+  if (map_ != nullptr) {
+    munmap(map_, mapSize_);
+  }
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+#endif
+  fd_ = -1;
+  map_ = nullptr;
+  mapSize_ = 0;
+  dataOffset_ = 0;
+  released_ = 0;
+  samples_ = nullptr;
+  numFrames_ = 0;
+  channels_ = 0;
+}
+
+void MappedWavReader::release(uint64_t endFrame) {
+#ifdef MAPPEDWAV_HAS_MMAP
+  if (map_ == nullptr) {
+    return;
+  }
+  const size_t end = std::min<size_t>(
+      mapSize_, dataOffset_ + endFrame * channels_ * sizeof(float));
+  const size_t pageEnd = end / pageSize() * pageSize();
+  if (pageEnd > released_) {
+    // 読み取り専用のマップなので、捨てても再アクセス時にファイルから読み直す
+    madvise(static_cast<uint8_t*>(map_) + released_, pageEnd - released_,
+            MADV_DONTNEED);
+    released_ = pageEnd;
+  }
+#else
+  (void)endFrame;
+#endif
+}
+
+// --- MappedWavWriter ---
+
+MappedWavWriter::~MappedWavWriter() { close(); }
+
+bool MappedWavWriter::create(const std::string& path, size_t channels,
+                             float sampleRate, uint64_t numFrames) {
+  close();
+#ifdef MAPPEDWAV_HAS_MMAP
+  const uint64_t dataBytes = numFrames * channels * sizeof(float);
+  // RIFF のサイズは32bit。超える場合は RF64 が必要なので扱わない
+  if (!kHostIsLittleEndian || channels == 0 ||
+      dataBytes > UINT32_MAX - (kHeaderSize - 8)) {
+    return false;
+  }
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    return false;
+  }
+  mapSize_ = kHeaderSize + static_cast<size_t>(dataBytes);
+  if (!reserveFile(fd_, mapSize_)) {
+    // 書きかけのファイルを残さない
+    close();
+    ::unlink(path.c_str());
+    return false;
+  }
+  map_ = mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (map_ == MAP_FAILED) {
+    map_ = nullptr;
+    close();
+    ::unlink(path.c_str());
+    return false;
+  }
+
+  const uint32_t blockAlign = static_cast<uint32_t>(channels * sizeof(float));
+  const auto rate = static_cast<uint32_t>(sampleRate);
+  auto* header = static_cast<uint8_t*>(map_);
+  std::memcpy(header, "RIFF", 4);
+  writeLE<uint32_t>(header + 4, static_cast<uint32_t>(mapSize_ - 8));
+  std::memcpy(header + 8, "WAVE", 4);
+  std::memcpy(header + 12, "fmt ", 4);
+  writeLE<uint32_t>(header + 16, 16);
+  writeLE<uint16_t>(header + 20, kFormatIeeeFloat);
+  writeLE<uint16_t>(header + 22, static_cast<uint16_t>(channels));
+  writeLE<uint32_t>(header + 24, rate);
+  writeLE<uint32_t>(header + 28, rate * blockAlign);
+  writeLE<uint16_t>(header + 32, static_cast<uint16_t>(blockAlign));
+  writeLE<uint16_t>(header + 34, 32);
+  std::memcpy(header + 36, "data", 4);
+  writeLE<uint32_t>(header + 40, static_cast<uint32_t>(dataBytes));
+
+  samples_ = reinterpret_cast<float*>(header + kHeaderSize);
+  numFrames_ = numFrames;
+  channels_ = channels;
+  return true;
+#else
+  (void)path;
+  (void)channels;
+  (void)sampleRate;
+  (void)numFrames;
+  return false;
+#endif
+}
+
+bool MappedWavWriter::close() {
+  bool ok = true;
+#ifdef MAPPEDWAV_HAS_MMAP
+  if (map_ != nullptr) {
+    ok = msync(static_cast<uint8_t*>(map_) + released_, mapSize_ - released_,
+               MS_SYNC) == 0;
+    munmap(map_, mapSize_);
+  }
+  if (fd_ >= 0) {
+    // release() で MS_ASYNC にした前半のページも含めて、書き出しの完了
+    // (とエラー) をここで確かめる
+    ok = (fsync(fd_) == 0) && ok;
+    ok = (::close(fd_) == 0) && ok;
+  }
+#endif
+  fd_ = -1;
+  map_ = nullptr;
+  mapSize_ = 0;
+  released_ = 0;
+  samples_ = nullptr;
+  numFrames_ = 0;
+  channels_ = 0;
+  return ok;
+}
+
+void MappedWavWriter::release(uint64_t endFrame) {
+#ifdef MAPPEDWAV_HAS_MMAP
+  if (map_ == nullptr) {
+    return;
+  }
+  const size_t end = std::min<size_t>(
+      mapSize_, kHeaderSize + endFrame * channels_ * sizeof(float));
+  const size_t pageEnd = end / pageSize() * pageSize();
+  if (pageEnd > released_) {
+    // 書き出しを始めてからマップを外す。汚れたページはページキャッシュに
+    // 残るので、書き込んだ内容は失われない
+    auto* begin = static_cast<uint8_t*>(map_) + released_;
+    msync(begin, pageEnd - released_, MS_ASYNC);
+    madvise(begin, pageEnd - released_, MADV_DONTNEED);
+    released_ = pageEnd;
+  }
+#else
+  (void)endFrame;
+#endif
+}
+
+// --- renderMapped ---
+
+StreamRenderResult renderMapped(MappedWavReader& input,
+                                const std::string& outputPath,
+                                const StreamRenderOptions& options) {
+  StreamRenderResult result = {false, 0, 0};
+  const size_t channels = input.getChannels();
+  if (channels == 0 || channels > MultichannelReverb::kMaxChannels) {
+    return result;
+  }
+  const uint64_t inputFrames = input.getNumFrames();
+  const uint64_t totalFrames = inputFrames + options.tailFrames;
+
+  MappedWavWriter output;
+  if (!output.create(outputPath, channels, input.getSampleRate(),
+                     totalFrames)) {
+    return result;
+  }
+
+  MultichannelReverb reverb(input.getSampleRate(), channels);
+  reverb.setWetLevel(options.wetLevel);
+  reverb.setDecay(options.decay);
+  reverb.setDamping(options.damping);
+  reverb.setWidth(options.width);
+  // 設定値をランプせずに最初から適用する
+  reverb.reset();
+
+  const size_t blockFrames = std::max<size_t>(options.blockFrames, 1);
+  const uint64_t releaseFrames =
+      std::max<uint64_t>(kReleaseBytes / (channels * sizeof(float)), 1);
+  const float* in = input.data();
+  float* out = output.data();
+
+  uint64_t nextRelease = releaseFrames;
+  for (uint64_t pos = 0; pos < totalFrames;) {
+    const size_t n =
+        static_cast<size_t>(std::min<uint64_t>(blockFrames, totalFrames - pos));
+    // 入力の範囲はマップした入力から直接、余韻の範囲は 0 で初期化済みの
+    // 出力をその場で処理する
+    const bool fromInput = pos < inputFrames;
+    const size_t frames =
+        fromInput ? static_cast<size_t>(
+                        std::min<uint64_t>(n, inputFrames - pos))
+                  : n;
+    const float* src = fromInput ? in + pos * channels : out + pos * channels;
+    reverb.processInterleaved(src, out + pos * channels, frames);
+    pos += frames;
+
+    if (pos >= nextRelease) {
+      input.release(std::min(pos, inputFrames));
+      output.release(pos);
+      nextRelease = pos + releaseFrames;
+    }
+  }
+
+  result.ok = output.close();
+  result.framesRead = inputFrames;
+  result.framesWritten = result.ok ? totalFrames : 0;
+  return result;
+}
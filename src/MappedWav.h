@@ -0,0 +1,92 @@
+#ifndef MAPPEDWAV_H
+#define MAPPEDWAV_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "StreamRenderer.h"
+
+// 32bit float の WAV ファイルをメモリマップして読み書きする
+//
+// PCM 領域をそのまま float 配列として扱うので、変換用の中間バッファが要らない。
+// 処理済みの範囲はページを手放していくので、ファイル長によらず
+// 常駐メモリ (RSS) はほぼ一定になる。
+//
+// 対応するのはリトルエンディアンの RIFF / IEEE float 32bit だけ。
+// それ以外 (16bit PCM、圧縮形式、RF64 など) や mmap のない環境では
+// open / create が false を返すので、呼び出し側は dr_wav などによる
+// バッファ経由の読み書きに切り替える。
+
+class MappedWavReader {
+ public:
+  MappedWavReader() = default;
+  ~MappedWavReader();
+  MappedWavReader(const MappedWavReader&) = delete;
+  MappedWavReader& operator=(const MappedWavReader&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+
+  // [フレーム][チャンネル] のサンプル
+  const float* data() const { return samples_; }
+  uint64_t getNumFrames() const { return numFrames_; }
+  size_t getChannels() const { return channels_; }
+  float getSampleRate() const { return sampleRate_; }
+
+  // [0, endFrame) はもう読まないので、そのページを手放す
+  void release(uint64_t endFrame);
+
+ private:
+  int fd_ = -1;
+  void* map_ = nullptr;
+  size_t mapSize_ = 0;
+  size_t dataOffset_ = 0;  // ファイル先頭から PCM 領域までのバイト数
+  size_t released_ = 0;    // 手放したバイト数 (ページ単位)
+
+  const float* samples_ = nullptr;
+  uint64_t numFrames_ = 0;
+  size_t channels_ = 0;
+  float sampleRate_ = 0.0f;
+};
+
+class MappedWavWriter {
+ public:
+  MappedWavWriter() = default;
+  ~MappedWavWriter();
+  MappedWavWriter(const MappedWavWriter&) = delete;
+  MappedWavWriter& operator=(const MappedWavWriter&) = delete;
+
+  // ヘッダを書き、numFrames 分の PCM 領域 (0 で初期化) を持つファイルを作る。
+  // 領域はディスク上に確保する。確保できなければファイルを消して false
+  bool create(const std::string& path, size_t channels, float sampleRate,
+              uint64_t numFrames);
+  // 書き出しを確定して (fsync して) 閉じる。失敗したら false
+  bool close();
+
+  float* data() { return samples_; }
+  uint64_t getNumFrames() const { return numFrames_; }
+
+  // [0, endFrame) は書き終わったので、書き出しを始めてページを手放す
+  void release(uint64_t endFrame);
+
+ private:
+  int fd_ = -1;
+  void* map_ = nullptr;
+  size_t mapSize_ = 0;
+  size_t released_ = 0;
+
+  float* samples_ = nullptr;
+  uint64_t numFrames_ = 0;
+  size_t channels_ = 0;
+};
+
+// input を MultichannelReverb で処理し、outputPath に
+// (入力 + tailFrames) フレームを書く。中間バッファを使わず、
+// マップした入力から直接マップした出力へ書き込む。
+// 出力ファイルを作れない場合は result.ok = false
+StreamRenderResult renderMapped(MappedWavReader& input,
+                                const std::string& outputPath,
+                                const StreamRenderOptions& options);
+
+#endif  // MAPPEDWAV_H
@@ -0,0 +1,242 @@
+#include "MultichannelReverb.h"
+
+#include <algorithm>
+
+#include "DenormalGuard.h"
+#include "ReverbTuning.h"
+
+using namespace reverb_tuning;
+
+namespace {
+size_t clampChannels(size_t numChannels) {
+  return std::clamp<size_t>(numChannels, 1, MultichannelReverb::kMaxChannels);
+}
+
+// wet / width から決まるミックスのゲイン
+struct MixGains {
+  float dry;     // 原音 (Reverb と同じ線形ミックス)
+  float wet1;    // 自チャンネルの残響 (Freeverb の wet1)
+  float others;  // 他チャンネルの残響の総和 (wet2 / 他チャンネル数)
+};
+
+MixGains mixGains(float wetLevel, float width, size_t numChannels) {
+  const float wet2 = wetLevel * ((1.0f - width) / 2.0f);
+  return {1.0f - wetLevel, wetLevel * (width / 2.0f + 0.5f),
+          numChannels > 1 ? wet2 / static_cast<float>(numChannels - 1)
+                          : 0.0f};
+}
+}  // namespace
+
+MultichannelReverb::MultichannelReverb(float sampleRate, size_t numChannels)
+    : sampleRate_(sampleRate),
+      numChannels_(clampChannels(numChannels)),
+      combBank_(kNumCombs,
+                delaySamples(sampleRate,
+                             kMaxCombDelayTime +
+                                 (numChannels_ - 1) * kStereoSpreadTime) +
+                    maxModulationSamples(sampleRate),
+                numChannels_),
+      wetLevel_(kDefaultWetLevel, smoothingSamples(sampleRate)),
+      width_(1.0f, smoothingSamples(sampleRate)),
+      decay_(kDefaultDecay, smoothingSamples(sampleRate)),
+      damping_(kDefaultDamping, smoothingSamples(sampleRate)),
+      modulation_(kDefaultModulation, smoothingSamples(sampleRate)),
+      wetBuffer_(numChannels_ * kMaxBlockSize, 0.0f) {
+  // チャンネル c はコム・オールパスとも c * スプレッド分だけ遅延を伸ばす
+  float maxAllpassDelayTime =
+      *std::max_element(std::begin(kAllpassDelayTimes),
+                        std::end(kAllpassDelayTimes)) +
+      (numChannels_ - 1) * kStereoSpreadTime;
+  int maxAllpassSamples =
+      static_cast<int>(sampleRate_ * (maxAllpassDelayTime + 0.01f));
+
+  allpassFilters_.reserve(numChannels_ * kNumAllpasses);
+  for (size_t ch = 0; ch < numChannels_; ++ch) {
+    const float spread = ch * kStereoSpreadTime;
+    for (size_t i = 0; i < kNumCombs; ++i) {
+      combBank_.setDelaySamples(
+          i, delaySamples(sampleRate_, kCombDelayTimes[i] + spread), ch);
+    }
+    for (const float delay : kAllpassDelayTimes) {
+      allpassFilters_.emplace_back(sampleRate_, delay + spread, kAllpassGain,
+                                   maxAllpassSamples);
+    }
+  }
+
+  // 初期パラメータを適用
+  reset();
+}
+
+void MultichannelReverb::processPlanar(const float* const* inputs,
+                                       float* const* outputs,
+                                       size_t numFrames) {
+  process(inputs, 1, outputs, 1, numFrames);
+}
+
+void MultichannelReverb::processInterleaved(const float* input, float* output,
+                                            size_t numFrames) {
+  // チャンネル ch の先頭を指し、ストライド numChannels_ で進める
+  const float* inputs[kMaxChannels];
+  float* outputs[kMaxChannels];
+  for (size_t ch = 0; ch < numChannels_; ++ch) {
+    inputs[ch] = input + ch;
+    outputs[ch] = output + ch;
+  }
+  process(inputs, numChannels_, outputs, numChannels_, numFrames);
+}
+
+void MultichannelReverb::process(const float* const* inputs,
+                                 size_t inputStride, float* const* outputs,
+                                 size_t outputStride, size_t numFrames) {
+  const DenormalGuard denormalGuard;
+  const float* in[kMaxChannels];
+  float* out[kMaxChannels];
+  float* wet[kMaxChannels];
+  for (size_t ch = 0; ch < numChannels_; ++ch) {
+    wet[ch] = wetBuffer_.data() + ch * kMaxBlockSize;
+  }
+
+  // 別スレッドで設定された目標値は、ブロックの先頭でまとめて取り込む
+  wetLevel_.pollTarget();
+  width_.pollTarget();
+  decay_.pollTarget();
+  damping_.pollTarget();
+  modulation_.pollTarget();
+
+  size_t offset = 0;
+  while (offset < numFrames) {
+    // decay / damping / modulation の変化中は段の境目でブロックを区切る
+    // (Reverb と同じ)
+    const size_t n = std::min(
+        {numFrames - offset, kMaxBlockSize,
+         decay_.samplesUntilNextStep(kSmoothingStepSize),
+         damping_.samplesUntilNextStep(kSmoothingStepSize),
+         modulation_.samplesUntilNextStep(kSmoothingStepSize)});
+    updateCombParameters();
+    updateModulation();
+    for (size_t ch = 0; ch < numChannels_; ++ch) {
+      in[ch] = inputs[ch] + offset * inputStride;
+      out[ch] = outputs[ch] + offset * outputStride;
+    }
+
+    // 全チャンネルのコムフィルタを1パスで処理する
+    combBank_.process(in, inputStride, wet, 1, n);
+    decay_.advance(n);
+    damping_.advance(n);
+    modulation_.advance(n);
+
+    for (size_t ch = 0; ch < numChannels_; ++ch) {
+      for (size_t i = 0; i < n; ++i) {
+        wet[ch][i] *= kCombMixGain;
+      }
+      for (size_t a = 0; a < kNumAllpasses; ++a) {
+        allpassFilters_[ch * kNumAllpasses + a].process(wet[ch], wet[ch], n);
+      }
+    }
+
+    // wet / width の変化中はサンプルごとにゲインを補間する
+    const bool ramping = wetLevel_.isRamping() || width_.isRamping();
+    MixGains gains =
+        mixGains(wetLevel_.getCurrent(), width_.getCurrent(), numChannels_);
+
+    for (size_t i = 0; i < n; ++i) {
+      if (ramping) {
+        gains = mixGains(wetLevel_.advance(1), width_.advance(1), numChannels_);
+      }
+      float total = 0.0f;
+      for (size_t ch = 0; ch < numChannels_; ++ch) {
+        total += wet[ch][i];
+      }
+      for (size_t ch = 0; ch < numChannels_; ++ch) {
+        const float own = wet[ch][i];
+        const size_t index = i * inputStride;
+        out[ch][i * outputStride] = gains.dry * in[ch][index] +
+                                    gains.wet1 * own +
+                                    gains.others * (total - own);
+      }
+    }
+    offset += n;
+  }
+}
+
+void MultichannelReverb::reset() {
+  // 無音から始めるので、パラメータはランプせずに目標値へ切り替える
+  wetLevel_.snap();
+  width_.snap();
+  decay_.snap();
+  damping_.snap();
+  modulation_.snap();
+  applyCombParameters(decay_.getCurrent(), damping_.getCurrent());
+  // LFO は reset 時の周波数で最初のセグメントを作るので、先に設定する
+  // (Reverb と同じ)
+  applyModulation(modulation_.getCurrent());
+  combBank_.reset();
+  for (auto& ap : allpassFilters_) {
+    ap.reset();
+  }
+}
+
+void MultichannelReverb::setWetLevel(float level) {
+  wetLevel_.setTarget(std::max(0.0f, std::min(1.0f, level)));
+}
+
+void MultichannelReverb::setDecay(float decay) {
+  decay_.setTarget(std::max(0.0f, std::min(1.0f, decay)));
+}
+
+void MultichannelReverb::setDamping(float damping) {
+  damping_.setTarget(std::max(0.0f, std::min(1.0f, damping)));
+}
+
+void MultichannelReverb::setModulation(float modulation) {
+  modulation_.setTarget(std::max(0.0f, std::min(1.0f, modulation)));
+}
+
+void MultichannelReverb::setWidth(float width) {
+  width_.setTarget(std::max(0.0f, std::min(1.0f, width)));
+}
+
+void MultichannelReverb::updateCombParameters() {
+  const float decay = decay_.getSteppedValue(kSmoothingStepSize);
+  const float damping = damping_.getSteppedValue(kSmoothingStepSize);
+  if (decay != combDecay_ || damping != combDamping_) {
+    applyCombParameters(decay, damping);
+  }
+}
+
+void MultichannelReverb::applyCombParameters(float decay, float damping) {
+  for (size_t ch = 0; ch < numChannels_; ++ch) {
+    for (size_t i = 0; i < kNumCombs; ++i) {
+      combBank_.setGain(i, combGain(decay, i), ch);
+      combBank_.setDamping(i, damping, ch);
+    }
+  }
+  combDecay_ = decay;
+  combDamping_ = damping;
+}
+
+void MultichannelReverb::updateModulation() {
+  const float modulation = modulation_.getSteppedValue(kSmoothingStepSize);
+  if (modulation != appliedModulation_) {
+    applyModulation(modulation);
+  }
+}
+
+void MultichannelReverb::applyModulation(float modulation) {
+  // チャンネルごとに LFO の速さを変えて、チャンネル間でも揺れを揃えない
+  // (チャンネル0は Reverb と同じ)
+  const float depth = modulation * kMaxModulationTime * sampleRate_;
+  for (size_t ch = 0; ch < numChannels_; ++ch) {
+    const float rateScale = 1.0f + kModulationRateSpread * ch;
+    for (size_t i = 0; i < kNumCombs; ++i) {
+      combBank_.setModulation(
+          i, depth, kCombModulationRates[i] * rateScale / sampleRate_, ch);
+    }
+    for (size_t a = 0; a < kNumAllpasses; ++a) {
+      allpassFilters_[ch * kNumAllpasses + a].setModulation(
+          depth * kAllpassModulationRatio,
+          kAllpassModulationRates[a] * rateScale);
+    }
+  }
+  appliedModulation_ = modulation;
+}
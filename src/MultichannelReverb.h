@@ -0,0 +1,70 @@
+#ifndef MULTICHANNELREVERB_H
+#define MULTICHANNELREVERB_H
+
+#include <cstddef>
+#include <vector>
+
+#include "AllpassFilter.h"
+#include "CombBank.h"
+#include "SmoothedParameter.h"
+
+// マルチチャンネル (ステレオ / 5.1 など) の Schroeder リバーブ
+// Freeverb と同様に、チャンネルごとにコム・オールパスの遅延を
+// ステレオスプレッド分ずつずらして、チャンネル間の残響を無相関にする。
+// 全チャンネルのコムフィルタは1つの CombBank に並べて、1回のパスで処理する。
+class MultichannelReverb {
+ public:
+  static constexpr size_t kMaxChannels = CombBank::kMaxChannels;
+
+  MultichannelReverb(float sampleRate, size_t numChannels);
+
+  // 非インターリーブ: inputs[ch] / outputs[ch] がチャンネルごとの配列
+  void processPlanar(const float* const* inputs, float* const* outputs,
+                     size_t numFrames);
+  // インターリーブ: LRLR... の順。input と output は同じバッファでもよい
+  void processInterleaved(const float* input, float* output,
+                          size_t numFrames);
+  void reset();
+
+  // Reverb と同じく、パラメータの設定は別スレッドから呼んでよい
+  // (目標値を atomic に書き、音声スレッドがランプで追従する)
+  void setWetLevel(float level);   // 0.0 (dry) to 1.0 (wet)
+  void setDecay(float decay);      // 0.0 (short) to 1.0 (long)
+  void setDamping(float damping);  // 0.0 (bright) to 1.0 (dark)
+  void setModulation(float modulation);  // 0.0 (なし) to 1.0 (Reverb と同じ)
+  // 0.0 (全チャンネルの残響を均等に混ぜる) to 1.0 (チャンネルごとに独立)
+  void setWidth(float width);
+
+  size_t getNumChannels() const { return numChannels_; }
+
+ private:
+  // チャンネルごとの先頭ポインタとストライドで処理する (入出力のコピーなし)
+  void process(const float* const* inputs, size_t inputStride,
+               float* const* outputs, size_t outputStride, size_t numFrames);
+  void updateCombParameters();
+  void applyCombParameters(float decay, float damping);
+  void updateModulation();
+  void applyModulation(float modulation);
+
+  float sampleRate_;
+  size_t numChannels_;
+
+  CombBank combBank_;  // 全チャンネル x 4コム
+  std::vector<AllpassFilter> allpassFilters_;  // [チャンネル][段]
+
+  SmoothedParameter wetLevel_;
+  SmoothedParameter width_;  // Freeverb の wet1 / wet2 の配分
+  SmoothedParameter decay_;
+  SmoothedParameter damping_;
+  // コムフィルタに反映済みの decay / damping
+  float combDecay_ = 0.0f;
+  float combDamping_ = 0.0f;
+  SmoothedParameter modulation_;
+  float appliedModulation_ = 0.0f;  // コム・オールパスに反映済みの値
+
+  // 内部で一度に処理する最大ブロック長。これより長い入力は分割する
+  static constexpr size_t kMaxBlockSize = 256;
+  std::vector<float> wetBuffer_;  // [チャンネル][kMaxBlockSize]
+};
+
+#endif  // MULTICHANNELREVERB_H
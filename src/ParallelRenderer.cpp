@@ -0,0 +1,150 @@
+#include "ParallelRenderer.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// 短時間で済むはずの待ち。しばらく回してからスレッドを譲る
+template <typename Done>
+void spinUntil(Done done) {
+  for (int spins = 0; !done(); ++spins) {
+    if (spins >= 64) {
+      std::this_thread::yield();
+    }
+  }
+}
+}  // namespace
+
+ParallelRenderer::ParallelRenderer(size_t numThreads, float sampleRate)
+    : numThreads_(numThreads > 0
+                      ? numThreads
+                      : std::max(1u, std::thread::hardware_concurrency())),
+      sampleRate_(sampleRate),
+      queues_(new Queue[numThreads_]) {
+  threads_.reserve(numThreads_ - 1);
+  for (size_t worker = 1; worker < numThreads_; ++worker) {
+    threads_.emplace_back(&ParallelRenderer::workerLoop, this, worker);
+  }
+}
+
+ParallelRenderer::~ParallelRenderer() {
+  spinUntil(
+      [this] { return busyWorkers_.load(std::memory_order_acquire) == 0; });
+  stop_.store(true, std::memory_order_relaxed);
+  generation_.fetch_add(1, std::memory_order_release);
+  generation_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ParallelRenderer::render(Reverb* const* instances,
+                              const float* const* inputs,
+                              float* const* outputs, size_t numInstances,
+                              size_t numSamples) {
+  const auto start = std::chrono::steady_clock::now();
+
+  // 前のブロックのワーカーが全員抜けてからキューを書き換える
+  spinUntil(
+      [this] { return busyWorkers_.load(std::memory_order_acquire) == 0; });
+
+  job_ = {instances, inputs, outputs, numSamples};
+  // インスタンスをワーカー数で均等に分ける
+  for (size_t worker = 0; worker < numThreads_; ++worker) {
+    const auto begin =
+        static_cast<uint32_t>(numInstances * worker / numThreads_);
+    const auto end =
+        static_cast<uint32_t>(numInstances * (worker + 1) / numThreads_);
+    queues_[worker].range.store(packRange(begin, end),
+                                std::memory_order_relaxed);
+  }
+  remaining_.store(numInstances, std::memory_order_relaxed);
+
+  if (numThreads_ > 1 && numInstances > 0) {
+    busyWorkers_.store(numThreads_ - 1, std::memory_order_relaxed);
+    generation_.fetch_add(1, std::memory_order_release);
+    generation_.notify_all();
+  }
+
+  runTasks(0);
+  // 盗まれた分が終わるのを待つ
+  spinUntil(
+      [this] { return remaining_.load(std::memory_order_acquire) == 0; });
+
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  blocks_.increment();
+  if (elapsed.count() > static_cast<double>(numSamples) / sampleRate_) {
+    deadlineMisses_.increment();
+  }
+}
+
+void ParallelRenderer::workerLoop(size_t worker) {
+  uint32_t seen = 0;
+  while (true) {
+    generation_.wait(seen, std::memory_order_acquire);
+    seen = generation_.load(std::memory_order_acquire);
+    if (stop_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    runTasks(worker);
+    busyWorkers_.fetch_sub(1, std::memory_order_release);
+  }
+}
+
+void ParallelRenderer::runTasks(size_t worker) {
+  const Job& job = job_;
+  uint32_t index;
+  while (true) {
+    while (popOwn(worker, index)) {
+      job.instances[index]->process(job.inputs[index], job.outputs[index],
+                                    job.numSamples);
+      remaining_.fetch_sub(1, std::memory_order_release);
+    }
+    if (!steal(worker)) {
+      return;
+    }
+  }
+}
+
+bool ParallelRenderer::popOwn(size_t worker, uint32_t& index) {
+  std::atomic<uint64_t>& range = queues_[worker].range;
+  uint64_t current = range.load(std::memory_order_acquire);
+  while (true) {
+    const auto begin = static_cast<uint32_t>(current);
+    const auto end = static_cast<uint32_t>(current >> 32);
+    if (begin >= end) {
+      return false;
+    }
+    if (range.compare_exchange_weak(current, packRange(begin + 1, end),
+                                    std::memory_order_acq_rel)) {
+      index = begin;
+      return true;
+    }
+  }
+}
+
+bool ParallelRenderer::steal(size_t worker) {
+  for (size_t k = 1; k < numThreads_; ++k) {
+    std::atomic<uint64_t>& victim =
+        queues_[(worker + k) % numThreads_].range;
+    uint64_t current = victim.load(std::memory_order_acquire);
+    while (true) {
+      const auto begin = static_cast<uint32_t>(current);
+      const auto end = static_cast<uint32_t>(current >> 32);
+      if (begin >= end) {
+        break;
+      }
+      // 残りの後ろ半分 (切り上げ) をもらう
+      const uint32_t split = end - (end - begin + 1) / 2;
+      if (victim.compare_exchange_weak(current, packRange(begin, split),
+                                       std::memory_order_acq_rel)) {
+        // 自分の範囲は空なので、他のワーカーが同時に書き換えることはない
+        queues_[worker].range.store(packRange(split, end),
+                                    std::memory_order_release);
+        return true;
+      }
+    }
+  }
+  return false;
+}
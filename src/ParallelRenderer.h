@@ -0,0 +1,97 @@
+#ifndef PARALLELRENDERER_H
+#define PARALLELRENDERER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "RelaxedCounter.h"
+#include "Reverb.h"
+
+// 多数の独立した Reverb インスタンスを、固定数のワーカースレッドで
+// 1ブロックずつ並列に処理するレンダラ
+//
+// render() を呼んだスレッドもワーカー0として処理に加わる。
+// インスタンスの番号範囲を各ワーカーに均等に割り当て、自分の範囲が
+// 空になったワーカーは他のワーカーの範囲の後ろ半分を盗む (work-stealing)。
+// 範囲 [begin, end) は 64bit の atomic 1つに詰めて CAS で更新するので、
+// 取り出しも盗みもロックを使わない。
+//
+// ブロックの完了は残りインスタンス数のカウンタで待つ (ロックフリーのバリア)。
+// スレッドとキューはコンストラクタで確保し、render() はメモリ確保も
+// mutex も使わない。ワーカーの待機は std::atomic::wait で行う。
+class ParallelRenderer {
+ public:
+  struct Stats {
+    uint32_t blocks;          // render() の呼び出し回数
+    uint32_t deadlineMisses;  // ブロックの実時間を超えた回数
+  };
+
+  // numThreads: render() を呼ぶスレッドを含むスレッド数 (0 ならコア数)
+  // sampleRate: 締め切り (numSamples / sampleRate 秒) の計算に使う
+  ParallelRenderer(size_t numThreads, float sampleRate);
+  ~ParallelRenderer();
+
+  ParallelRenderer(const ParallelRenderer&) = delete;
+  ParallelRenderer& operator=(const ParallelRenderer&) = delete;
+
+  // instances[i] に inputs[i] の numSamples サンプルを処理させ、
+  // outputs[i] に書く。全インスタンスが終わってから戻る
+  void render(Reverb* const* instances, const float* const* inputs,
+              float* const* outputs, size_t numInstances, size_t numSamples);
+
+  size_t getNumThreads() const { return numThreads_; }
+  Stats getStats() const { return {blocks_.load(), deadlineMisses_.load()}; }
+  void resetStats() {
+    blocks_.reset();
+    deadlineMisses_.reset();
+  }
+
+ private:
+  // ワーカーごとの未処理範囲 [begin, end) (下位32bit = begin, 上位 = end)
+  // 別ワーカーの範囲と同じキャッシュラインに載らないように揃える
+  struct alignas(64) Queue {
+    std::atomic<uint64_t> range{0};
+  };
+
+  struct Job {
+    Reverb* const* instances = nullptr;
+    const float* const* inputs = nullptr;
+    float* const* outputs = nullptr;
+    size_t numSamples = 0;
+  };
+
+  static uint64_t packRange(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(end) << 32) | begin;
+  }
+
+  void workerLoop(size_t worker);
+  // 自分の範囲を処理し、空になったら他から盗む。仕事がなくなったら戻る
+  void runTasks(size_t worker);
+  bool popOwn(size_t worker, uint32_t& index);
+  bool steal(size_t worker);
+
+  size_t numThreads_;
+  float sampleRate_;
+
+  std::unique_ptr<Queue[]> queues_;
+  std::vector<std::thread> threads_;
+  Job job_;
+
+  // 新しいブロックを知らせる世代番号
+  std::atomic<uint32_t> generation_{0};
+  std::atomic<bool> stop_{false};
+  // 未完了のインスタンス数。0 になったらブロック完了
+  alignas(64) std::atomic<size_t> remaining_{0};
+  // まだ runTasks の中にいるワーカー数。次のブロックはこれが0になってから
+  // 始める (前のブロックのワーカーが新しいキューに触れないように)
+  alignas(64) std::atomic<size_t> busyWorkers_{0};
+
+  RelaxedCounter blocks_;
+  RelaxedCounter deadlineMisses_;
+};
+
+#endif  // PARALLELRENDERER_H
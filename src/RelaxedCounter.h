@@ -0,0 +1,24 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// オーディオスレッドから加算し、別スレッドから読み出すためのカウンタ
+// ロックもメモリ確保もしない。DelayLine などを std::vector に入れられるよう、
+// コピー時は値を読み出して引き継ぐ。
+class RelaxedCounter {
+ public:
+  RelaxedCounter() = default;
+  RelaxedCounter(const RelaxedCounter& other) : value_(other.load()) {}
+  RelaxedCounter& operator=(const RelaxedCounter& other) {
+    value_.store(other.load(), std::memory_order_relaxed);
+    return *this;
+  }
+
+  void increment() { value_.fetch_add(1, std::memory_order_relaxed); }
+  uint32_t load() const { return value_.load(std::memory_order_relaxed); }
+  void reset() { value_.store(0, std::memory_order_relaxed); }
+
+ private:
+  static_assert(std::atomic<uint32_t>::is_always_lock_free);
+  std::atomic<uint32_t> value_{0};
+};
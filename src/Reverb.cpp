@@ -4,123 +4,362 @@
 #include <cmath>
 #include <vector>  // vectorをインクルード
 
+#include "DenormalGuard.h"
+#include "ReverbTuning.h"
+
+using namespace reverb_tuning;
+
+namespace {
+bool isQuiet(float x) { return std::abs(x) < kSilenceThreshold; }
+
+// 先頭から続く、しきい値未満のサンプル数
+size_t leadingQuietSamples(const float* x, size_t numSamples) {
+  size_t i = 0;
+  while (i < numSamples && isQuiet(x[i])) {
+    ++i;
+  }
+  return i;
+}
+
+// 末尾から続く、しきい値未満のサンプル数
+size_t trailingQuietSamples(const float* x, size_t numSamples) {
+  size_t i = numSamples;
+  while (i > 0 && isQuiet(x[i - 1])) {
+    --i;
+  }
+  return numSamples - i;
+}
+
+// コムフィルタの遅延バッファに必要なサンプル数 (変調の揺れ幅を含む)
+int maxCombDelaySamples(float sampleRate) {
+  return delaySamples(sampleRate, kMaxCombDelayTime) +
+         maxModulationSamples(sampleRate);
+}
+}  // namespace
+
 // --- コンストラクタ ---
-Reverb::Reverb(float sampleRate)
-    : sampleRate_(sampleRate), wetLevel_(0.5f), dryLevel_(0.5f), decay_(0.5f) {
-  // --- フィルタのパラメータ定義 ---
-  // コムフィルタの遅延時間 (秒)
-  const std::vector<float> combDelayTimes = {0.0297f, 0.0371f, 0.0411f,
-                                             0.0437f};
-  // オールパスフィルタの遅延時間 (秒)
-  const std::vector<float> allpassDelayTimes = {0.0098f, 0.0031f};
-  const float allpassGain = 0.7f;
-
-  // --- コムフィルタのインスタンス化 ---
-  // CombFilterの定義に合わせてインスタンスを生成
-  for (const float delay : combDelayTimes) {
-    // 初期ゲインは0.0にしておき、後でsetDecayで設定する
-    combFilters_.emplace_back(sampleRate_, delay, 0.0f, 0.4f);
-  }
-
-  // --- オールパスフィルタのインスタンス化 ---
-  // AllpassFilterの定義に合わせてインスタンスを生成
-  // オールパスフィルタに必要な最大遅延時間を計算（少し余裕を持たせる）
-  float maxAllpassDelayTime = 0.0f;
-  for (const float delay : allpassDelayTimes) {
-    if (delay > maxAllpassDelayTime) {
-      maxAllpassDelayTime = delay;
-    }
+Reverb::Reverb(float sampleRate, FloatArena* arena)
+    : sampleRate_(sampleRate),
+      maxSampleRate_(sampleRate),
+      // 4つのコムフィルタは CombBank のレーンとしてまとめて処理する
+      combBank_(kNumCombs, maxCombDelaySamples(sampleRate), 1, arena),
+      wetLevel_(kDefaultWetLevel, smoothingSamples(sampleRate)),
+      decay_(kDefaultDecay, smoothingSamples(sampleRate)),
+      damping_(kDefaultDamping, smoothingSamples(sampleRate)),
+      modulation_(kDefaultModulation, smoothingSamples(sampleRate)),
+      wetBuffer_(kMaxBlockSize, 0.0f) {
+  createAllpassFilters(arena);
+  // 遅延長などを設定し、初期パラメータを適用
+  applySampleRate();
+}
+
+size_t Reverb::requiredArenaSize(float sampleRate) {
+  size_t size = FloatArena::alignedSize(
+      CombBank::requiredSize(kNumCombs, maxCombDelaySamples(sampleRate)));
+  size += kNumAllpasses * FloatArena::alignedSize(AllpassFilter::requiredSize(
+                              maxAllpassDelaySamples(sampleRate)));
+  return size;
+}
+
+void Reverb::prepare(float maxSampleRate, size_t maxBlockSize) {
+  maxSampleRate_ = std::max(maxSampleRate, sampleRate_);
+  combBank_ =
+      CombBank(kNumCombs, maxCombDelaySamples(maxSampleRate_), 1, nullptr);
+  createAllpassFilters(nullptr);
+  wetBuffer_.assign(std::clamp<size_t>(maxBlockSize, 1, kMaxBlockSize), 0.0f);
+  applySampleRate();
+}
+
+void Reverb::setSampleRate(float sampleRate) {
+  sampleRate = std::min(sampleRate, maxSampleRate_);
+  if (sampleRate == sampleRate_) {
+    return;
   }
-  // 余裕を持って10ms追加 or 1.1倍など
-  int maxAllpassSamples =
-      static_cast<int>(sampleRate_ * (maxAllpassDelayTime + 0.01f));
+  sampleRate_ = sampleRate;
+  applySampleRate();
+}
+
+void Reverb::createAllpassFilters(FloatArena* arena) {
+  // 遅延バッファは maxSampleRate_ での最大遅延長 (少し余裕を持たせる) にする
+  const int maxAllpassSamples = maxAllpassDelaySamples(maxSampleRate_);
 
-  for (const float delay : allpassDelayTimes) {
+  allpassFilters_.clear();
+  allpassFilters_.reserve(kNumAllpasses);
+  for (const float delay : kAllpassDelayTimes) {
     allpassFilters_.emplace_back(
-        sampleRate_,       // initialSampleRate
-        delay,             // initialDelayTime
-        allpassGain,       // initialGain
-        maxAllpassSamples  // maxDelaySamplesForDelayLine
-    );
+        sampleRate_,        // initialSampleRate
+        delay,              // initialDelayTime
+        kAllpassGain,       // initialGain
+        maxAllpassSamples,  // maxDelaySamplesForDelayLine
+        arena);
   }
+}
 
-  // 初期パラメータを適用
-  setWetLevel(wetLevel_);
-  setDecay(decay_);
-  setDamping(0.4f);
+void Reverb::applySampleRate() {
+  // 遅延時間 (秒) はそのままで、サンプル数に換算し直す。
+  // コムのゲインは decay と遅延時間 (秒) から決まるので、サンプルレートに
+  // よらず同じ残響時間になる (reset() で設定し直す)
+  for (size_t i = 0; i < kNumCombs; ++i) {
+    combBank_.setDelaySamples(i,
+                              delaySamples(sampleRate_, kCombDelayTimes[i]));
+  }
+  for (size_t i = 0; i < allpassFilters_.size(); ++i) {
+    allpassFilters_[i].updateParameters(sampleRate_, kAllpassDelayTimes[i],
+                                        kAllpassGain);
+  }
+  const int rampLength = smoothingSamples(sampleRate_);
+  wetLevel_.setRampLength(rampLength);
+  decay_.setRampLength(rampLength);
+  damping_.setRampLength(rampLength);
+  modulation_.setRampLength(rampLength);
+  silenceHoldSamples_ =
+      static_cast<size_t>(std::max(silenceHoldSamples(sampleRate_), 1));
+  // LFO は reset 時の周波数で最初のセグメントを作るので、先に設定する
+  applyModulationRates();
+  // 別のレートの状態は意味がないので、無音からやり直す
   reset();
 }
 
-// --- processメソッド (変更なし) ---
+// --- processメソッド ---
 float Reverb::process(float sample) {
-  float combOutput = 0.0f;
-  for (auto& comb : combFilters_) {
-    combOutput += comb.process(sample);
+  float output;
+  process(&sample, &output, 1);
+  return output;
+}
+
+void Reverb::process(const float* input, float* output, size_t numSamples) {
+  const DenormalGuard denormalGuard;
+  // 別スレッドで設定された目標値は、ブロックの先頭でまとめて取り込む
+  // (ランプ中のパラメータだけ、チャンクごとにフィルタへ反映する)
+  wetLevel_.pollTarget();
+  if (decay_.pollTarget()) {
+    dirty_ |= kDirtyDecay;
+  }
+  if (damping_.pollTarget()) {
+    dirty_ |= kDirtyDamping;
+  }
+  if (modulation_.pollTarget()) {
+    dirty_ |= kDirtyModulation;
   }
+  profiler_.beginBlock();
+  const size_t blockSize = numSamples;
 
-  // コムフィルタの出力をミックスするゲインを適用
-  // combMixGain_ は Reverb.h で定義された定数 (例: 0.25f)
-  float mixedCombOutput = combOutput * combMixGain_;
+  while (numSamples > 0) {
+    // decay / damping / modulation の変化中は kSmoothingStepSize サンプル
+    // ごとの階段状にフィルタを更新するので、段の境目でブロックを区切る
+    size_t n = std::min(
+        {numSamples, wetBuffer_.size(),
+         decay_.samplesUntilNextStep(kSmoothingStepSize),
+         damping_.samplesUntilNextStep(kSmoothingStepSize),
+         modulation_.samplesUntilNextStep(kSmoothingStepSize)});
+    // 無音の判定の境目でも区切り、止める位置・再開する位置を
+    // 呼び出し側のブロック長によらず同じにする
+    if (silent_) {
+      const size_t quiet = leadingQuietSamples(input, n);
+      if (quiet == 0) {
+        silent_ = false;
+        silentSamples_ = 0;
+      } else {
+        n = quiet;
+      }
+    } else {
+      n = std::min(n, silenceHoldSamples_ - silentSamples_);
+    }
+    if (dirty_ != 0) {
+      updateParameters();
+    }
+    profiler_.mark();
+    float* wet = wetBuffer_.data();
 
-  float allpassOutput = mixedCombOutput;
-  for (auto& ap : allpassFilters_) {
-    allpassOutput = ap.process(allpassOutput);
+    if (silent_) {
+      // 状態は0なので、出力も0。パラメータのランプだけ進める
+      std::fill_n(wet, n, 0.0f);
+      profiler_.endStage(kStageCombs);
+    } else {
+      // 4つのコムフィルタを SIMD で同時に処理し、出力の総和を得る
+      combBank_.process(input, wet, n);
+
+      // コムフィルタの出力をミックスするゲインを適用
+      for (size_t i = 0; i < n; ++i) {
+        wet[i] *= combMixGain_;
+      }
+      profiler_.endStage(kStageCombs);
+
+      for (auto& ap : allpassFilters_) {
+        ap.process(wet, wet, n);
+      }
+      updateSilence(input, wet, n);
+      profiler_.endStage(kStageAllpasses);
+    }
+    decay_.advance(n);
+    damping_.advance(n);
+    modulation_.advance(n);
+    profiler_.mark();  // ランプの更新は段に数えない
+
+    if (wetLevel_.isRamping()) {
+      // wet / dry の変化中はサンプルごとに補間する
+      for (size_t i = 0; i < n; ++i) {
+        const float wetLevel = wetLevel_.advance(1);
+        output[i] = ((1.0f - wetLevel) * input[i]) + (wetLevel * wet[i]);
+      }
+    } else {
+      const float wetLevel = wetLevel_.getCurrent();
+      const float dryLevel = 1.0f - wetLevel;
+      for (size_t i = 0; i < n; ++i) {
+        output[i] = (dryLevel * input[i]) + (wetLevel * wet[i]);
+      }
+    }
+    profiler_.endStage(kStageMix);
+
+    input += n;
+    output += n;
+    numSamples -= n;
   }
+  profiler_.endBlock(blockSize, sampleRate_);
+}
 
-  return (dryLevel_ * sample) + (wetLevel_ * allpassOutput);
+Reverb::Stats Reverb::getStats() const {
+  const Profiler::Snapshot snapshot = profiler_.snapshot();
+  Stats stats;
+  stats.blocks = snapshot.blocks;
+  stats.samples = snapshot.samples;
+  if (snapshot.samples == 0) {
+    return stats;
+  }
+  const auto samples = static_cast<double>(snapshot.samples);
+  for (size_t s = 0; s < kNumStages; ++s) {
+    stats.stageNsPerSample[s] = snapshot.stageNs[s] / samples;
+  }
+  stats.totalNsPerSample = snapshot.totalNs / samples;
+  if (snapshot.audioNs > 0.0) {
+    stats.cpuLoadPercent = 100.0 * snapshot.totalNs / snapshot.audioNs;
+  }
+  stats.maxBlockNs = snapshot.maxBlockNs;
+  stats.maxLoadPercent = snapshot.maxLoadPercent;
+  stats.loadHistogram = snapshot.loadHistogram;
+  return stats;
 }
 
-// --- resetメソッド (変更なし) ---
-void Reverb::reset() {
-  for (auto& comb : combFilters_) {
-    comb.reset();
+void Reverb::updateSilence(const float* input, const float* wet,
+                           size_t numSamples) {
+  const size_t quiet = std::min(trailingQuietSamples(input, numSamples),
+                                trailingQuietSamples(wet, numSamples));
+  silentSamples_ = quiet == numSamples ? silentSamples_ + quiet : quiet;
+  if (silentSamples_ < silenceHoldSamples_) {
+    return;
+  }
+  // 残りの残響 (しきい値未満) を捨てる。パラメータはそのまま
+  combBank_.reset();
+  for (auto& ap : allpassFilters_) {
+    ap.reset();
   }
+  silent_ = true;
+}
+
+// --- resetメソッド ---
+void Reverb::reset() {
+  // 無音から始めるので、パラメータはランプせずに目標値へ切り替える
+  wetLevel_.snap();
+  decay_.snap();
+  damping_.snap();
+  modulation_.snap();
+  applyCombGains(decay_.getCurrent());
+  applyCombDamping(damping_.getCurrent());
+  applyModulation(modulation_.getCurrent());
+  dirty_ = 0;
+  combBank_.reset();
   for (auto& ap : allpassFilters_) {
     ap.reset();
   }
+  silent_ = true;
+  silentSamples_ = 0;
 }
 
-// --- setWetLevelメソッド (変更なし) ---
+// --- setWetLevelメソッド ---
 void Reverb::setWetLevel(float level) {
-  level = std::max(0.0f, std::min(1.0f, level));
-  wetLevel_ = level;
-  dryLevel_ = 1.0f - level;  // 線形ミックス
-  // dryLevel_ = sqrt(1.0f - (level * level)); // 等パワーミックス
+  wetLevel_.setTarget(std::max(0.0f, std::min(1.0f, level)));
+  // 線形ミックス (dry = 1 - wet)
+  // 等パワーミックスなら dry = sqrt(1.0f - (wet * wet))
 }
 
-// --- setDecayメソッド (変更なし) ---
+// --- setDecayメソッド ---
 void Reverb::setDecay(float decay) {
-  decay_ = std::max(0.0f, std::min(1.0f, decay));
+  decay_.setTarget(std::max(0.0f, std::min(1.0f, decay)));
+}
 
-  // decay (0.0-1.0) を実際のフィードバックゲインにマッピング
-  float baseGain = 0.7f + decay_ * 0.28f;  // 0.7 ~ 0.98 の範囲にマッピング
+void Reverb::setDamping(float damping) {
+  // damping の値を 0.0 から 1.0 の範囲にクリップ
+  damping_.setTarget(std::max(0.0f, std::min(1.0f, damping)));
+}
 
-  // 各コムフィルタのゲインを更新
-  std::vector<float> gainMultipliers = {1.01f, 0.98f, 0.96f, 1.02f};
-  for (size_t i = 0; i < combFilters_.size(); ++i) {
-    if (i < gainMultipliers.size()) {
-      float newGain = baseGain * gainMultipliers[i];
-      newGain = std::min(0.999f, newGain);
+void Reverb::setModulation(float modulation) {
+  modulation_.setTarget(std::max(0.0f, std::min(1.0f, modulation)));
+}
 
-      combFilters_[i].updateParameters(sampleRate_,
-                                       combFilters_[i].getDelayTime(), newGain);
+void Reverb::updateParameters() {
+  // 今の段の値が反映済みと違うものだけ計算し直す。
+  // ランプが終わっていれば最後の値 (目標値) を反映したので、フラグを下ろす
+  if (dirty_ & kDirtyDecay) {
+    const float decay = decay_.getSteppedValue(kSmoothingStepSize);
+    if (decay != combDecay_) {
+      applyCombGains(decay);
+    }
+    if (!decay_.isRamping()) {
+      dirty_ &= ~kDirtyDecay;
+    }
+  }
+  if (dirty_ & kDirtyDamping) {
+    const float damping = damping_.getSteppedValue(kSmoothingStepSize);
+    if (damping != combDamping_) {
+      applyCombDamping(damping);
+    }
+    if (!damping_.isRamping()) {
+      dirty_ &= ~kDirtyDamping;
+    }
+  }
+  if (dirty_ & kDirtyModulation) {
+    const float modulation = modulation_.getSteppedValue(kSmoothingStepSize);
+    if (modulation != appliedModulation_) {
+      applyModulation(modulation);
+    }
+    if (!modulation_.isRamping()) {
+      dirty_ &= ~kDirtyModulation;
     }
   }
 }
 
-void Reverb::setDamping(float damping) {
-  // damping_ の値を 0.0 から 1.0 の範囲にクリップ
-  damping_ = std::max(0.0f, std::min(1.0f, damping));
+void Reverb::applyCombGains(float decay) {
+  // decay (0.0-1.0) を各コムフィルタのフィードバックゲインにマッピング
+  for (size_t i = 0; i < combBank_.getNumCombs(); ++i) {
+    combBank_.setGain(i, combGain(decay, i));
+  }
+  combDecay_ = decay;
+}
 
-  // すべてのコムフィルタにダンピング値を設定
-  for (auto& comb : combFilters_) {
-    // CombFilterにupdateDampingメソッドがあると仮定
-    comb.updateDumping(damping_);
+void Reverb::applyCombDamping(float damping) {
+  for (size_t i = 0; i < combBank_.getNumCombs(); ++i) {
+    combBank_.setDamping(i, damping);
   }
+  combDamping_ = damping;
 }
-// ダンピング関連はCombFilterに実装がないためコメントアウト
-/*
-void Reverb::setDamping(float damping) {
-    // ...
+
+void Reverb::applyModulationRates() {
+  // 各線の LFO は周波数を変えて、揺れが揃わないようにする
+  for (size_t i = 0; i < combBank_.getNumCombs(); ++i) {
+    combBank_.setModulationRate(i, kCombModulationRates[i] / sampleRate_);
+  }
+  for (size_t i = 0; i < allpassFilters_.size(); ++i) {
+    allpassFilters_[i].setModulationRate(kAllpassModulationRates[i]);
+  }
+}
+
+void Reverb::applyModulation(float modulation) {
+  const float depth = modulation * kMaxModulationTime * sampleRate_;
+  for (size_t i = 0; i < combBank_.getNumCombs(); ++i) {
+    combBank_.setModulationDepth(i, depth);
+  }
+  for (auto& ap : allpassFilters_) {
+    ap.setModulationDepth(depth * kAllpassModulationRatio);
+  }
+  appliedModulation_ = modulation;
 }
-*/
\ No newline at end of file
@@ -1,37 +1,154 @@
 #ifndef REVERB_H
 #define REVERB_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "AllpassFilter.h"
-#include "CombFilter.h"
+#include "AudioEffect.h"
+#include "CombBank.h"
+#include "FloatArena.h"
+#include "ReverbTuning.h"
+#include "SmoothedParameter.h"
+#include "StageProfiler.h"
 
-class Reverb {
+class Reverb final : public AudioEffect {
  public:
-  Reverb(float sampleRate);
+  // process() の段
+  enum Stage : size_t {
+    kStageCombs,      // コムフィルタとミックスゲイン
+    kStageAllpasses,  // オールパスチェーンと無音の判定
+    kStageMix,        // wet / dry のミックス
+    kNumStages
+  };
+  using Profiler = StageProfiler<kNumStages>;
+
+  // process() の計測結果。REVERB_ENABLE_PROFILING (REVERB_PROFILING の定義)
+  // でビルドしたときだけ値が入り、無効なら全て0 (計測のコードも残らない)
+  struct Stats {
+    uint64_t blocks = 0;   // process() の回数
+    uint64_t samples = 0;  // 処理したサンプル数
+    std::array<double, kNumStages> stageNsPerSample{};
+    // process() 全体。段の合計との差はパラメータの更新や分割の分
+    double totalNsPerSample = 0.0;
+    double cpuLoadPercent = 0.0;  // 処理時間 / 処理した音声の長さ
+    double maxBlockNs = 0.0;      // 最も重かった process() の時間
+    // ブロックの締め切り (numSamples / sampleRate) に対する最大の割合
+    double maxLoadPercent = 0.0;
+    // 締め切りに対する割合 [%] のヒストグラム (区間は StageProfiler 参照)
+    std::array<uint64_t, Profiler::kNumLoadBuckets> loadHistogram{};
+  };
+  static constexpr bool kStatsEnabled = Profiler::kEnabled;
+
+  // arena を渡すと、全ての遅延バッファをそこから切り出す (ReverbPool 用)
+  Reverb(float sampleRate, FloatArena* arena = nullptr);
+
+  // 1インスタンスがアリーナから切り出す float 数
+  static size_t requiredArenaSize(float sampleRate);
+
+  // maxSampleRate までの setSampleRate に足りる遅延バッファと、
+  // maxBlockSize サンプル分の作業領域を確保し直す (状態は消える)。
+  // メモリを確保するので、音声スレッドの外で処理を始める前に呼ぶ。
+  // arena を渡していても、以後は自前のバッファを使う
+  void prepare(float maxSampleRate, size_t maxBlockSize);
+  // 遅延長・LFO・ランプの長さを新しいレートに換算し、無音からやり直す。
+  // 確保済みのバッファを使うので、メモリ確保をしない (音声スレッドから
+  // process の合間に呼んでよい)。最大のレート (コンストラクタか prepare)
+  // を超える値はそこに丸める
+  void setSampleRate(float sampleRate);
+  float getSampleRate() const { return sampleRate_; }
+  float getMaxSampleRate() const { return maxSampleRate_; }
 
   float process(float sample);
-  void reset();
+  // ブロック処理。input と output は同じバッファでもよい
+  void process(const float* input, float* output,
+               size_t numSamples) override;
+  void reset() override;
 
+  // パラメータの設定は目標値を atomic に書くだけなので、UI などの別スレッドから
+  // process と並行して呼んでよい。音声スレッドは次の process から
+  // kSmoothingTime かけて新しい値に近づける (reset 時はすぐに切り替える)
   void setWetLevel(float level);   // 0.0 (dry) to 1.0 (wet)
   void setDecay(float decay);      // 0.0 (short) to 1.0 (long)
   void setDamping(float damping);  // 0.0 (bright) to 1.0 (dark) - オプション
+  // 0.0 (変調なし) to 1.0 (コムの遅延を ±kMaxModulationTime 揺らす)
+  void setModulation(float modulation);
+
+  // 残響が鳴り終わり、コム・オールパスの処理を止めているか。
+  // 入力と wet が kSilenceThreshold 未満のまま kSilenceHoldTime 続くと止め、
+  // しきい値以上の入力が来たら reset() 直後と同じ状態から再開する
+  // (reset() 直後も止まっている)。音声スレッドから呼ぶ
+  bool isSilent() const { return silent_; }
+
+  // どのスレッドからでも呼べる。resetStats() は process() と並行して呼ぶと
+  // 処理中のブロックの分が残ることがある
+  Stats getStats() const;
+  void resetStats() { profiler_.reset(); }
 
  private:
   float sampleRate_;
+  float maxSampleRate_;  // 遅延バッファが対応する最大のサンプルレート
 
-  std::vector<CombFilter> combFilters_;
+  CombBank combBank_;  // 4つのコムフィルタ (SIMD レーン)
   std::vector<AllpassFilter> allpassFilters_;
 
-  float wetLevel_;
-  float dryLevel_;
+  // maxSampleRate_ の遅延長が収まるオールパスを作る
+  void createAllpassFilters(FloatArena* arena);
+  // sampleRate_ に合わせて遅延長などを設定し直し、reset() する
+  void applySampleRate();
+
+  // dirty_ の立っているパラメータだけ、ランプ上の値 (階段状) を
+  // フィルタに反映する
+  void updateParameters();
+  // decay はコムのゲインだけ、damping はダンピングだけを設定し直す
+  // (遅延長には触れない)
+  void applyCombGains(float decay);
+  void applyCombDamping(float damping);
+  // LFO の周波数 (サンプルレートで決まる) をコム・オールパスに設定する
+  void applyModulationRates();
+  // modulation の値をコム・オールパスの LFO の深さに反映する
+  void applyModulation(float modulation);
+  // 処理したチャンクの末尾から無音の長さを数え、保持時間に達したら止める
+  void updateSilence(const float* input, const float* wet, size_t numSamples);
 
-  // パラメータ設定用の内部変数
-  float decay_;
-  float damping_;  // オプション
+  // パラメータ (dry = 1 - wet の線形ミックス)
+  SmoothedParameter wetLevel_;
+  SmoothedParameter decay_;
+  SmoothedParameter damping_;  // オプション
+  // コムフィルタに反映済みの decay / damping
+  float combDecay_ = 0.0f;
+  float combDamping_ = 0.0f;
+  SmoothedParameter modulation_;
+  float appliedModulation_ = 0.0f;  // コム・オールパスに反映済みの値
+  // フィルタへの反映が要るパラメータ。process() の先頭で目標値を
+  // 取り込み、ランプ中なら立てる。ランプの最後の値を反映したら下ろすので、
+  // 動いていないパラメータはチャンクごとの確認もしない
+  enum DirtyFlag : uint8_t {
+    kDirtyDecay = 1 << 0,       // コムのゲイン
+    kDirtyDamping = 1 << 1,     // コムのダンピング
+    kDirtyModulation = 1 << 2,  // コム・オールパスの LFO の深さ
+  };
+  uint8_t dirty_ = 0;
 
   // 定数
-  const float combMixGain_ = 0.25f;  // コムフィルタ出力のミックスゲイン
+  // コムフィルタ出力のミックスゲイン
+  const float combMixGain_ = reverb_tuning::kCombMixGain;
+
+  // 内部で一度に処理する最大ブロック長。これより長い入力は分割する
+  static constexpr size_t kMaxBlockSize = 256;
+  // コム出力の総和 -> オールパスチェーン。
+  // 長さ (kMaxBlockSize 以下) ごとに区切って処理する
+  std::vector<float> wetBuffer_;
+
+  // 無音の検出
+  size_t silenceHoldSamples_ = 1;
+  size_t silentSamples_ = 0;  // 入力と wet が続けてしきい値未満のサンプル数
+  bool silent_ = true;        // コム・オールパスの処理を止めているか
+
+  // 計測が無効なら空のクラスなので、大きさも0になる
+  [[no_unique_address]] Profiler profiler_;
 };
 
 #endif  // REVERB_H
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "ReverbPool.h"
+
+#include "ReverbTuning.h"
+
+ReverbPool::ReverbPool(float sampleRate, size_t capacity)
+    : arena_(capacity * Reverb::requiredArenaSize(sampleRate)),
+      active_(capacity, 0),
+      numActive_(0) {
+  instances_.reserve(capacity);
+  for (size_t i = 0; i < capacity; ++i) {
+    instances_.emplace_back(sampleRate, &arena_);
+  }
+  // ハンドルの小さい順 (アリーナ上の並び順) に払い出す
+  freeList_.reserve(capacity);
+  for (size_t i = capacity; i > 0; --i) {
+    freeList_.push_back(static_cast<Handle>(i - 1));
+  }
+}
+
+ReverbPool::Handle ReverbPool::acquire() {
+  if (freeList_.empty()) {
+    return kInvalidHandle;
+  }
+  const Handle handle = freeList_.back();
+  freeList_.pop_back();
+  active_[handle] = 1;
+  ++numActive_;
+
+  // 前の利用者の残響とパラメータを引き継がない
+  Reverb& reverb = instances_[handle];
+  reverb.setWetLevel(reverb_tuning::kDefaultWetLevel);
+  reverb.setDecay(reverb_tuning::kDefaultDecay);
+  reverb.setDamping(reverb_tuning::kDefaultDamping);
+  reverb.setModulation(reverb_tuning::kDefaultModulation);
+  reverb.reset();
+  return handle;
+}
+
+void ReverbPool::release(Handle handle) {
+  if (!isActive(handle)) {
+    return;
+  }
+  active_[handle] = 0;
+  --numActive_;
+  // capacity 分 reserve 済みなので push_back でメモリ確保は起きない
+  freeList_.push_back(handle);
+}
+
+void ReverbPool::processActive(const float* const* inputs,
+                               float* const* outputs, size_t numSamples) {
+  for (size_t i = 0; i < instances_.size(); ++i) {
+    if (active_[i]) {
+      instances_[i].process(inputs[i], outputs[i], numSamples);
+    }
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef REVERBPOOL_H
+#define REVERBPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "FloatArena.h"
+#include "Reverb.h"
+
+// 多数の Reverb インスタンス (ゲームのエミッタごとの残響など) を
+// まとめて持つプール。
+// 全インスタンスの遅延バッファを、設定した遅延長ぴったりに計算した
+// 1つのアリーナから切り出す。インスタンスはアリーナ上で連続して並び、
+// processActive はその順に処理するのでキャッシュの局所性が高い。
+//
+// 全インスタンスはコンストラクタで構築しておくので、
+// acquire / release はメモリ確保をしない (オーディオスレッドから呼んでよい)。
+class ReverbPool {
+ public:
+  using Handle = uint32_t;
+  static constexpr Handle kInvalidHandle = UINT32_MAX;
+
+  ReverbPool(float sampleRate, size_t capacity);
+
+  // 無音・初期パラメータの状態のインスタンスを返す。空きがなければ
+  // kInvalidHandle
+  Handle acquire();
+  void release(Handle handle);
+
+  Reverb& get(Handle handle) { return instances_[handle]; }
+  bool isActive(Handle handle) const {
+    return handle < active_.size() && active_[handle];
+  }
+
+  // 使用中の全インスタンスを処理する。
+  // inputs[handle] / outputs[handle] がそのインスタンスの入出力
+  // (使用中でないハンドルの要素は参照しない)
+  void processActive(const float* const* inputs, float* const* outputs,
+                     size_t numSamples);
+
+  size_t getCapacity() const { return instances_.size(); }
+  size_t getNumActive() const { return numActive_; }
+  const FloatArena& getArena() const { return arena_; }
+
+ private:
+  FloatArena arena_;  // instances_ より先に構築・後に破棄する
+  std::vector<Reverb> instances_;
+  std::vector<Handle> freeList_;  // 末尾から取り出す
+  std::vector<uint8_t> active_;
+  size_t numActive_;
+};
+
+#endif  // REVERBPOOL_H
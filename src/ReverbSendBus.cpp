@@ -0,0 +1,165 @@
+#include "ReverbSendBus.h"
+
+#include <algorithm>
+
+#include "ReverbTuning.h"
+
+namespace {
+
+// out[i] += sum_k gains[k] * inputs[k][offset + i]
+// 4ソースずつまとめて足し、out の読み書きを 1/4 にする
+// (内側のループはベクトル化される)
+void mixSends(float* out, const float* const* inputs, const float* gains,
+              size_t numInputs, size_t offset, size_t numSamples) {
+  size_t k = 0;
+  for (; k + 4 <= numInputs; k += 4) {
+    const float* x0 = inputs[k] + offset;
+    const float* x1 = inputs[k + 1] + offset;
+    const float* x2 = inputs[k + 2] + offset;
+    const float* x3 = inputs[k + 3] + offset;
+    const float g0 = gains[k], g1 = gains[k + 1];
+    const float g2 = gains[k + 2], g3 = gains[k + 3];
+    for (size_t i = 0; i < numSamples; ++i) {
+      out[i] += (g0 * x0[i] + g1 * x1[i]) + (g2 * x2[i] + g3 * x3[i]);
+    }
+  }
+  for (; k < numInputs; ++k) {
+    const float* x = inputs[k] + offset;
+    const float g = gains[k];
+    for (size_t i = 0; i < numSamples; ++i) {
+      out[i] += g * x[i];
+    }
+  }
+}
+
+}  // namespace
+
+ReverbSendBus::ReverbSendBus(float sampleRate, size_t numBuses,
+                             size_t maxSources, float maxPreDelay)
+    : sampleRate_(sampleRate),
+      maxPreDelaySamples_(
+          reverb_tuning::delaySamples(sampleRate, std::max(maxPreDelay, 0.0f))),
+      sources_(maxSources),
+      mix_(kChunkSize, 0.0f),
+      delayed_(kChunkSize, 0.0f),
+      directInputs_(maxSources, nullptr),
+      directGains_(maxSources, 0.0f) {
+  reverbs_.reserve(numBuses);
+  for (size_t b = 0; b < numBuses; ++b) {
+    reverbs_.emplace_back(sampleRate);
+    reverbs_.back().setWetLevel(1.0f);
+    reverbs_.back().reset();
+  }
+  if (maxPreDelaySamples_ > 0) {
+    // 読み出し位置の先に (最大のプリディレイ + 1チャンク) の無音を置き、
+    // そこに足し込む
+    const int length = maxPreDelaySamples_ + static_cast<int>(kChunkSize);
+    preDelayLines_.reserve(numBuses);
+    for (size_t b = 0; b < numBuses; ++b) {
+      preDelayLines_.emplace_back(length, length + 1);
+    }
+  }
+  activeSources_.reserve(maxSources);
+  freeList_.reserve(maxSources);
+  for (size_t i = maxSources; i > 0; --i) {
+    freeList_.push_back(static_cast<SourceId>(i - 1));
+  }
+}
+
+ReverbSendBus::SourceId ReverbSendBus::addSource(size_t bus, float sendGain,
+                                                 float preDelay) {
+  if (freeList_.empty() || bus >= reverbs_.size()) {
+    return kInvalidSource;
+  }
+  const SourceId id = freeList_.back();
+  freeList_.pop_back();
+  Source& source = sources_[id];
+  source.bus = static_cast<uint32_t>(bus);
+  source.active = true;
+  source.activeIndex = static_cast<uint32_t>(activeSources_.size());
+  activeSources_.push_back(id);
+  setSendGain(id, sendGain);
+  setPreDelay(id, preDelay);
+  return id;
+}
+
+void ReverbSendBus::removeSource(SourceId id) {
+  if (id >= sources_.size() || !sources_[id].active) {
+    return;
+  }
+  // 末尾のソースを空いた位置に移す
+  Source& source = sources_[id];
+  const SourceId last = activeSources_.back();
+  activeSources_[source.activeIndex] = last;
+  sources_[last].activeIndex = source.activeIndex;
+  activeSources_.pop_back();
+  source.active = false;
+  freeList_.push_back(id);
+}
+
+void ReverbSendBus::setSendGain(SourceId id, float sendGain) {
+  if (id < sources_.size()) {
+    sources_[id].sendGain = sendGain;
+  }
+}
+
+void ReverbSendBus::setPreDelay(SourceId id, float preDelay) {
+  if (id < sources_.size()) {
+    sources_[id].preDelaySamples =
+        std::clamp(reverb_tuning::delaySamples(sampleRate_, preDelay), 0,
+                   maxPreDelaySamples_);
+  }
+}
+
+void ReverbSendBus::process(const float* const* inputs, float* const* outputs,
+                            size_t numSamples) {
+  for (size_t offset = 0; offset < numSamples; offset += kChunkSize) {
+    const size_t n = std::min(kChunkSize, numSamples - offset);
+    for (size_t b = 0; b < reverbs_.size(); ++b) {
+      processBus(b, inputs, offset, n);
+      reverbs_[b].process(mix_.data(), outputs[b] + offset, n);
+    }
+  }
+}
+
+void ReverbSendBus::processBus(size_t bus, const float* const* inputs,
+                               size_t offset, size_t numSamples) {
+  // プリディレイのないソースを集めてまとめて足し、残りは遅延線に足し込む
+  std::fill_n(mix_.begin(), numSamples, 0.0f);
+  DelayLine* line = preDelayLines_.empty() ? nullptr : &preDelayLines_[bus];
+  size_t numDirect = 0;
+  for (const SourceId id : activeSources_) {
+    const Source& source = sources_[id];
+    if (source.bus != bus) {
+      continue;
+    }
+    if (source.preDelaySamples == 0) {
+      directInputs_[numDirect] = inputs[id];
+      directGains_[numDirect] = source.sendGain;
+      ++numDirect;
+    } else {
+      line->addAt(source.preDelaySamples, source.sendGain, inputs[id] + offset,
+                  numSamples);
+    }
+  }
+  mixSends(mix_.data(), directInputs_.data(), directGains_.data(), numDirect,
+           offset, numSamples);
+
+  if (line != nullptr) {
+    // 前のブロックまでに足し込んだ分も、ソースの有無によらず読み進める
+    line->read(delayed_.data(), numSamples);
+    line->writeSilence(numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      mix_[i] += delayed_[i];
+    }
+  }
+}
+
+void ReverbSendBus::reset() {
+  for (Reverb& reverb : reverbs_) {
+    reverb.reset();
+  }
+  for (DelayLine& line : preDelayLines_) {
+    line.clear();
+  }
+}
@@ -0,0 +1,83 @@
+#ifndef REVERBSENDBUS_H
+#define REVERBSENDBUS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "DelayLine.h"
+#include "Reverb.h"
+
+// 多数のソース (ゲームのエミッタなど) を少数の共有 Reverb に送るセンドバス
+//
+// コム・オールパスの網は線形なので、ソースごとに Reverb を持つ代わりに
+// sum(sendGain_i * source_i) を1つの Reverb に通しても同じ残響になる。
+// Reverb の処理はバスの数だけで、ソース数には比例しない
+// (ソース数に比例するのはセンドのミックスだけ)。
+//
+// ソースごとのプリディレイは、バスごとに1本の遅延線へ送り側のマルチタップ
+// (DelayLine::addAt) で足し込んで掛ける。プリディレイのないソースは
+// 遅延線を通さず、4ソースずつまとめて足すミックスのカーネルで足す。
+//
+// 全てのバッファはコンストラクタで確保するので、addSource / removeSource /
+// process はメモリ確保をしない (音声スレッドから呼ぶ)。
+class ReverbSendBus {
+ public:
+  using SourceId = uint32_t;
+  static constexpr SourceId kInvalidSource = UINT32_MAX;
+
+  // numBuses 個の Reverb (wet のみを出す) と、maxSources 個のソースの枠を
+  // 用意する。プリディレイは maxPreDelay 秒まで
+  ReverbSendBus(float sampleRate, size_t numBuses, size_t maxSources,
+                float maxPreDelay = 0.1f);
+
+  // bus に送るソースを加える。枠がなければ kInvalidSource
+  SourceId addSource(size_t bus, float sendGain, float preDelay = 0.0f);
+  void removeSource(SourceId source);
+  // ブロックの合間に呼ぶ。プリディレイは [0, maxPreDelay] に丸める
+  void setSendGain(SourceId source, float sendGain);
+  void setPreDelay(SourceId source, float preDelay);
+
+  // パラメータ (decay など) はバスの Reverb に直接設定する
+  Reverb& getReverb(size_t bus) { return reverbs_[bus]; }
+  size_t getNumBuses() const { return reverbs_.size(); }
+  size_t getNumSources() const { return activeSources_.size(); }
+  size_t getMaxSources() const { return sources_.size(); }
+
+  // inputs[id] がソース id のブロック (使っていない id の要素は参照しない)。
+  // outputs[bus] にバスの残響 (wet) を書く
+  void process(const float* const* inputs, float* const* outputs,
+               size_t numSamples);
+  void reset();
+
+ private:
+  // 一度に処理する最大サンプル数 (作業領域と遅延線の余裕の長さ)
+  static constexpr size_t kChunkSize = 256;
+
+  struct Source {
+    uint32_t bus = 0;
+    float sendGain = 0.0f;
+    int preDelaySamples = 0;
+    uint32_t activeIndex = 0;  // activeSources_ の中の位置
+    bool active = false;
+  };
+
+  void processBus(size_t bus, const float* const* inputs, size_t offset,
+                  size_t numSamples);
+
+  float sampleRate_;
+  int maxPreDelaySamples_;
+  std::vector<Reverb> reverbs_;
+  std::vector<DelayLine> preDelayLines_;  // バスごと (プリディレイが0なら空)
+  std::vector<Source> sources_;
+  std::vector<SourceId> activeSources_;  // 使用中のソース (順不同)
+  std::vector<SourceId> freeList_;       // 末尾から取り出す
+
+  // 作業領域
+  std::vector<float> mix_;                  // バスの入力 (センドの総和)
+  std::vector<float> delayed_;              // 遅延線の出力
+  std::vector<const float*> directInputs_;  // プリディレイのないソース
+  std::vector<float> directGains_;
+};
+
+#endif  // REVERBSENDBUS_H
@@ -0,0 +1,138 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+
+// Reverb / MultichannelReverb で共有するチューニング定数
+namespace reverb_tuning {
+
+// コムフィルタの遅延時間 (秒)
+inline constexpr float kCombDelayTimes[] = {0.0297f, 0.0371f, 0.0411f,
+                                            0.0437f};
+inline constexpr size_t kNumCombs = std::size(kCombDelayTimes);
+inline constexpr float kMaxCombDelayTime = *std::max_element(
+    std::begin(kCombDelayTimes), std::end(kCombDelayTimes));
+
+// コムフィルタごとのフィードバックゲインの倍率
+inline constexpr float kCombGainMultipliers[kNumCombs] = {1.01f, 0.98f, 0.96f,
+                                                          1.02f};
+
+// オールパスフィルタの遅延時間 (秒) とゲイン
+inline constexpr float kAllpassDelayTimes[] = {0.0098f, 0.0031f};
+inline constexpr size_t kNumAllpasses = std::size(kAllpassDelayTimes);
+inline constexpr float kAllpassGain = 0.7f;
+
+// AllpassDiffuser の既定の遅延時間 (秒)。numStages 段のときは先頭から使う
+// (先頭の2段は kAllpassDelayTimes と同じ)
+inline constexpr float kDiffuserDelayTimes[] = {
+    0.0098f, 0.0031f, 0.0071f, 0.0047f, 0.0059f, 0.0023f, 0.0083f, 0.0037f};
+inline constexpr size_t kMaxDiffuserStages = std::size(kDiffuserDelayTimes);
+inline constexpr float kMaxDiffuserDelayTime = *std::max_element(
+    std::begin(kDiffuserDelayTimes), std::end(kDiffuserDelayTimes));
+
+// コムフィルタ出力の総和に掛けるゲイン
+inline constexpr float kCombMixGain = 0.25f;
+
+// パラメータの初期値
+inline constexpr float kDefaultWetLevel = 0.5f;
+inline constexpr float kDefaultDecay = 0.5f;
+inline constexpr float kDefaultDamping = 0.4f;
+
+// 遅延の変調 (LFO で遅延をわずかに揺らし、金属的な響きを抑える)
+// modulation 1.0 のときのコムフィルタの揺れ幅 (秒)。オールパスはその半分
+inline constexpr float kMaxModulationTime = 0.0005f;
+inline constexpr float kAllpassModulationRatio = 0.5f;
+// LFO の周波数 (Hz)。線ごとに変えて揺れが揃わないようにする
+inline constexpr float kCombModulationRates[kNumCombs] = {0.53f, 0.61f, 0.73f,
+                                                          0.89f};
+inline constexpr float kAllpassModulationRates[kNumAllpasses] = {1.07f, 1.31f};
+// MultichannelReverb ではチャンネル c の LFO を (1 + c * この値) 倍速くする
+inline constexpr float kModulationRateSpread = 0.07f;
+inline constexpr float kDefaultModulation = 0.0f;  // 既定では変調しない
+
+// パラメータ変更時のランプの長さ (秒)。ジッパーノイズを防ぐ
+inline constexpr float kSmoothingTime = 0.02f;
+// ランプ中はこのサンプル数ごとにコムフィルタのゲイン・ダンピングを更新する
+inline constexpr int kSmoothingStepSize = 32;
+
+// 無音の判定 (Reverb)。入力と wet の絶対値がこのレベル (約 -100 dBFS) 未満の
+// 状態が kSilenceHoldTime 続いたら、残響は鳴り終わったとみなして
+// コム・オールパスの処理を止める。保持時間は最も長いコムとオールパスを
+// 一周するより長くする
+inline constexpr float kSilenceThreshold = 1e-5f;
+inline constexpr float kSilenceHoldTime = 0.1f;
+
+// FdnReverb の遅延線の遅延時間 (秒)。numLines 本のときは先頭から使う
+// (8本でも16本でも長さが散らばるよう、短いものと長いものを交互に並べる)
+inline constexpr float kFdnDelayTimes[] = {
+    0.0293f, 0.0457f, 0.0331f, 0.0509f, 0.0367f, 0.0421f, 0.0251f, 0.0547f,
+    0.0223f, 0.0473f, 0.0311f, 0.0401f, 0.0277f, 0.0437f, 0.0353f, 0.0389f};
+// decay から求めるゲインは、この長さのコムフィルタと同じ減衰時間になるよう
+// 遅延時間に応じて換算する (kCombDelayTimes の平均)
+inline constexpr float kFdnReferenceDelayTime = 0.0379f;
+
+// HybridReverb の初期反射のタップ (Moorer の 18 タップ)。時間 (秒) とゲイン
+// 時間は短い順に並べる (最後のタップが遅延線の遅延になる)
+inline constexpr float kEarlyTapTimes[] = {
+    0.0043f, 0.0215f, 0.0225f, 0.0268f, 0.0270f, 0.0298f,
+    0.0458f, 0.0485f, 0.0572f, 0.0587f, 0.0595f, 0.0612f,
+    0.0707f, 0.0708f, 0.0726f, 0.0741f, 0.0753f, 0.0797f};
+inline constexpr size_t kNumEarlyTaps = std::size(kEarlyTapTimes);
+inline constexpr float kEarlyTapGains[kNumEarlyTaps] = {
+    0.841f, 0.504f, 0.491f, 0.379f, 0.380f, 0.346f,
+    0.289f, 0.272f, 0.192f, 0.193f, 0.217f, 0.181f,
+    0.180f, 0.181f, 0.176f, 0.142f, 0.167f, 0.134f};
+// 初期反射の総和に掛けるゲイン (タップのゲインの和が約5なので)
+inline constexpr float kEarlyMixGain = 0.2f;
+inline constexpr float kDefaultEarlyLevel = 0.5f;
+
+// Freeverb のステレオスプレッド (44.1kHz で 23 サンプル)
+// チャンネル c の遅延を c * kStereoSpreadTime だけ伸ばして左右を無相関にする
+inline constexpr float kStereoSpreadTime = 23.0f / 44100.0f;
+
+// CombFilter と同じく小数点以下を切り捨ててサンプル数にする
+inline int delaySamples(float sampleRate, float delayTime) {
+  return static_cast<int>(sampleRate * delayTime);
+}
+
+// 変調で遅延が伸びる最大のサンプル数 (遅延バッファの余裕)
+inline int maxModulationSamples(float sampleRate) {
+  return static_cast<int>(sampleRate * kMaxModulationTime) + 1;
+}
+
+inline int smoothingSamples(float sampleRate) {
+  return static_cast<int>(sampleRate * kSmoothingTime);
+}
+
+inline int silenceHoldSamples(float sampleRate) {
+  return static_cast<int>(sampleRate * kSilenceHoldTime);
+}
+
+// オールパスフィルタの遅延バッファの長さ (最大遅延時間に10msの余裕を持たせる)
+inline int maxAllpassDelaySamples(float sampleRate) {
+  constexpr float kMaxAllpassDelayTime = *std::max_element(
+      std::begin(kAllpassDelayTimes), std::end(kAllpassDelayTimes));
+  return static_cast<int>(sampleRate * (kMaxAllpassDelayTime + 0.01f));
+}
+
+// decay (0.0-1.0) を、倍率 multiplier のコムフィルタのフィードバックゲインに
+// マッピング
+inline float combGainFor(float decay, float multiplier) {
+  const float baseGain = 0.7f + decay * 0.28f;  // 0.7 ~ 0.98 の範囲
+  return std::min(0.999f, baseGain * multiplier);
+}
+
+// decay (0.0-1.0) を comb 番目のコムフィルタのフィードバックゲインにマッピング
+inline float combGain(float decay, size_t comb) {
+  return combGainFor(decay, kCombGainMultipliers[comb]);
+}
+
+// decay (0.0-1.0) を、遅延 delayTime 秒の FDN の線のフィードバックゲインに
+// マッピングする。Reverb のコムフィルタと同じ残響時間になる
+inline float fdnLineGain(float decay, float delayTime) {
+  return std::pow(combGainFor(decay, 1.0f),
+                  delayTime / kFdnReferenceDelayTime);
+}
+
+}  // namespace reverb_tuning
@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
+#define SAMPLESTORAGE_X86 1
+#include <immintrin.h>
+#endif
+
+// 遅延バッファに置くサンプルの型 (Storage) と、演算の型 (Sample) の変換
+//
+//   float / double: そのまま変換する
+//   int16_t (Q15):  メモリは float の半分。キャッシュに2倍のサンプルが載る
+//   int32_t (Q31):  固定小数点の DSP と同じ形式 (メモリは float と同じ)
+//
+// 固定小数点では [-kHeadroom, kHeadroom) を整数の全範囲に割り当てる。
+// リバーブの内部 (コムの出力) は入力の数倍になるので、フルスケール 1.0 に
+// 対して kHeadroomBits ビット (約 +24 dB) の余裕を取り、超えた値は飽和させる。
+// Q15 の分解能はその分 1/2^11 になる (入力 ±1.0 に対して約 -66 dB)。
+template <typename Storage>
+struct SampleStorage {
+  static_assert(std::is_floating_point_v<Storage>,
+                "Storage は浮動小数点か int16_t / int32_t");
+
+  template <typename Sample>
+  static Sample load(Storage x) {
+    return static_cast<Sample>(x);
+  }
+  template <typename Sample>
+  static Storage store(Sample x) {
+    return static_cast<Storage>(x);
+  }
+};
+
+// 整数の固定小数点 (Q15 / Q31) の共通部分
+template <typename Int>
+struct FixedPointStorage {
+  static constexpr int kHeadroomBits = 4;
+  static constexpr double kHeadroom = 1 << kHeadroomBits;
+  // 1.0 に対応する整数値
+  static constexpr double kOne = static_cast<double>(
+      uint64_t{1} << (std::numeric_limits<Int>::digits - kHeadroomBits));
+
+  template <typename Sample>
+  static Sample load(Int x) {
+    return static_cast<Sample>(x) * static_cast<Sample>(1.0 / kOne);
+  }
+  template <typename Sample>
+  static Int store(Sample x) {
+    // Q31 は float の仮数に収まらないので、double で丸める
+    using Wide = std::conditional_t<(sizeof(Int) > 2), double, Sample>;
+    constexpr auto kMin = static_cast<Wide>(std::numeric_limits<Int>::min());
+    constexpr auto kMax = static_cast<Wide>(std::numeric_limits<Int>::max());
+    const Wide scaled = static_cast<Wide>(x) * static_cast<Wide>(kOne);
+#if defined(SAMPLESTORAGE_X86)
+    // 飽和は min / max、丸めは cvtss2si / cvtsd2si (最近接偶数) の1命令ずつ。
+    // コンパイラに任せると飽和が分岐になり、1サンプルごとに呼ぶコムの
+    // ループが数倍遅くなる
+    if constexpr (std::is_same_v<Wide, float>) {
+      const __m128 v = _mm_min_ss(
+          _mm_max_ss(_mm_set_ss(scaled), _mm_set_ss(kMin)), _mm_set_ss(kMax));
+      return static_cast<Int>(_mm_cvtss_si32(v));
+    } else {
+      const __m128d v = _mm_min_sd(
+          _mm_max_sd(_mm_set_sd(scaled), _mm_set_sd(kMin)), _mm_set_sd(kMax));
+      return static_cast<Int>(_mm_cvtsd_si32(v));
+    }
+#else
+    // 0 から遠い方へ丸める。符号は copysign で付け、分岐しない
+    const Wide clamped = std::clamp(scaled, kMin, kMax);
+    return static_cast<Int>(clamped + std::copysign(Wide(0.5), clamped));
+#endif
+  }
+};
+
+template <>
+struct SampleStorage<int16_t> : FixedPointStorage<int16_t> {};
+template <>
+struct SampleStorage<int32_t> : FixedPointStorage<int32_t> {};
+
+// ブロック単位の変換。in と out は重ならないこと
+template <typename Storage, typename Sample>
+void loadSamples(const Storage* in, Sample* out, size_t numSamples) {
+  for (size_t i = 0; i < numSamples; ++i) {
+    out[i] = SampleStorage<Storage>::template load<Sample>(in[i]);
+  }
+}
+
+template <typename Storage, typename Sample>
+void storeSamples(const Sample* in, Storage* out, size_t numSamples) {
+  size_t i = 0;
+#if defined(SAMPLESTORAGE_X86)
+  // float -> Q15 は8サンプルずつ: 飽和 (min / max) -> 丸め (cvtps2dq) ->
+  // 16ビットに詰める (packssdw)。1サンプルずつの store と同じ値になる
+  if constexpr (std::is_same_v<Storage, int16_t> &&
+                std::is_same_v<Sample, float>) {
+    using Traits = SampleStorage<int16_t>;
+    const __m128 scale = _mm_set1_ps(static_cast<float>(Traits::kOne));
+    const __m128 lo = _mm_set1_ps(static_cast<float>(INT16_MIN));
+    const __m128 hi = _mm_set1_ps(static_cast<float>(INT16_MAX));
+    for (; i + 8 <= numSamples; i += 8) {
+      const __m128 a = _mm_mul_ps(_mm_loadu_ps(in + i), scale);
+      const __m128 b = _mm_mul_ps(_mm_loadu_ps(in + i + 4), scale);
+      const __m128i qa = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(a, lo), hi));
+      const __m128i qb = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(b, lo), hi));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                       _mm_packs_epi32(qa, qb));
+    }
+  }
+#endif
+  for (; i < numSamples; ++i) {
+    out[i] = SampleStorage<Storage>::store(in[i]);
+  }
+}
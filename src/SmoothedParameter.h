@@ -0,0 +1,122 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 別スレッド (UI / オートメーション) から目標値を書き、
+// 音声スレッドが線形ランプで滑らかに追従するパラメータ
+//
+// setTarget は atomic に書くだけなので、どのスレッドからでも
+// process と並行して呼んでよい (ロックもメモリ確保もしない)。
+// それ以外のメソッドは音声スレッドからだけ呼ぶ。
+// 目標値が変わると、そのときの値から rampLength サンプルかけて近づく。
+//
+// ランプ上の値はランプ開始からのサンプル数で決まるので、
+// 処理をどんなブロック長に分けても同じ値になる。
+class SmoothedParameter {
+ public:
+  explicit SmoothedParameter(float value, int rampLength = 1)
+      : target_(value),
+        current_(value),
+        rampStart_(value),
+        rampTarget_(value),
+        step_(0.0f),
+        elapsed_(0),
+        remaining_(0),
+        rampLength_(std::max(rampLength, 1)) {}
+
+  // Reverb などを std::vector に入れられるよう、コピー時は値を引き継ぐ
+  SmoothedParameter(const SmoothedParameter& other)
+      : target_(other.getTarget()),
+        current_(other.current_),
+        rampStart_(other.rampStart_),
+        rampTarget_(other.rampTarget_),
+        step_(other.step_),
+        elapsed_(other.elapsed_),
+        remaining_(other.remaining_),
+        rampLength_(other.rampLength_) {}
+  SmoothedParameter& operator=(const SmoothedParameter& other) {
+    target_.store(other.getTarget(), std::memory_order_relaxed);
+    current_ = other.current_;
+    rampStart_ = other.rampStart_;
+    rampTarget_ = other.rampTarget_;
+    step_ = other.step_;
+    elapsed_ = other.elapsed_;
+    remaining_ = other.remaining_;
+    rampLength_ = other.rampLength_;
+    return *this;
+  }
+
+  // --- どのスレッドからでも呼べる ---
+  void setTarget(float value) {
+    target_.store(value, std::memory_order_relaxed);
+  }
+  float getTarget() const { return target_.load(std::memory_order_relaxed); }
+
+  // --- 音声スレッドのみ ---
+  void setRampLength(int samples) { rampLength_ = std::max(samples, 1); }
+
+  // ランプせずに目標値へ飛ぶ (無音からやり直す reset 時など)
+  void snap() {
+    current_ = rampStart_ = rampTarget_ = getTarget();
+    elapsed_ = 0;
+    remaining_ = 0;
+  }
+
+  // 新しい目標値があれば、今の値からランプを始める。ランプ中なら true
+  bool pollTarget() {
+    const float target = getTarget();
+    if (target != rampTarget_) {
+      rampStart_ = current_;
+      rampTarget_ = target;
+      step_ = (target - current_) / static_cast<float>(rampLength_);
+      elapsed_ = 0;
+      remaining_ = rampLength_;
+    }
+    return remaining_ > 0;
+  }
+  bool isRamping() const { return remaining_ > 0; }
+
+  // numSamples 進めた後の値を返す
+  float advance(size_t numSamples) {
+    const int n = static_cast<int>(std::min<size_t>(numSamples, remaining_));
+    elapsed_ += n;
+    remaining_ -= n;
+    current_ = remaining_ > 0 ? valueAt(elapsed_) : rampTarget_;
+    return current_;
+  }
+
+  // stepSize サンプルごとの階段状に変化させる場合の、今の段の値
+  // (ランプ開始から stepSize の倍数の位置の値。ランプ後は目標値)
+  float getSteppedValue(int stepSize) const {
+    return remaining_ > 0 ? valueAt(elapsed_ / stepSize * stepSize)
+                          : rampTarget_;
+  }
+  // 今の段の残りサンプル数 (ランプ中でなければ制限なし)
+  size_t samplesUntilNextStep(int stepSize) const {
+    if (remaining_ == 0) {
+      return SIZE_MAX;
+    }
+    return static_cast<size_t>(
+        std::min(stepSize - elapsed_ % stepSize, remaining_));
+  }
+
+  float getCurrent() const { return current_; }
+
+ private:
+  float valueAt(int elapsed) const {
+    return rampStart_ + step_ * static_cast<float>(elapsed);
+  }
+
+  static_assert(std::atomic<float>::is_always_lock_free);
+  std::atomic<float> target_;
+
+  float current_;
+  float rampStart_;   // 今のランプの開始値
+  float rampTarget_;  // 今のランプの行き先
+  float step_;        // 1サンプルあたりの変化量
+  int elapsed_;       // ランプ開始からのサンプル数
+  int remaining_;     // ランプの残りサンプル数
+  int rampLength_;
+};
@@ -0,0 +1,223 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(REVERB_PROFILING) && \
+    (defined(__x86_64__) || defined(_M_X64) || defined(__i386__))
+#define STAGEPROFILER_RDTSC 1
+#include <x86intrin.h>
+#endif
+
+// process() の段ごとの処理時間を測るプロファイラ
+//
+// REVERB_PROFILING を定義したとき (CMake の REVERB_ENABLE_PROFILING) だけ
+// 計測する。定義しなければメンバを持たず、全てのメソッドは空の inline
+// 関数なので、計測のコードは何も残らない。
+//
+// 音声スレッドは beginBlock -> endStage (段の区切りごと) -> endBlock と
+// 呼ぶ (段に数えない処理の後は mark)。段の時間は rdtsc (x86 以外では
+// steady_clock) のカウントで測り、ブロック全体の時間は steady_clock で測る。
+// カウントから ns への換算は、同じブロックで測った両者の合計の比で行うので、
+// TSC の周波数を知らなくてよい。
+//
+// 集計は音声スレッドだけが書く atomic (relaxed) なので、snapshot() は
+// 別スレッドからロックなしで呼べる (項目の間で数ブロック分ずれることはある)。
+// 負荷のヒストグラムは、ブロックの締め切り (numSamples / sampleRate) に
+// 対する処理時間の割合 [%] を2のべき乗の区間に分けて数える:
+//   [0, 1), [1, 2), [2, 4), ..., [64, 128), [128, ∞)
+template <size_t NumStages>
+class StageProfiler {
+ public:
+  static constexpr size_t kNumLoadBuckets = 9;
+#if defined(REVERB_PROFILING)
+  static constexpr bool kEnabled = true;
+#else
+  static constexpr bool kEnabled = false;
+#endif
+
+  struct Snapshot {
+    uint64_t blocks = 0;
+    uint64_t samples = 0;
+    std::array<double, NumStages> stageNs{};  // 段ごとの合計時間
+    double totalNs = 0.0;                     // process() 全体の合計時間
+    double audioNs = 0.0;                     // 処理した音声の長さ
+    double maxBlockNs = 0.0;
+    double maxLoadPercent = 0.0;  // 最も締め切りに近かったブロック
+    std::array<uint64_t, kNumLoadBuckets> loadHistogram{};
+  };
+
+  StageProfiler() = default;
+  // Reverb などを std::vector に入れられるよう、コピーは集計を引き継ぐ
+  StageProfiler(const StageProfiler& other) { *this = other; }
+  StageProfiler& operator=(const StageProfiler& other) {
+#if defined(REVERB_PROFILING)
+    copyCounters(other);
+#else
+    (void)other;
+#endif
+    return *this;
+  }
+
+  // --- 音声スレッドのみ ---
+  void beginBlock() {
+#if defined(REVERB_PROFILING)
+    blockStart_ = std::chrono::steady_clock::now();
+    blockStartTicks_ = mark_ = ticks();
+#endif
+  }
+  // 区切りを今にする (直前の区切りからの時間はどの段にも数えない)
+  void mark() {
+#if defined(REVERB_PROFILING)
+    mark_ = ticks();
+#endif
+  }
+  // 直前の区切りから今までを stage の時間に足す
+  void endStage(size_t stage) {
+#if defined(REVERB_PROFILING)
+    const uint64_t now = ticks();
+    stageTicks_[stage] += now - mark_;
+    mark_ = now;
+#else
+    (void)stage;
+#endif
+  }
+  void endBlock(size_t numSamples, float sampleRate) {
+#if defined(REVERB_PROFILING)
+    const uint64_t elapsedTicks = ticks() - blockStartTicks_;
+    const auto elapsed = std::chrono::steady_clock::now() - blockStart_;
+    const auto elapsedNs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    const double deadlineNs =
+        static_cast<double>(numSamples) * 1e9 / static_cast<double>(sampleRate);
+    const double load =
+        deadlineNs > 0.0 ? 100.0 * static_cast<double>(elapsedNs) / deadlineNs
+                         : 0.0;
+
+    add(blocks_, 1);
+    add(samples_, numSamples);
+    add(totalTicks_, elapsedTicks);
+    add(totalNs_, elapsedNs);
+    add(audioNs_, static_cast<uint64_t>(deadlineNs));
+    for (size_t s = 0; s < NumStages; ++s) {
+      add(stageTicksTotal_[s], stageTicks_[s]);
+      stageTicks_[s] = 0;
+    }
+    if (elapsedNs > maxBlockNs_.load(std::memory_order_relaxed)) {
+      maxBlockNs_.store(elapsedNs, std::memory_order_relaxed);
+    }
+    // 0.01% 単位の整数で持つ
+    const auto loadBasisPoints = static_cast<uint64_t>(load * 100.0);
+    if (loadBasisPoints > maxLoad_.load(std::memory_order_relaxed)) {
+      maxLoad_.store(loadBasisPoints, std::memory_order_relaxed);
+    }
+    const size_t bucket = std::min<size_t>(
+        std::bit_width(static_cast<uint64_t>(load)), kNumLoadBuckets - 1);
+    add(loadHistogram_[bucket], 1);
+#else
+    (void)numSamples;
+    (void)sampleRate;
+#endif
+  }
+
+  // --- どのスレッドからでも呼べる ---
+  Snapshot snapshot() const {
+    Snapshot s;
+#if defined(REVERB_PROFILING)
+    s.blocks = load(blocks_);
+    s.samples = load(samples_);
+    s.totalNs = static_cast<double>(load(totalNs_));
+    s.audioNs = static_cast<double>(load(audioNs_));
+    const uint64_t totalTicks = load(totalTicks_);
+    const double nsPerTick =
+        totalTicks > 0 ? s.totalNs / static_cast<double>(totalTicks) : 0.0;
+    for (size_t i = 0; i < NumStages; ++i) {
+      s.stageNs[i] = static_cast<double>(load(stageTicksTotal_[i])) * nsPerTick;
+    }
+    s.maxBlockNs = static_cast<double>(load(maxBlockNs_));
+    s.maxLoadPercent = static_cast<double>(load(maxLoad_)) / 100.0;
+    for (size_t b = 0; b < kNumLoadBuckets; ++b) {
+      s.loadHistogram[b] = load(loadHistogram_[b]);
+    }
+#endif
+    return s;
+  }
+  // 集計を0に戻す。音声スレッドの process() と並行して呼ぶと、
+  // そのブロックの分は消えずに残ることがある
+  void reset() {
+#if defined(REVERB_PROFILING)
+    for (auto* counter : {&blocks_, &samples_, &totalTicks_, &totalNs_,
+                          &audioNs_, &maxBlockNs_, &maxLoad_}) {
+      counter->store(0, std::memory_order_relaxed);
+    }
+    for (auto& counter : stageTicksTotal_) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    for (auto& counter : loadHistogram_) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+#endif
+  }
+
+#if defined(REVERB_PROFILING)
+ private:
+  using Counter = std::atomic<uint64_t>;
+
+  static uint64_t ticks() {
+#if defined(STAGEPROFILER_RDTSC)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+  }
+  // 書くのは音声スレッドだけなので、read-modify-write の命令は要らない
+  static void add(Counter& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+  static uint64_t load(const Counter& counter) {
+    return counter.load(std::memory_order_relaxed);
+  }
+
+  void copyCounters(const StageProfiler& other) {
+    auto copy = [](Counter& to, const Counter& from) {
+      to.store(load(from), std::memory_order_relaxed);
+    };
+    copy(blocks_, other.blocks_);
+    copy(samples_, other.samples_);
+    copy(totalTicks_, other.totalTicks_);
+    copy(totalNs_, other.totalNs_);
+    copy(audioNs_, other.audioNs_);
+    copy(maxBlockNs_, other.maxBlockNs_);
+    copy(maxLoad_, other.maxLoad_);
+    for (size_t s = 0; s < NumStages; ++s) {
+      copy(stageTicksTotal_[s], other.stageTicksTotal_[s]);
+    }
+    for (size_t b = 0; b < kNumLoadBuckets; ++b) {
+      copy(loadHistogram_[b], other.loadHistogram_[b]);
+    }
+  }
+
+  // 今のブロック (音声スレッドだけが触る)
+  std::chrono::steady_clock::time_point blockStart_;
+  uint64_t blockStartTicks_ = 0;
+  uint64_t mark_ = 0;
+  std::array<uint64_t, NumStages> stageTicks_{};
+
+  // 集計
+  Counter blocks_{0};
+  Counter samples_{0};
+  Counter totalTicks_{0};
+  Counter totalNs_{0};
+  Counter audioNs_{0};
+  Counter maxBlockNs_{0};
+  Counter maxLoad_{0};
+  std::array<Counter, NumStages> stageTicksTotal_{};
+  std::array<Counter, kNumLoadBuckets> loadHistogram_{};
+#endif
+};
@@ -0,0 +1,375 @@
+#ifndef STATICREVERB_H
+#define STATICREVERB_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "DenormalGuard.h"
+#include "ReverbTuning.h"
+#include "SampleStorage.h"
+#include "SmoothedParameter.h"
+
+// StaticReverb の構成。テンプレート引数として渡すので、遅延時間などは
+// すべてコンパイル時の定数になる
+template <size_t NumCombs, size_t NumAllpass>
+struct StaticTopology {
+  std::array<float, NumCombs> combDelayTimes;  // 秒
+  // decay からフィードバックゲインを求めるときの倍率 (combGainFor)
+  std::array<float, NumCombs> combGainMultipliers;
+  std::array<float, NumAllpass> allpassDelayTimes;  // 秒
+  float allpassGain;
+  float combMixGain;
+  // 遅延バッファは、このサンプルレートでの最大遅延が入る
+  // 2のべき乗の長さで静的に確保する
+  float maxSampleRate;
+};
+
+// Reverb と同じ構成 (ReverbTuning.h の定数) のトポロジー
+constexpr StaticTopology<reverb_tuning::kNumCombs, reverb_tuning::kNumAllpasses>
+reverbTopology(float maxSampleRate) {
+  return {std::to_array(reverb_tuning::kCombDelayTimes),
+          std::to_array(reverb_tuning::kCombGainMultipliers),
+          std::to_array(reverb_tuning::kAllpassDelayTimes),
+          reverb_tuning::kAllpassGain,
+          reverb_tuning::kCombMixGain,
+          maxSampleRate};
+}
+
+// コム・オールパスの数と遅延時間をコンパイル時に固定した Schroeder リバーブ
+//
+// Reverb (CombBank + AllpassFilter) と同じ計算をするが、
+//  - 状態はすべて std::array に持ち、遅延バッファの長さも静的に決まる
+//    (リングバッファのマスクが定数になる)
+//  - コムの総和とオールパスのチェーンはループ回数が定数なので、
+//    コンパイラが完全に展開できる
+// 変調・アリーナ・マルチチャンネルには対応しない (必要なら Reverb を使う)。
+// Sample は内部の状態と演算の型 (float または double)。入出力は float。
+// Storage は遅延バッファに置く型で、既定は Sample と同じ。int16_t (Q15) に
+// すると遅延バッファのメモリが float の半分になる (SampleStorage.h)。
+// 例えば float 演算 + Q15 の遅延 (組み込み向け)、double 演算 + float の
+// 遅延 (マスタリング向けに積和だけ精度を上げる) などを組み合わせられる。
+//
+// 遅延バッファをメンバとして直接持つので大きい。
+// スタックには置かず、new / std::make_unique で確保する。
+// パラメータの設定は Reverb と同じく、別スレッドから process と並行して呼んでよい
+template <size_t NumCombs, size_t NumAllpass, typename Sample,
+          StaticTopology<NumCombs, NumAllpass> Topology,
+          typename Storage = Sample>
+class StaticReverb {
+ public:
+  // sampleRate は Topology.maxSampleRate 以下にする
+  // (超える場合、遅延はバッファに入る長さで打ち切る)
+  explicit StaticReverb(float sampleRate)
+      : sampleRate_(sampleRate),
+        wetLevel_(reverb_tuning::kDefaultWetLevel,
+                  reverb_tuning::smoothingSamples(sampleRate)),
+        decay_(reverb_tuning::kDefaultDecay,
+               reverb_tuning::smoothingSamples(sampleRate)),
+        damping_(reverb_tuning::kDefaultDamping,
+                 reverb_tuning::smoothingSamples(sampleRate)) {
+    // 遅延サンプル数の求め方は CombBank / AllpassFilter に合わせる
+    for (size_t c = 0; c < NumCombs; ++c) {
+      combDelay_[c] = static_cast<uint32_t>(std::clamp(
+          reverb_tuning::delaySamples(sampleRate_, Topology.combDelayTimes[c]),
+          1, static_cast<int>(kCombMask)));
+    }
+    for (size_t a = 0; a < NumAllpass; ++a) {
+      allpassDelay_[a] = static_cast<uint32_t>(std::clamp(
+          static_cast<int>(
+              std::round(sampleRate_ * Topology.allpassDelayTimes[a])),
+          1, static_cast<int>(kAllpassMask)));
+    }
+    reset();
+  }
+
+  StaticReverb(const StaticReverb&) = delete;
+  StaticReverb& operator=(const StaticReverb&) = delete;
+
+  float process(float sample) {
+    float output;
+    process(&sample, &output, 1);
+    return output;
+  }
+
+  // ブロック処理。input と output は同じバッファでもよい
+  void process(const float* input, float* output, size_t numSamples) {
+    const DenormalGuard denormalGuard;
+    wetLevel_.pollTarget();
+    decay_.pollTarget();
+    damping_.pollTarget();
+
+    while (numSamples > 0) {
+      // Reverb と同じく、decay / damping のランプの段の境目で区切る
+      const size_t n = std::min(
+          {numSamples, kMaxBlockSize,
+           decay_.samplesUntilNextStep(reverb_tuning::kSmoothingStepSize),
+           damping_.samplesUntilNextStep(reverb_tuning::kSmoothingStepSize)});
+      updateCombParameters();
+      Sample* wet = wetBuffer_.data();
+
+      processCombs(input, wet, n);
+      decay_.advance(n);
+      damping_.advance(n);
+      for (size_t a = 0; a < NumAllpass; ++a) {
+        processAllpass(a, wet, n);
+      }
+
+      if (wetLevel_.isRamping()) {
+        for (size_t i = 0; i < n; ++i) {
+          const float wetLevel = wetLevel_.advance(1);
+          output[i] = static_cast<float>(
+              static_cast<Sample>(1.0f - wetLevel) * input[i] +
+              static_cast<Sample>(wetLevel) * wet[i]);
+        }
+      } else {
+        const Sample wetLevel = wetLevel_.getCurrent();
+        const Sample dryLevel = 1.0f - wetLevel_.getCurrent();
+        for (size_t i = 0; i < n; ++i) {
+          output[i] =
+              static_cast<float>(dryLevel * input[i] + wetLevel * wet[i]);
+        }
+      }
+
+      input += n;
+      output += n;
+      numSamples -= n;
+    }
+  }
+
+  void reset() {
+    for (auto& buffer : combBuffers_) {
+      buffer.fill(Storage(0));
+    }
+    for (auto& buffer : allpassBuffers_) {
+      buffer.fill(Storage(0));
+    }
+    store_.fill(Sample(0));
+    combWriteIndex_ = 0;
+    allpassWriteIndex_.fill(0);
+    // 無音から始めるので、パラメータはランプせずに目標値へ切り替える
+    wetLevel_.snap();
+    decay_.snap();
+    damping_.snap();
+    applyCombParameters(decay_.getCurrent(), damping_.getCurrent());
+  }
+
+  void setWetLevel(float level) {
+    wetLevel_.setTarget(std::clamp(level, 0.0f, 1.0f));
+  }
+  void setDecay(float decay) {
+    decay_.setTarget(std::clamp(decay, 0.0f, 1.0f));
+  }
+  void setDamping(float damping) {
+    damping_.setTarget(std::clamp(damping, 0.0f, 1.0f));
+  }
+
+  // 遅延バッファ全体のバイト数 (Storage の大きさに比例する)
+  static constexpr size_t delayBufferBytes() {
+    return (NumCombs * kCombSize + NumAllpass * kAllpassSize) *
+           sizeof(Storage);
+  }
+
+  int getCombDelaySamples(size_t comb) const {
+    return static_cast<int>(combDelay_[comb]);
+  }
+  int getAllpassDelaySamples(size_t allpass) const {
+    return static_cast<int>(allpassDelay_[allpass]);
+  }
+
+  static constexpr size_t kNumCombs = NumCombs;
+  static constexpr size_t kNumAllpasses = NumAllpass;
+
+ private:
+  // 遅延バッファの読み書きに変換が要るか
+  static constexpr bool kConvertsStorage = !std::is_same_v<Storage, Sample>;
+
+  static constexpr float maxOf(const float* begin, const float* end) {
+    return begin == end ? 0.0f : *std::max_element(begin, end);
+  }
+
+  // 遅延バッファの長さ (2のべき乗)。最大遅延 + 書き込み中の1サンプル分
+  static constexpr size_t kCombSize = std::bit_ceil(
+      static_cast<size_t>(Topology.maxSampleRate *
+                          maxOf(Topology.combDelayTimes.data(),
+                                Topology.combDelayTimes.data() + NumCombs)) +
+      1);
+  static constexpr size_t kAllpassSize = std::bit_ceil(
+      static_cast<size_t>(
+          std::round(Topology.maxSampleRate *
+                     maxOf(Topology.allpassDelayTimes.data(),
+                           Topology.allpassDelayTimes.data() + NumAllpass))) +
+      1);
+  static constexpr uint32_t kCombMask = static_cast<uint32_t>(kCombSize - 1);
+  static constexpr uint32_t kAllpassMask =
+      static_cast<uint32_t>(kAllpassSize - 1);
+
+  // 内部で一度に処理する最大ブロック長。これより長い入力は分割する
+  static constexpr size_t kMaxBlockSize = 256;
+
+  void processCombs(const float* input, Sample* wet, size_t numSamples) {
+    // 状態はループの間ローカルに置き、レジスタに載せる
+    std::array<Sample, NumCombs> store = store_;
+    const std::array<Sample, NumCombs> gain = combGain_;
+    const std::array<Sample, NumCombs> damping = combDamping_;
+    const Sample mixGain = Topology.combMixGain;
+
+    while (numSamples > 0) {
+      // 書き込み位置も、どのコムの読み出し位置もバッファの端をまたがない
+      // 長さに区切り、その間は連続したポインタで読み書きする
+      const uint32_t w = combWriteIndex_ & kCombMask;
+      size_t n = std::min<size_t>(numSamples, kCombSize - w);
+      std::array<uint32_t, NumCombs> r;
+      for (size_t c = 0; c < NumCombs; ++c) {
+        r[c] = (combWriteIndex_ - combDelay_[c]) & kCombMask;
+        n = std::min<size_t>(n, kCombSize - r[c]);
+        if constexpr (kConvertsStorage) {
+          // 作業領域に読んでから書き戻すので、このチャンクで書いた値を
+          // 読まない長さ (遅延以下) にする
+          n = std::min<size_t>(n, combDelay_[c]);
+        }
+      }
+      // Storage が Sample と違う場合は、作業領域にまとめて変換してから
+      // 同じループで処理し、まとめて書き戻す
+      Sample stage[kConvertsStorage ? NumCombs : 1][kMaxBlockSize];
+      std::array<const Sample*, NumCombs> delayed;
+      std::array<Sample*, NumCombs> written;
+      for (size_t c = 0; c < NumCombs; ++c) {
+        if constexpr (kConvertsStorage) {
+          loadSamples(combBuffers_[c].data() + r[c], stage[c], n);
+          delayed[c] = written[c] = stage[c];
+        } else {
+          delayed[c] = combBuffers_[c].data() + r[c];
+          written[c] = combBuffers_[c].data() + w;
+        }
+      }
+
+      // 各コムの1次ローパスは互いに独立なので、展開された内側のループで
+      // 全コムの依存チェーンが並列に進む
+      for (size_t i = 0; i < n; ++i) {
+        const Sample x = input[i];
+        Sample sum = 0;
+        for (size_t c = 0; c < NumCombs; ++c) {
+          store[c] = delayed[c][i] * (Sample(1) - damping[c]) +
+                     store[c] * damping[c];
+          const Sample y = x + gain[c] * store[c];
+          written[c][i] = y;
+          sum += y;
+        }
+        wet[i] = sum * mixGain;
+      }
+      if constexpr (kConvertsStorage) {
+        for (size_t c = 0; c < NumCombs; ++c) {
+          storeSamples(stage[c], combBuffers_[c].data() + w, n);
+        }
+      }
+
+      combWriteIndex_ += static_cast<uint32_t>(n);
+      input += n;
+      wet += n;
+      numSamples -= n;
+    }
+    store_ = store;
+  }
+
+  // samples をその場でオールパスに通す
+  void processAllpass(size_t allpass, Sample* samples, size_t numSamples) {
+    Storage* buffer = allpassBuffers_[allpass].data();
+    const uint32_t delay = allpassDelay_[allpass];
+    const Sample gain = std::min(0.99f, Topology.allpassGain);
+    uint32_t writeIndex = allpassWriteIndex_[allpass];
+
+    while (numSamples > 0) {
+      // 遅延長以下、かつバッファの端をまたがない長さに区切ると、
+      // 読み出しと書き込みの範囲が重ならないのでベクトル化できる
+      const uint32_t w = writeIndex & kAllpassMask;
+      const uint32_t r = (writeIndex - delay) & kAllpassMask;
+      const size_t n = std::min<size_t>(
+          {numSamples, delay, kAllpassSize - w, kAllpassSize - r});
+      if constexpr (kConvertsStorage) {
+        // n は遅延以下なので、読む範囲と書く範囲は重ならない
+        Sample stage[kMaxBlockSize];
+        loadSamples(buffer + r, stage, n);
+        allpassBlock(samples, stage, stage, gain, n);
+        storeSamples(stage, buffer + w, n);
+      } else {
+        allpassBlock(samples, buffer + r, buffer + w, gain, n);
+      }
+      writeIndex += static_cast<uint32_t>(n);
+      samples += n;
+      numSamples -= n;
+    }
+    allpassWriteIndex_[allpass] = writeIndex;
+  }
+
+  // delayed を読み、written に書く (同じ配列でもよい)
+  static void allpassBlock(Sample* samples, const Sample* delayed,
+                           Sample* written, Sample gain, size_t numSamples) {
+    for (size_t i = 0; i < numSamples; ++i) {
+      const Sample x = samples[i];
+      const Sample d = delayed[i];
+      written[i] = x + gain * d;
+      samples[i] = -gain * x + d;
+    }
+  }
+
+  void updateCombParameters() {
+    const float decay =
+        decay_.getSteppedValue(reverb_tuning::kSmoothingStepSize);
+    const float damping =
+        damping_.getSteppedValue(reverb_tuning::kSmoothingStepSize);
+    if (decay != appliedDecay_ || damping != appliedDamping_) {
+      applyCombParameters(decay, damping);
+    }
+  }
+
+  void applyCombParameters(float decay, float damping) {
+    for (size_t c = 0; c < NumCombs; ++c) {
+      combGain_[c] =
+          reverb_tuning::combGainFor(decay, Topology.combGainMultipliers[c]);
+      combDamping_[c] = damping;
+    }
+    appliedDecay_ = decay;
+    appliedDamping_ = damping;
+  }
+
+  float sampleRate_;
+
+  // コムフィルタ (書き込み位置は全コムで共通)
+  std::array<uint32_t, NumCombs> combDelay_{};
+  std::array<Sample, NumCombs> combGain_{};
+  std::array<Sample, NumCombs> combDamping_{};
+  std::array<Sample, NumCombs> store_{};
+  uint32_t combWriteIndex_ = 0;
+  std::array<std::array<Storage, kCombSize>, NumCombs> combBuffers_;
+
+  // オールパスフィルタ
+  std::array<uint32_t, NumAllpass> allpassDelay_{};
+  std::array<uint32_t, NumAllpass> allpassWriteIndex_{};
+  std::array<std::array<Storage, kAllpassSize>, NumAllpass> allpassBuffers_;
+
+  // パラメータ (dry = 1 - wet の線形ミックス)
+  SmoothedParameter wetLevel_;
+  SmoothedParameter decay_;
+  SmoothedParameter damping_;
+  // コムフィルタに反映済みの decay / damping
+  float appliedDecay_ = 0.0f;
+  float appliedDamping_ = 0.0f;
+
+  std::array<Sample, kMaxBlockSize> wetBuffer_;  // コム出力 -> オールパス
+};
+
+// Reverb と同じ構成 (4コム + 2オールパス) を静的に展開したもの。
+// MaxSampleRate までのサンプルレートで使える
+template <int MaxSampleRate = 48000, typename Sample = float,
+          typename Storage = Sample>
+using StaticSchroederReverb =
+    StaticReverb<reverb_tuning::kNumCombs, reverb_tuning::kNumAllpasses,
+                 Sample, reverbTopology(static_cast<float>(MaxSampleRate)),
+                 Storage>;
+
+#endif  // STATICREVERB_H
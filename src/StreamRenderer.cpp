@@ -0,0 +1,161 @@
+#include "StreamRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "MultichannelReverb.h"
+
+namespace {
+
+struct Block {
+  std::vector<float> samples;  // [フレーム][チャンネル]
+  size_t frames = 0;
+};
+
+// スレッド間でブロックを受け渡すキュー (容量はブロック総数で足りる)
+// オーディオスレッドではないので mutex と条件変数で待つ
+class BlockQueue {
+ public:
+  explicit BlockQueue(size_t capacity) : slots_(capacity) {}
+
+  void push(Block* block) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      slots_[(head_ + size_) % slots_.size()] = block;
+      ++size_;
+    }
+    cv_.notify_one();
+  }
+
+  // close() 後に空になったら nullptr
+  Block* pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return size_ > 0 || closed_; });
+    if (size_ == 0) {
+      return nullptr;
+    }
+    Block* block = slots_[head_];
+    head_ = (head_ + 1) % slots_.size();
+    --size_;
+    return block;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  std::vector<Block*> slots_;
+  size_t head_ = 0;
+  size_t size_ = 0;
+  bool closed_ = false;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+}  // namespace
+
+StreamRenderResult renderStream(StreamSource& source, StreamSink& sink,
+                                size_t channels, float sampleRate,
+                                const StreamRenderOptions& options) {
+  const size_t blockFrames = std::max<size_t>(options.blockFrames, 1);
+  const size_t numBlocks = std::max<size_t>(options.numBlocks, 1);
+
+  std::vector<Block> blocks(numBlocks);
+  BlockQueue freeBlocks(numBlocks);
+  BlockQueue readBlocks(numBlocks);
+  BlockQueue processedBlocks(numBlocks);
+  for (Block& block : blocks) {
+    block.samples.resize(blockFrames * channels);
+    freeBlocks.push(&block);
+  }
+
+  MultichannelReverb reverb(sampleRate, channels);
+  reverb.setWetLevel(options.wetLevel);
+  reverb.setDecay(options.decay);
+  reverb.setDamping(options.damping);
+  reverb.setWidth(options.width);
+  // 設定値をランプせずに最初から適用する
+  reverb.reset();
+
+  StreamRenderResult result = {true, 0, 0};
+  std::atomic<bool> aborted{false};
+  // 読み込みスレッドだけが書き、join の後で result に反映する
+  bool readFailed = false;
+
+  // 読み込みスレッド: 入力が尽きたら余韻の無音で埋める。
+  // 読み込みに失敗したら、読めた分だけを流して止まる
+  std::thread reader([&] {
+    bool sourceEnded = false;
+    size_t tailLeft = options.tailFrames;
+    while (!aborted.load(std::memory_order_relaxed)) {
+      Block* block = freeBlocks.pop();
+      if (block == nullptr) {
+        break;
+      }
+      size_t frames = 0;
+      if (!sourceEnded) {
+        frames = source.read(block->samples.data(), blockFrames);
+        result.framesRead += frames;
+        sourceEnded = frames < blockFrames;
+        if (sourceEnded && source.failed()) {
+          readFailed = true;
+          tailLeft = 0;
+        }
+      }
+      const size_t silence = std::min(blockFrames - frames, tailLeft);
+      std::fill_n(block->samples.begin() + frames * channels,
+                  silence * channels, 0.0f);
+      tailLeft -= silence;
+      block->frames = frames + silence;
+      if (block->frames == 0) {
+        break;
+      }
+      readBlocks.push(block);
+      if (readFailed) {
+        break;
+      }
+    }
+    readBlocks.close();
+  });
+
+  // DSP スレッド: ブロックをその場で処理する
+  std::thread dsp([&] {
+    while (Block* block = readBlocks.pop()) {
+      reverb.processInterleaved(block->samples.data(), block->samples.data(),
+                                block->frames);
+      processedBlocks.push(block);
+    }
+    processedBlocks.close();
+  });
+
+  // 書き出しは呼び出したスレッドで行う
+  while (Block* block = processedBlocks.pop()) {
+    if (result.ok) {
+      if (sink.write(block->samples.data(), block->frames)) {
+        result.framesWritten += block->frames;
+      } else {
+        result.ok = false;
+        aborted.store(true, std::memory_order_relaxed);
+      }
+    }
+    freeBlocks.push(block);
+  }
+  // 読み込みスレッドが空きブロックを待っていても抜けられるようにする
+  freeBlocks.close();
+
+  reader.join();
+  dsp.join();
+  if (readFailed) {
+    result.ok = false;
+  }
+  return result;
+}
@@ -0,0 +1,56 @@
+#ifndef STREAMRENDERER_H
+#define STREAMRENDERER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 長いファイルを一定長のブロックで流しながらリバーブをかける
+// オフラインレンダラ
+//
+// 読み込み -> DSP -> 書き出し をそれぞれ別スレッドで動かし、
+// 固定数のブロックを3段のキューで回す。メモリ使用量は
+// blockFrames x channels x numBlocks で決まり、ファイル長によらない。
+
+// インターリーブされたサンプルの読み出し元
+class StreamSource {
+ public:
+  virtual ~StreamSource() = default;
+  // 最大 maxFrames フレームを読み、読んだフレーム数を返す。
+  // maxFrames 未満なら終端 (またはエラー) とみなす
+  virtual size_t read(float* interleaved, size_t maxFrames) = 0;
+  // read() が maxFrames 未満を返したのが、終端ではなくエラーのためなら true
+  virtual bool failed() const { return false; }
+};
+
+// インターリーブされたサンプルの書き込み先
+class StreamSink {
+ public:
+  virtual ~StreamSink() = default;
+  // 全フレームを書けたら true
+  virtual bool write(const float* interleaved, size_t numFrames) = 0;
+};
+
+struct StreamRenderOptions {
+  size_t blockFrames = 4096;  // 1ブロックのフレーム数
+  size_t numBlocks = 4;       // パイプライン中を回るブロック数
+  size_t tailFrames = 0;      // 入力の後に足す無音 (残響の余韻) のフレーム数
+
+  float wetLevel = 0.5f;
+  float decay = 0.5f;
+  float damping = 0.4f;
+  float width = 1.0f;
+};
+
+struct StreamRenderResult {
+  bool ok;                 // 読み込みか書き込みに失敗した場合は false
+  uint64_t framesRead;     // 入力から読んだフレーム数
+  uint64_t framesWritten;  // 出力に書いたフレーム数 (余韻を含む)
+};
+
+// source から読み、MultichannelReverb をかけて sink に書く。
+// channels は 1 ~ MultichannelReverb::kMaxChannels
+StreamRenderResult renderStream(StreamSource& source, StreamSink& sink,
+                                size_t channels, float sampleRate,
+                                const StreamRenderOptions& options);
+
+#endif  // STREAMRENDERER_H
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+
+// グローバルな operator new を置き換えて、メモリ確保の回数を数える
+// (AllocCounter.cpp を run_tests にリンクすると有効になる)
+namespace alloc_counter {
+
+// これまでに呼ばれた operator new の回数 (全スレッド合計)
+size_t count();
+
+// スコープ内で行われたメモリ確保の回数を測る
+class Scope {
+ public:
+  Scope() : start_(count()) {}
+  size_t allocations() const { return count() - start_; }
+
+ private:
+  size_t start_;
+};
+
+}  // namespace alloc_counter
@@ -0,0 +1,169 @@
+#include "ReverbHarness.h"
+
+#include <cmath>
+#include <fstream>
+#include <random>
+
+namespace reverb_harness {
+
+namespace {
+constexpr double kPi = 3.14159265358979323846;
+
+bool readValues(std::istream& in, const std::string& key,
+                std::vector<float>& values) {
+  std::string name;
+  size_t count = 0;
+  if (!(in >> name >> count) || name != key) {
+    return false;
+  }
+  values.resize(count);
+  for (float& v : values) {
+    if (!(in >> v)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void writeValues(std::ostream& out, const std::string& key,
+                 const std::vector<float>& values) {
+  out << key << ' ' << values.size() << '\n';
+  for (size_t i = 0; i < values.size(); ++i) {
+    out << values[i] << ((i % 8 == 7 || i + 1 == values.size()) ? '\n' : ' ');
+  }
+}
+}  // namespace
+
+std::vector<float> makeSignal(Signal signal, float sampleRate,
+                              size_t numSamples) {
+  std::vector<float> x(numSamples, 0.0f);
+  switch (signal) {
+    case Signal::Impulse:
+      if (numSamples > 0) {
+        x[0] = 1.0f;
+      }
+      break;
+    case Signal::SineBurst: {
+      const auto n =
+          std::min(numSamples, static_cast<size_t>(sampleRate * 0.2f));
+      for (size_t i = 0; i < n; ++i) {
+        x[i] = static_cast<float>(0.5 * std::sin(2.0 * kPi * 440.0 *
+                                                 static_cast<double>(i) /
+                                                 sampleRate));
+      }
+      break;
+    }
+    case Signal::Noise: {
+      // 分布の実装は標準ライブラリごとに違うので、乱数から直接作る
+      std::mt19937 gen(2024);
+      const auto n =
+          std::min(numSamples, static_cast<size_t>(sampleRate * 0.25f));
+      for (size_t i = 0; i < n; ++i) {
+        x[i] = static_cast<float>(static_cast<double>(gen()) / 4294967295.0 -
+                                  0.5);
+      }
+      break;
+    }
+  }
+  return x;
+}
+
+std::vector<float> makeNoise(size_t numSamples, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> distrib(-1.0f, 1.0f);
+  std::vector<float> x(numSamples);
+  for (float& v : x) {
+    v = distrib(gen);
+  }
+  return x;
+}
+
+std::vector<float> energyDecayCurveDb(const std::vector<float>& response) {
+  std::vector<float> edc(response.size(), kFloorDb);
+  double remaining = 0.0;
+  std::vector<double> energy(response.size());
+  for (size_t i = response.size(); i-- > 0;) {
+    remaining += static_cast<double>(response[i]) * response[i];
+    energy[i] = remaining;
+  }
+  if (response.empty() || energy[0] <= 0.0) {
+    return edc;
+  }
+  for (size_t i = 0; i < response.size(); ++i) {
+    if (energy[i] > 0.0) {
+      const double db = 10.0 * std::log10(energy[i] / energy[0]);
+      edc[i] = static_cast<float>(std::max<double>(db, kFloorDb));
+    }
+  }
+  return edc;
+}
+
+double decayTime(const std::vector<float>& edcDb, float sampleRate,
+                 float fromDb, float toDb) {
+  // 時間 [秒] に対する dB の最小二乗直線の傾き
+  double n = 0.0, sumT = 0.0, sumDb = 0.0, sumTT = 0.0, sumTDb = 0.0;
+  bool reached = false;
+  for (size_t i = 0; i < edcDb.size(); ++i) {
+    if (edcDb[i] > fromDb) {
+      continue;
+    }
+    if (edcDb[i] < toDb) {
+      reached = true;
+      break;
+    }
+    const double t = static_cast<double>(i) / sampleRate;
+    n += 1.0;
+    sumT += t;
+    sumDb += edcDb[i];
+    sumTT += t * t;
+    sumTDb += t * edcDb[i];
+  }
+  const double denominator = n * sumTT - sumT * sumT;
+  if (!reached || n < 2.0 || denominator <= 0.0) {
+    return 0.0;
+  }
+  const double slope = (n * sumTDb - sumT * sumDb) / denominator;
+  return slope < 0.0 ? -60.0 / slope : 0.0;
+}
+
+Golden analyze(const std::vector<float>& response, float sampleRate) {
+  Golden golden;
+  const std::vector<float> edc = energyDecayCurveDb(response);
+  golden.rt60 = decayTime(edc, sampleRate);
+  golden.head.assign(response.begin(),
+                     response.begin() + static_cast<std::ptrdiff_t>(std::min(
+                                            kHeadSamples, response.size())));
+  const auto step = static_cast<size_t>(sampleRate * kEdcStep);
+  for (size_t i = 0; i < edc.size(); i += step) {
+    golden.edcDb.push_back(edc[i]);
+  }
+  return golden;
+}
+
+bool readGolden(const std::string& path, Golden& golden) {
+  std::ifstream in(path);
+  std::string line;
+  // 先頭の # の行は説明
+  while (in.peek() == '#' && std::getline(in, line)) {
+  }
+  std::string key;
+  if (!(in >> key >> golden.rt60) || key != "rt60") {
+    return false;
+  }
+  return readValues(in, "head", golden.head) &&
+         readValues(in, "edc", golden.edcDb);
+}
+
+bool writeGolden(const std::string& path, const Golden& golden,
+                 const std::string& description) {
+  std::ofstream out(path);
+  // float が元の値に戻る桁数で書く
+  out.precision(9);
+  out << "# " << description << '\n';
+  out << "rt60 " << golden.rt60 << '\n';
+  writeValues(out, "head", golden.head);
+  writeValues(out, "edc", golden.edcDb);
+  return static_cast<bool>(out);
+}
+
+}  // namespace reverb_harness
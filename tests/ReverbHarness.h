@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 応答のレンダリングと、ゴールデン出力・性能の比較に使う指標
+// (test_Schroeder_Reverb.cpp, test_PerfBudget.cpp と各段のテストで共有する)
+namespace reverb_harness {
+
+enum class Signal {
+  Impulse,    // 先頭に 1.0
+  SineBurst,  // 440 Hz, 振幅 0.5 を 0.2 秒
+  Noise,      // 一様ノイズ (振幅 0.5) を 0.25 秒。シードは固定
+};
+
+// numSamples サンプルの入力。バーストの後は無音
+std::vector<float> makeSignal(Signal signal, float sampleRate,
+                              size_t numSamples);
+
+// seed で決まる [-1, 1) の一様ノイズ。同じ入力を2通りに処理して比べる
+// テスト用 (分布の実装によるので、ゴールデン出力には使わない)
+std::vector<float> makeNoise(size_t numSamples, unsigned seed);
+
+// stage (process(in, out, n) を持つもの) で input をブロックごとに処理する
+template <typename Stage>
+std::vector<float> render(Stage& stage, const std::vector<float>& input,
+                          size_t blockSize) {
+  std::vector<float> output(input.size());
+  for (size_t i = 0; i < input.size(); i += blockSize) {
+    const size_t n = std::min(blockSize, input.size() - i);
+    stage.process(input.data() + i, output.data() + i, n);
+  }
+  return output;
+}
+
+// Schroeder の逆積分によるエネルギー減衰曲線 [dB] (先頭が 0 dB)。
+// 無音の部分は kFloorDb に切り詰める
+inline constexpr float kFloorDb = -150.0f;
+std::vector<float> energyDecayCurveDb(const std::vector<float>& response);
+
+// 減衰曲線の fromDb から toDb までを直線で近似し、60 dB 減衰する時間 [秒]
+// に換算する (既定は T30)。toDb まで減衰していなければ 0
+double decayTime(const std::vector<float>& edcDb, float sampleRate,
+                 float fromDb = -5.0f, float toDb = -35.0f);
+
+// ゴールデンファイルに保存する内容
+struct Golden {
+  double rt60 = 0.0;
+  std::vector<float> head;   // 出力の先頭 (サンプル単位で比べる)
+  std::vector<float> edcDb;  // 減衰曲線を kEdcStep 秒ごとに間引いたもの
+};
+inline constexpr size_t kHeadSamples = 2048;
+inline constexpr float kEdcStep = 0.01f;
+
+Golden analyze(const std::vector<float>& response, float sampleRate);
+
+// テキスト形式で読み書きする。読めなければ false
+bool readGolden(const std::string& path, Golden& golden);
+bool writeGolden(const std::string& path, const Golden& golden,
+                 const std::string& description);
+
+// process(numSamples) を repetitions 回測り、最も速かった回の ns/sample。
+// 1回目の前に1度だけ空回しして、キャッシュとページを温める
+template <typename Process>
+double measureNsPerSample(Process&& process, size_t numSamples,
+                          int repetitions) {
+  process(numSamples);
+  double best = 0.0;
+  for (int r = 0; r < repetitions; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    process(numSamples);
+    const std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const double nsPerSample =
+        elapsed.count() / static_cast<double>(numSamples);
+    if (r == 0 || nsPerSample < best) {
+      best = nsPerSample;
+    }
+  }
+  return best;
+}
+
+}  // namespace reverb_harness
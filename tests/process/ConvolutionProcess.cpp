@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ConvolutionReverb.h"
+
+// --- dr_wav ライブラリ ---
+#define DR_WAV_IMPLEMENTATION
+#include "dr_wav.h"
+
+// 使い方: ConvolutionProcess [IR.wav] [出力.wav]
+// IR を読み込み (多チャンネルなら平均してモノラルにする)、
+// 短いノイズバーストに畳み込んで書き出す。
+// IR を指定しないときは、3秒の減衰するノイズを IR の代わりに使う。
+
+namespace {
+bool read_impulse_response(const std::string& filename,
+                           std::vector<float>& ir, float& sampleRate) {
+  unsigned int channels = 0;
+  unsigned int rate = 0;
+  drwav_uint64 frames = 0;
+  float* data = drwav_open_file_and_read_pcm_frames_f32(
+      filename.c_str(), &channels, &rate, &frames, NULL);
+  if (data == NULL || channels == 0) {
+    return false;
+  }
+  ir.assign(static_cast<size_t>(frames), 0.0f);
+  for (size_t i = 0; i < ir.size(); ++i) {
+    for (unsigned int c = 0; c < channels; ++c) {
+      ir[i] += data[i * channels + c];
+    }
+    ir[i] /= static_cast<float>(channels);
+  }
+  drwav_free(data, NULL);
+  sampleRate = static_cast<float>(rate);
+  return true;
+}
+
+void write_to_wav(const std::string& filename, const std::vector<float>& data,
+                  float sampleRate) {
+  drwav_data_format format;
+  format.container = drwav_container_riff;
+  format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+  format.channels = 1;
+  format.sampleRate = (drwav_uint32)sampleRate;
+  format.bitsPerSample = 32;
+
+  drwav wav;
+  if (!drwav_init_file_write(&wav, filename.c_str(), &format, NULL)) {
+    std::cerr << "ERROR: Failed to open file for writing: " << filename
+              << std::endl;
+    return;
+  }
+  drwav_write_pcm_frames(&wav, data.size(), data.data());
+  drwav_uninit(&wav);
+  std::cout << "Wrote " << filename << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  // === 1. IR の用意 ===
+  std::vector<float> ir;
+  float sampleRate = 48000.0f;
+  if (argc > 1) {
+    if (!read_impulse_response(argv[1], ir, sampleRate)) {
+      std::cerr << "ERROR: Failed to read impulse response: " << argv[1]
+                << std::endl;
+      return 1;
+    }
+  } else {
+    // 約60dB 減衰する3秒のノイズ
+    ir.resize(static_cast<size_t>(3 * sampleRate));
+    unsigned int seed = 1;
+    for (size_t i = 0; i < ir.size(); ++i) {
+      seed = seed * 1664525u + 1013904223u;
+      const float noise = static_cast<float>(seed >> 8) / 8388608.0f - 1.0f;
+      ir[i] = 0.1f * noise * std::exp(-6.9f * i / ir.size());
+    }
+  }
+  const std::string outputFilename =
+      argc > 2 ? argv[2] : "convolution_reverb_test.wav";
+  std::cout << "Impulse response: " << ir.size() << " samples ("
+            << ir.size() / sampleRate << " s at " << sampleRate << " Hz)"
+            << std::endl;
+
+  ConvolutionReverb reverb(sampleRate, ir.data(), ir.size());
+  reverb.setWetLevel(0.4f);
+  reverb.reset();
+
+  // === 2. 入力 (0.1秒のノイズバースト + IR の長さ分の無音) ===
+  const size_t numSamples = ir.size() + static_cast<size_t>(sampleRate);
+  std::vector<float> inputSignal(numSamples, 0.0f);
+  unsigned int seed = 7;
+  for (size_t i = 0; i < static_cast<size_t>(0.1f * sampleRate); ++i) {
+    seed = seed * 1664525u + 1013904223u;
+    inputSignal[i] = 0.5f * (static_cast<float>(seed >> 8) / 8388608.0f - 1.0f);
+  }
+
+  // === 3. 畳み込み (オーディオコールバックを想定したブロック処理) ===
+  std::vector<float> outputSignal(numSamples);
+  const size_t blockSize = 256;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < numSamples; i += blockSize) {
+    const size_t n = std::min(blockSize, numSamples - i);
+    reverb.process(&inputSignal[i], &outputSignal[i], n);
+  }
+  const auto elapsed = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start);
+  const ConvolutionReverb::Stats stats = reverb.getStats();
+  std::cout << "Elapsed: " << elapsed.count() / 1e6 << " ms ("
+            << elapsed.count() / numSamples << " ns/sample), "
+            << stats.tailBlocks << " tail blocks, " << stats.lateTailBlocks
+            << " late" << std::endl;
+
+  // === 4. WAVファイルへの書き出し ===
+  write_to_wav(outputFilename, outputSignal, sampleRate);
+  return 0;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <chrono>
 #include <cmath>  // sin()とM_PIのために必要
 #include <iostream>
 #include <string>
@@ -63,6 +65,7 @@ int main() {
   // Dry/Wetを調整して、原音とリバーブ音をミックスする
   reverb.setWetLevel(0.4f);  // 40% wet
   reverb.setDecay(0.80f);
+  reverb.reset();  // 設定値をランプせずに最初から適用する
 
   std::cout << "Reverb settings: Wet=0.4, Decay=0.80" << std::endl;
 
@@ -81,10 +84,18 @@ int main() {
   std::cout << "Processing sine wave (" << numSamples << " samples)..."
             << std::endl;
   std::vector<float> outputSignal(numSamples);
-  for (int i = 0; i < numSamples; ++i) {
-    outputSignal[i] = reverb.process(inputSignal[i]);
+  // オーディオコールバックを想定してブロック単位で処理する
+  const int blockSize = 256;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numSamples; i += blockSize) {
+    const int n = std::min(blockSize, numSamples - i);
+    reverb.process(&inputSignal[i], &outputSignal[i], n);
   }
+  const auto elapsed = std::chrono::duration<double, std::nano>(
+      std::chrono::steady_clock::now() - start);
   std::cout << "Processing finished." << std::endl;
+  std::cout << "Elapsed: " << elapsed.count() / 1e6 << " ms ("
+            << elapsed.count() / numSamples << " ns/sample)" << std::endl;
 
   // === 5. WAVファイルへの書き出し ===
   std::cout << "Writing to WAV file: " << outputFilename << std::endl;
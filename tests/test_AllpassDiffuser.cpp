@@ -0,0 +1,152 @@
+#include "AllpassDiffuser.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "AllpassFilter.h"
+#include "ReverbHarness.h"
+#include "ReverbTuning.h"
+#include "gtest/gtest.h"
+
+class AllpassDiffuserTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 9600;
+  const int maxDelaySamples = 960;
+
+  std::vector<float> makeNoise(unsigned seed) {
+    return reverb_harness::makeNoise(numSamples, seed);
+  }
+
+  // 比較用: diffuser と同じ遅延・ゲインの AllpassFilter を並べて通す
+  std::vector<float> renderChain(const AllpassDiffuser& diffuser,
+                                 const std::vector<float>& input) {
+    std::vector<float> output = input;
+    for (size_t s = 0; s < diffuser.getNumStages(); ++s) {
+      AllpassFilter allpass(
+          sampleRate,
+          static_cast<float>(diffuser.getDelaySamples(s)) / sampleRate,
+          diffuser.getGain(s), maxDelaySamples);
+      output = reverb_harness::render(allpass, output, 64);
+    }
+    return output;
+  }
+};
+
+// 各段は AllpassFilter と同じ式なので、同じ遅延・ゲインで並べたのと
+// 同じ出力になる。遅延より長いブロックでも、in-place でも変わらない
+TEST_F(AllpassDiffuserTest, MatchesAllpassFilterChain) {
+  const std::vector<float> input = makeNoise(1);
+  for (const size_t stages : {1, 2, 4, 8}) {
+    AllpassDiffuser diffuser(sampleRate, stages, maxDelaySamples);
+    EXPECT_EQ(diffuser.getNumStages(), stages);
+    const std::vector<float> expected = renderChain(diffuser, input);
+    for (const size_t blockSize : {1, 37, 256, 1000}) {
+      diffuser.reset();
+      const std::vector<float> output =
+          reverb_harness::render(diffuser, input, blockSize);
+      for (size_t i = 0; i < numSamples; ++i) {
+        ASSERT_NEAR(output[i], expected[i], 1e-6f)
+            << "stages " << stages << ", block " << blockSize << ", sample "
+            << i;
+      }
+    }
+
+    diffuser.reset();
+    std::vector<float> inPlace = input;
+    diffuser.process(inPlace.data(), inPlace.data(), numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_NEAR(inPlace[i], expected[i], 1e-6f)
+          << "stages " << stages << ", in-place sample " << i;
+    }
+  }
+}
+
+// 先頭の2段は Reverb のオールパスと同じ遅延・ゲイン
+// (0.0098 s, 0.0031 s を最も近いサンプル数に丸める)
+TEST_F(AllpassDiffuserTest, DefaultsStartWithReverbAllpasses) {
+  AllpassDiffuser diffuser(sampleRate, 8, maxDelaySamples);
+  EXPECT_EQ(diffuser.getMaxStages(), 8u);
+  EXPECT_EQ(diffuser.getDelaySamples(0), 470);
+  EXPECT_EQ(diffuser.getDelaySamples(1), 149);
+  for (size_t s = 0; s < diffuser.getNumStages(); ++s) {
+    EXPECT_EQ(diffuser.getGain(s), reverb_tuning::kAllpassGain);
+  }
+}
+
+// 段の数・遅延・ゲインを変えても、同じ構成の AllpassFilter の列と一致する。
+// 0段なら入力をそのまま出す
+TEST_F(AllpassDiffuserTest, StagesAreConfigurableAtRuntime) {
+  const std::vector<float> input = makeNoise(2);
+  AllpassDiffuser diffuser(sampleRate, 6, maxDelaySamples);
+  diffuser.setNumStages(0);
+  std::vector<float> output(numSamples);
+  diffuser.process(input.data(), output.data(), numSamples);
+  EXPECT_EQ(output, input);
+
+  diffuser.setNumStages(5);
+  diffuser.setDelaySamples(0, 2000);  // maxDelaySamples に丸める
+  diffuser.setDelayTime(1, 0.0013f);
+  diffuser.setDelaySamples(2, 0);  // 1 に丸める
+  diffuser.setGain(3, -0.5f);
+  diffuser.setGain(4, 1.5f);  // 0.99 に丸める
+  EXPECT_EQ(diffuser.getNumStages(), 5u);
+  EXPECT_EQ(diffuser.getDelaySamples(0), maxDelaySamples);
+  EXPECT_EQ(diffuser.getDelaySamples(1), 62);
+  EXPECT_EQ(diffuser.getDelaySamples(2), 1);
+  EXPECT_EQ(diffuser.getGain(4), 0.99f);
+
+  // AllpassFilter のゲインは [0, 0.99] なので、負のゲインは比べない
+  diffuser.setGain(3, 0.5f);
+  diffuser.reset();
+  const std::vector<float> expected = renderChain(diffuser, input);
+  output = reverb_harness::render(diffuser, input, 1000);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_NEAR(output[i], expected[i], 1e-6f) << "sample " << i;
+  }
+}
+
+// 減らした段を戻すと、その段は無音から始める
+TEST_F(AllpassDiffuserTest, ReenabledStageStartsSilent) {
+  const std::vector<float> input = makeNoise(3);
+  AllpassDiffuser diffuser(sampleRate, 2, maxDelaySamples);
+  AllpassDiffuser firstOnly(sampleRate, 1, maxDelaySamples);
+  std::vector<float> output(numSamples);
+  diffuser.process(input.data(), output.data(), numSamples);
+  firstOnly.process(input.data(), output.data(), numSamples);
+  diffuser.setNumStages(1);
+  diffuser.setNumStages(2);
+
+  // 2段目の遅延の間は、2段目の遅延線からは無音が出る: y = -g * x
+  const auto n = static_cast<size_t>(diffuser.getDelaySamples(1));
+  const std::vector<float> silence(n, 0.0f);
+  std::vector<float> both(n), first(n);
+  diffuser.process(silence.data(), both.data(), n);
+  firstOnly.process(silence.data(), first.data(), n);
+  const float g = diffuser.getGain(1);
+  for (size_t i = 0; i < n; ++i) {
+    ASSERT_NEAR(both[i], -g * first[i], 1e-6f) << "sample " << i;
+  }
+  EXPECT_GT(*std::max_element(first.begin(), first.end()), 0.01f);
+}
+
+// 段の設定と処理はメモリを確保しない
+TEST_F(AllpassDiffuserTest, DoesNotAllocate) {
+  const std::vector<float> input = makeNoise(4);
+  AllpassDiffuser diffuser(sampleRate, 8, maxDelaySamples);
+  std::vector<float> output(numSamples);
+
+  size_t allocations = 0;
+  {
+    alloc_counter::Scope scope;
+    diffuser.process(input.data(), output.data(), 256);
+    diffuser.setNumStages(4);
+    diffuser.setDelayTime(2, 0.005f);
+    diffuser.setGain(3, 0.6f);
+    diffuser.process(input.data(), output.data(), numSamples);
+    diffuser.reset();
+    allocations = scope.allocations();
+  }
+  EXPECT_EQ(allocations, 0u);
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "CombBank.h"
+#include "CombFilter.h"
+#include "Lfo.h"
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+// CombBank の各命令セット版が、CombFilter を並べて足し合わせた
+// スカラー処理と (ほぼ) 同じ出力になることを確認する
+class CombBankTest : public ::testing::TestWithParam<CombBank::Isa> {
+ protected:
+  const float sampleRate = 48000.0f;
+  const float damping = 0.4f;
+
+  static std::vector<float> makeNoise(size_t numSamples) {
+    std::vector<float> signal = reverb_harness::makeNoise(numSamples, 1234);
+    // 後半は無音にして減衰部分も比較する
+    std::fill(signal.begin() + numSamples / 2, signal.end(), 0.0f);
+    return signal;
+  }
+
+  void compareWithCombFilters(const std::vector<float>& delayTimes,
+                              const std::vector<float>& gains) {
+    int maxDelay = 0;
+    std::vector<CombFilter> reference;
+    for (size_t i = 0; i < delayTimes.size(); ++i) {
+      reference.emplace_back(sampleRate, delayTimes[i], gains[i], damping);
+      maxDelay = std::max(maxDelay, (int)(sampleRate * delayTimes[i]));
+    }
+
+    CombBank bank(delayTimes.size(), maxDelay);
+    if (!bank.setIsa(GetParam())) {
+      GTEST_SKIP() << "ISA not supported on this machine";
+    }
+    for (size_t i = 0; i < delayTimes.size(); ++i) {
+      bank.setDelaySamples(i, (int)(sampleRate * delayTimes[i]));
+      bank.setGain(i, gains[i]);
+      bank.setDamping(i, damping);
+    }
+
+    const std::vector<float> input = makeNoise(20000);
+    std::vector<float> actual(input.size());
+    // 半端な長さのブロックで処理する
+    for (size_t pos = 0; pos < input.size(); pos += 100) {
+      bank.process(&input[pos], &actual[pos], 100);
+    }
+
+    for (size_t i = 0; i < input.size(); ++i) {
+      float expected = 0.0f;
+      for (auto& comb : reference) {
+        expected += comb.process(input[i]);
+      }
+      // 各レーンの計算はスカラーと同じ順序なので、差は総和の順序による
+      // 丸め誤差だけになる (出力の大きさに対して 1e-6 以内)
+      const float tolerance = 1e-6f * std::max(1.0f, std::abs(expected));
+      ASSERT_NEAR(actual[i], expected, tolerance) << "at index " << i;
+    }
+  }
+};
+
+// 変調したコムフィルタを1サンプルずつ素直に計算した基準実装
+// (遅延を LFO で揺らし、隣り合う2サンプルを線形補間して読む)
+class ModulatedComb {
+ public:
+  ModulatedComb(int delay, float depth, float cyclesPerSample, float gain,
+                float damping)
+      : history_(4096, 0.0f),
+        delay_(delay),
+        depth_(depth),
+        gain_(gain),
+        damping_(damping) {
+    lfo_.setFrequency(cyclesPerSample);
+    lfo_.reset();
+  }
+
+  float process(float x) {
+    // CombBank と同じく、セグメントごとの係数から遅延を求める
+    const float base = delay_ + depth_ * lfo_.getSegmentStart();
+    const float slope = depth_ * lfo_.getSegmentSlope();
+    const float d = base + slope * static_cast<float>(lfo_.getPosition());
+    lfo_.advance(1);
+    const int di = static_cast<int>(d);
+    const float f = d - static_cast<float>(di);
+    const float a = history_[(n_ - di) & 4095];
+    const float delayed = a + f * (history_[(n_ - di - 1) & 4095] - a);
+    store_ = delayed * (1.0f - damping_) + store_ * damping_;
+    const float y = x + gain_ * store_;
+    history_[n_ & 4095] = y;
+    ++n_;
+    return y;
+  }
+
+ private:
+  std::vector<float> history_;
+  Lfo lfo_;
+  int n_ = 0;
+  int delay_;
+  float depth_;
+  float gain_;
+  float damping_;
+  float store_ = 0.0f;
+};
+
+TEST_P(CombBankTest, ModulatedMatchesReference) {
+  const int delays[] = {1201, 1307, 1409, 1511, 1613, 1709, 1801, 1907};
+  const float depths[] = {12.0f, 7.5f, 0.0f, 20.0f, 3.0f, 9.0f, 15.0f, 1.0f};
+  CombBank bank(8, 2047);
+  if (!bank.setIsa(GetParam())) {
+    GTEST_SKIP() << "ISA not supported on this machine";
+  }
+  std::vector<ModulatedComb> reference;
+  for (size_t i = 0; i < 8; ++i) {
+    const float cyclesPerSample = (0.5f + 0.3f * i) / sampleRate;
+    bank.setDelaySamples(i, delays[i]);
+    bank.setGain(i, 0.84f);
+    bank.setDamping(i, damping);
+    bank.setModulation(i, depths[i], cyclesPerSample);
+    reference.emplace_back(delays[i], depths[i], cyclesPerSample, 0.84f,
+                           damping);
+  }
+  bank.reset();  // LFO を新しい周波数で最初から始める
+  EXPECT_TRUE(bank.isModulated());
+
+  const std::vector<float> input = makeNoise(20000);
+  std::vector<float> actual(input.size());
+  for (size_t pos = 0; pos < input.size(); pos += 100) {
+    bank.process(&input[pos], &actual[pos], 100);
+  }
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    float expected = 0.0f;
+    for (auto& comb : reference) {
+      expected += comb.process(input[i]);
+    }
+    // SIMD 版は積和演算の丸めが違うことがあるので、わずかな差は許容する
+    const float tolerance = 1e-4f * std::max(1.0f, std::abs(expected));
+    ASSERT_NEAR(actual[i], expected, tolerance) << "at index " << i;
+  }
+}
+
+// depth を 0 に戻すと、変調しないカーネルと同じ出力になる
+TEST_P(CombBankTest, ZeroDepthMatchesUnmodulated) {
+  CombBank plain(4, 2047);
+  CombBank modulated(4, 2047);
+  if (!plain.setIsa(GetParam()) || !modulated.setIsa(GetParam())) {
+    GTEST_SKIP() << "ISA not supported on this machine";
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    for (CombBank* bank : {&plain, &modulated}) {
+      bank->setDelaySamples(i, 1000 + 100 * static_cast<int>(i));
+      bank->setGain(i, 0.8f);
+      bank->setDamping(i, damping);
+    }
+    modulated.setModulation(i, 0.0f, 1.0f / sampleRate);
+  }
+  EXPECT_FALSE(modulated.isModulated());
+  modulated.setModulation(0, 4.0f, 1.0f / sampleRate);
+  EXPECT_TRUE(modulated.isModulated());
+  modulated.setModulation(0, 0.0f, 1.0f / sampleRate);
+  EXPECT_FALSE(modulated.isModulated());
+
+  const std::vector<float> input = makeNoise(5000);
+  std::vector<float> expected(input.size()), actual(input.size());
+  plain.process(input.data(), expected.data(), input.size());
+  modulated.process(input.data(), actual.data(), input.size());
+  for (size_t i = 0; i < input.size(); ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at index " << i;
+  }
+}
+
+TEST_P(CombBankTest, FourCombsMatchScalarCombFilters) {
+  compareWithCombFilters({0.0297f, 0.0371f, 0.0411f, 0.0437f},
+                         {0.85f, 0.82f, 0.80f, 0.86f});
+}
+
+TEST_P(CombBankTest, EightCombsMatchScalarCombFilters) {
+  compareWithCombFilters(
+      {0.0253f, 0.0269f, 0.0290f, 0.0307f, 0.0322f, 0.0338f, 0.0353f, 0.0367f},
+      {0.84f, 0.84f, 0.84f, 0.84f, 0.84f, 0.84f, 0.84f, 0.84f});
+}
+
+TEST_P(CombBankTest, ThreeCombsIgnorePaddingLane) {
+  compareWithCombFilters({0.0011f, 0.0023f, 0.0007f}, {0.5f, 0.7f, 0.9f});
+}
+
+INSTANTIATE_TEST_SUITE_P(AllIsas, CombBankTest,
+                         ::testing::Values(CombBank::Isa::Scalar,
+                                           CombBank::Isa::SSE2,
+                                           CombBank::Isa::AVX2,
+                                           CombBank::Isa::NEON),
+                         [](const auto& info) -> std::string {
+                           switch (info.param) {
+                             case CombBank::Isa::SSE2:
+                               return "SSE2";
+                             case CombBank::Isa::AVX2:
+                               return "AVX2";
+                             case CombBank::Isa::NEON:
+                               return "NEON";
+                             default:
+                               return "Scalar";
+                           }
+                         });
+
+TEST(CombBankDispatchTest, DetectsSupportedIsa) {
+  CombBank four(4, 1000);
+  EXPECT_TRUE(CombBank::isSupported(four.getIsa(), 4));
+  // AVX2 は8レーンのときだけ選ばれる
+  EXPECT_NE(four.getIsa(), CombBank::Isa::AVX2);
+  EXPECT_TRUE(four.setIsa(CombBank::Isa::Scalar));
+  EXPECT_EQ(four.getIsa(), CombBank::Isa::Scalar);
+}
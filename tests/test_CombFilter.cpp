@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 #include "CombFilter.h"
 #include "gtest/gtest.h"
 
@@ -6,6 +10,9 @@ class CombFilterTest : public ::testing::Test {
   const float sampleRate = 48000.0f;
   const float delayTime = 0.0005f;  // 10ms
   const float gain = 0.5f;
+  const float damping = 0.4f;
+  // ダンピング (1次ローパス) を通った最初のエコーの係数
+  const float firstEchoScale = 1.0f - damping;
 };
 
 TEST_F(CombFilterTest, Construction) {
@@ -48,8 +55,8 @@ TEST_F(CombFilterTest, ProcessWithFeedback) {
     EXPECT_FLOAT_EQ(filter.process(0.0f), 0.0f);
   }
 
-  // After delay, should get gain * input
-  EXPECT_FLOAT_EQ(filter.process(0.0f), 0.5f);
+  // After delay, should get gain * input (through the damping lowpass)
+  EXPECT_FLOAT_EQ(filter.process(0.0f), 0.5f * firstEchoScale);
 }
 
 TEST_F(CombFilterTest, UpdateParameters) {
@@ -72,14 +79,14 @@ TEST_F(CombFilterTest, UpdateParameters) {
   for (int i = 0; i < newDelaySamples - 1; i++) {
     filter.process(0.0f);
   }
-  EXPECT_FLOAT_EQ(filter.process(0.0f), newGain);
+  EXPECT_FLOAT_EQ(filter.process(0.0f), newGain * firstEchoScale);
 }
 
 TEST_F(CombFilterTest, EdgeCases) {
   // Very short delay
   CombFilter shortDelay(sampleRate, 1.0f / sampleRate, gain, 0.4f);
   EXPECT_FLOAT_EQ(shortDelay.process(1.0f), 1.0f);
-  EXPECT_FLOAT_EQ(shortDelay.process(0.0f), 0.5f);
+  EXPECT_FLOAT_EQ(shortDelay.process(0.0f), 0.5f * firstEchoScale);
 
   // Very small gain
   CombFilter smallGain(sampleRate, delayTime, 0.001f, 0.4f);
@@ -88,4 +95,59 @@ TEST_F(CombFilterTest, EdgeCases) {
   // Very large gain
   CombFilter largeGain(sampleRate, delayTime, 0.999f, 0.4f);
   EXPECT_FLOAT_EQ(largeGain.process(1.0f), 1.0f);
-}
\ No newline at end of file
+}
+TEST_F(CombFilterTest, BlockProcessMatchesPerSample) {
+  CombFilter perSample(sampleRate, delayTime, gain, damping);
+  CombFilter block(sampleRate, delayTime, gain, damping);
+
+  // 遅延長 (24 samples) より長いブロックも含めて比較する
+  std::vector<float> input(1000, 0.0f);
+  input[0] = 1.0f;
+  input[37] = -0.5f;
+  std::vector<float> expected(input.size());
+  for (size_t i = 0; i < input.size(); ++i) {
+    expected[i] = perSample.process(input[i]);
+  }
+
+  std::vector<float> actual(input.size());
+  const size_t blockSizes[] = {1, 7, 24, 64, 256};
+  size_t pos = 0;
+  for (size_t b = 0; pos < input.size(); ++b) {
+    const size_t n = std::min(blockSizes[b % 5], input.size() - pos);
+    block.process(&input[pos], &actual[pos], n);
+    pos += n;
+  }
+
+  for (size_t i = 0; i < input.size(); ++i) {
+    EXPECT_FLOAT_EQ(actual[i], expected[i]) << "at index " << i;
+  }
+}
+
+// 入力が止まった後の減衰は、非正規化数を経ずに0になる (DenormalGuard)
+TEST_F(CombFilterTest, DecayingTailHasNoSubnormals) {
+  CombFilter filter(sampleRate, delayTime, gain, damping);
+  // 0.5 倍ずつの減衰なら、約 150 周 (3600 samples) で非正規化数の範囲を過ぎる
+  std::vector<float> input(8000, 0.0f), output(input.size());
+  input[0] = 1.0f;
+  for (size_t pos = 0; pos < input.size(); pos += 64) {
+    filter.process(&input[pos], &output[pos], 64);
+  }
+  for (size_t i = 0; i < output.size(); ++i) {
+    ASSERT_NE(std::fpclassify(output[i]), FP_SUBNORMAL) << "at index " << i;
+  }
+  EXPECT_EQ(output.back(), 0.0f);
+}
+
+// setSampleRate は遅延時間 (秒) を保ったまま遅延長を換算し直す
+TEST_F(CombFilterTest, SetSampleRateRescalesDelay) {
+  CombFilter filter(sampleRate, delayTime, gain, 0.0f);
+  filter.setSampleRate(sampleRate * 2);
+  filter.reset();
+
+  const int delaySamples = static_cast<int>(sampleRate * 2 * delayTime);
+  EXPECT_FLOAT_EQ(filter.process(1.0f), 1.0f);
+  for (int i = 1; i < delaySamples; ++i) {
+    EXPECT_FLOAT_EQ(filter.process(0.0f), 0.0f) << "at index " << i;
+  }
+  EXPECT_FLOAT_EQ(filter.process(0.0f), gain);
+}
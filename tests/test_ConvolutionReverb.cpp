@@ -0,0 +1,174 @@
+#include "ConvolutionReverb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+class ConvolutionReverbTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 12000;
+
+  // 指数的に減衰するノイズ (部屋の IR の代わり)
+  static std::vector<float> makeImpulseResponse(size_t length) {
+    std::vector<float> ir = reverb_harness::makeNoise(length, 5);
+    for (size_t i = 0; i < length; ++i) {
+      ir[i] *= 0.3f * std::exp(-static_cast<float>(i) / 3000.0f);
+    }
+    return ir;
+  }
+
+  // 定義どおりの畳み込み (double で計算)
+  static std::vector<float> convolve(const std::vector<float>& input,
+                                     const std::vector<float>& ir) {
+    std::vector<float> output(input.size());
+    for (size_t n = 0; n < input.size(); ++n) {
+      double sum = 0.0;
+      for (size_t k = 0; k < ir.size() && k <= n; ++k) {
+        sum += static_cast<double>(ir[k]) * input[n - k];
+      }
+      output[n] = static_cast<float>(sum);
+    }
+    return output;
+  }
+
+  // 半端な長さのブロックに分けて処理する
+  static std::vector<float> render(ConvolutionReverb& reverb,
+                                   const std::vector<float>& input) {
+    std::vector<float> output(input.size());
+    for (size_t pos = 0; pos < input.size(); pos += 37) {
+      const size_t n = std::min<size_t>(37, input.size() - pos);
+      reverb.process(input.data() + pos, output.data() + pos, n);
+    }
+    return output;
+  }
+};
+
+// 先頭・各段・末尾の境目を含むどの長さの IR でも、直接の畳み込みと一致する
+TEST_F(ConvolutionReverbTest, MatchesDirectConvolution) {
+  const std::vector<float> input = reverb_harness::makeNoise(numSamples, 1);
+  for (size_t length : {1u, 50u, 64u, 65u, 300u, 2048u, 2049u, 9000u}) {
+    const std::vector<float> ir = makeImpulseResponse(length);
+    ConvolutionReverb reverb(sampleRate, ir.data(), ir.size(), 64, 1024,
+                             false);
+    reverb.setWetLevel(1.0f);
+    reverb.reset();
+    EXPECT_EQ(reverb.hasTail(), length > 2048) << length;
+
+    const std::vector<float> expected = convolve(input, ir);
+    const std::vector<float> actual = render(reverb, input);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_NEAR(actual[i], expected[i], 1e-4f)
+          << "IR length " << length << " at sample " << i;
+    }
+  }
+}
+
+// 区間の分け方を変えても同じ畳み込みになる
+TEST_F(ConvolutionReverbTest, PartitionSizesGiveSameResult) {
+  const std::vector<float> input = reverb_harness::makeNoise(numSamples, 2);
+  const std::vector<float> ir = makeImpulseResponse(7000);
+  ConvolutionReverb small(sampleRate, ir.data(), ir.size(), 16, 64, false);
+  ConvolutionReverb large(sampleRate, ir.data(), ir.size(), 256, 2048, false);
+  EXPECT_EQ(small.getHeadSize(), 16u);
+  EXPECT_EQ(small.getTailBlockSize(), 64u);
+  EXPECT_GT(small.getNumStages(), 0u);
+  small.setWetLevel(1.0f);
+  small.reset();
+  large.setWetLevel(1.0f);
+  large.reset();
+
+  const std::vector<float> a = render(small, input);
+  const std::vector<float> b = render(large, input);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_NEAR(a[i], b[i], 1e-4f) << "at sample " << i;
+  }
+}
+
+// 末尾をワーカースレッドで計算しても、同期モードと全く同じ出力になる
+TEST_F(ConvolutionReverbTest, BackgroundTailMatchesSynchronous) {
+  const std::vector<float> input = reverb_harness::makeNoise(numSamples, 3);
+  const std::vector<float> ir = makeImpulseResponse(20000);
+  ConvolutionReverb synchronous(sampleRate, ir.data(), ir.size(), 64, 256,
+                                false);
+  ConvolutionReverb background(sampleRate, ir.data(), ir.size(), 64, 256,
+                               true);
+
+  const std::vector<float> expected = render(synchronous, input);
+  const std::vector<float> actual = render(background, input);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+  EXPECT_EQ(background.getStats().tailBlocks, numSamples / 256);
+}
+
+// 呼び出し側のブロック長によらず同じ出力になる
+TEST_F(ConvolutionReverbTest, IndependentOfBlockSize) {
+  const std::vector<float> input = reverb_harness::makeNoise(numSamples, 4);
+  const std::vector<float> ir = makeImpulseResponse(5000);
+  ConvolutionReverb wholeBlocks(sampleRate, ir.data(), ir.size());
+  ConvolutionReverb singleSamples(sampleRate, ir.data(), ir.size());
+
+  std::vector<float> expected(numSamples), actual(numSamples);
+  wholeBlocks.process(input.data(), expected.data(), numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    actual[i] = singleSamples.process(input[i]);
+  }
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+}
+
+// reset() の後は、新しいインスタンスと同じ出力になる
+TEST_F(ConvolutionReverbTest, ResetClearsState) {
+  const std::vector<float> input = reverb_harness::makeNoise(numSamples, 6);
+  const std::vector<float> ir = makeImpulseResponse(9000);
+  ConvolutionReverb used(sampleRate, ir.data(), ir.size());
+  ConvolutionReverb fresh(sampleRate, ir.data(), ir.size());
+
+  render(used, input);
+  used.reset();
+  const std::vector<float> expected = render(fresh, input);
+  const std::vector<float> actual = render(used, input);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+}
+
+TEST_F(ConvolutionReverbTest, DryOnlyWhenWetIsZero) {
+  const std::vector<float> input = reverb_harness::makeNoise(numSamples, 7);
+  const std::vector<float> ir = makeImpulseResponse(3000);
+  ConvolutionReverb reverb(sampleRate, ir.data(), ir.size());
+  reverb.setWetLevel(0.0f);
+  reverb.reset();
+  const std::vector<float> output = render(reverb, input);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(output[i], input[i]) << "at sample " << i;
+  }
+}
+
+// 数秒の IR でも process() はメモリを確保しない (ワーカーも含めて)
+TEST_F(ConvolutionReverbTest, ProcessDoesNotAllocate) {
+  const std::vector<float> input = reverb_harness::makeNoise(numSamples, 8);
+  const std::vector<float> ir =
+      makeImpulseResponse(static_cast<size_t>(2 * sampleRate));
+  ConvolutionReverb reverb(sampleRate, ir.data(), ir.size());
+  std::vector<float> output(numSamples);
+
+  size_t allocations = 0;
+  {
+    alloc_counter::Scope scope;
+    for (size_t pos = 0; pos < numSamples; pos += 128) {
+      const size_t n = std::min<size_t>(128, numSamples - pos);
+      reverb.process(input.data() + pos, output.data() + pos, n);
+    }
+    allocations = scope.allocations();
+  }
+  EXPECT_EQ(allocations, 0u);
+  EXPECT_TRUE(std::all_of(output.begin(), output.end(),
+                          [](float x) { return std::isfinite(x); }));
+}
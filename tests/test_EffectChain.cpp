@@ -0,0 +1,234 @@
+#include "EffectChain.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "AllpassFilter.h"
+#include "CombFilter.h"
+#include "Reverb.h"
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// process の呼び出し回数と長さを数え、入力をそのまま出すノード
+class CountingEffect final : public AudioEffect {
+ public:
+  void process(const float* input, float* output,
+               size_t numSamples) override {
+    ++calls;
+    samples += numSamples;
+    std::copy_n(input, numSamples, output);
+  }
+  void reset() override { ++resets; }
+
+  size_t calls = 0;
+  size_t samples = 0;
+  size_t resets = 0;
+};
+
+}  // namespace
+
+class EffectChainTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 4800;
+  const size_t blockSize = 256;
+
+  std::vector<float> makeNoise(unsigned seed) {
+    return reverb_harness::makeNoise(numSamples, seed);
+  }
+
+  CombFilter makeComb(float delayTime) {
+    return CombFilter(sampleRate, delayTime, 0.8f, 0.3f);
+  }
+  AllpassFilter makeAllpass(float delayTime) {
+    return AllpassFilter(sampleRate, delayTime, 0.7f,
+                         static_cast<int>(sampleRate * 0.02f));
+  }
+};
+
+// 直列のチェーンは、同じノードを順に呼んだのと同じ出力になる
+TEST_F(EffectChainTest, SerialChainMatchesDirectCalls) {
+  const std::vector<float> input = makeNoise(1);
+  EffectChain chain;
+  chain.emplace<CombFilter>(makeComb(0.0297f));
+  chain.emplace<AllpassFilter>(makeAllpass(0.0098f));
+  chain.emplace<AllpassFilter>(makeAllpass(0.0031f));
+  EXPECT_EQ(chain.size(), 3u);
+
+  CombFilter comb = makeComb(0.0297f);
+  AllpassFilter allpass1 = makeAllpass(0.0098f);
+  AllpassFilter allpass2 = makeAllpass(0.0031f);
+
+  using reverb_harness::render;
+  const std::vector<float> output = render(chain, input, blockSize);
+  const std::vector<float> expected = render(
+      allpass2, render(allpass1, render(comb, input, blockSize), blockSize),
+      blockSize);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(output[i], expected[i]) << "sample " << i;
+  }
+}
+
+// 並列の枝はゲインを掛けて足す。プールのブロック長より長いブロックも、
+// input == output (in-place) でも同じ結果になる
+TEST_F(EffectChainTest, ParallelSumsBranchesWithGains) {
+  std::vector<float> buffer = makeNoise(2);
+  const std::vector<float> input = buffer;
+  BufferPool pool(2, 64);
+  EffectParallel parallel(pool);
+  parallel.emplaceBranch<CombFilter>(0.7f, makeComb(0.0297f));
+  parallel.emplaceBranch<CombFilter>(0.3f, makeComb(0.0371f));
+  EXPECT_EQ(parallel.getNumBranches(), 2u);
+
+  CombFilter comb1 = makeComb(0.0297f);
+  CombFilter comb2 = makeComb(0.0371f);
+  std::vector<float> out1(numSamples), out2(numSamples);
+  comb1.process(input.data(), out1.data(), numSamples);
+  comb2.process(input.data(), out2.data(), numSamples);
+
+  const size_t longBlock = 1000;
+  for (size_t i = 0; i < numSamples; i += longBlock) {
+    const size_t n = std::min(longBlock, numSamples - i);
+    parallel.process(&buffer[i], &buffer[i], n);
+  }
+  for (size_t i = 0; i < numSamples; ++i) {
+    const float expected = (0.0f + 0.7f * out1[i]) + 0.3f * out2[i];
+    ASSERT_EQ(buffer[i], expected) << "sample " << i;
+  }
+  EXPECT_EQ(pool.getNumFree(), 2u);
+  EXPECT_EQ(parallel.getStats().starvedBlocks, 0u);
+}
+
+// 2つのソースのセンドを共有のリバーブバスでまとめて処理する
+TEST_F(EffectChainTest, SendsShareOneReverbBus) {
+  const std::vector<float> source1 = makeNoise(3);
+  const std::vector<float> source2 = makeNoise(4);
+
+  Reverb busReverb(sampleRate);
+  busReverb.setWetLevel(1.0f);
+  busReverb.reset();
+  EffectBus bus(busReverb, blockSize);
+
+  EffectChain chain1;
+  chain1.emplace<CombFilter>(makeComb(0.0297f));
+  chain1.emplace<EffectSend>(bus, 0.5f);
+  EffectChain chain2;
+  chain2.emplace<EffectSend>(bus, 0.25f);
+
+  // 比較用: センドの総和を直接リバーブに通す
+  CombFilter comb = makeComb(0.0297f);
+  Reverb reverb(sampleRate);
+  reverb.setWetLevel(1.0f);
+  reverb.reset();
+
+  std::vector<float> out1(blockSize), out2(blockSize), mix(blockSize);
+  std::vector<float> dry(blockSize), send(blockSize), wet(blockSize);
+  for (size_t i = 0; i < numSamples; i += blockSize) {
+    const size_t n = std::min(blockSize, numSamples - i);
+    chain1.process(&source1[i], out1.data(), n);
+    chain2.process(&source2[i], out2.data(), n);
+    for (size_t j = 0; j < n; ++j) {
+      mix[j] = out1[j] + out2[j];
+    }
+    bus.processReturn(mix.data(), n);
+
+    comb.process(&source1[i], dry.data(), n);
+    for (size_t j = 0; j < n; ++j) {
+      send[j] = (0.0f + 0.5f * dry[j]) + 0.25f * source2[i + j];
+    }
+    reverb.process(send.data(), wet.data(), n);
+    for (size_t j = 0; j < n; ++j) {
+      ASSERT_EQ(mix[j], (dry[j] + source2[i + j]) + wet[j]) << i + j;
+    }
+  }
+}
+
+// 並列の中でブロックが分けられても、センドはバスの続きの位置に足す
+TEST_F(EffectChainTest, SendInsideParallelKeepsPosition) {
+  const std::vector<float> input = makeNoise(5);
+  CountingEffect busEffect;
+  EffectBus bus(busEffect, blockSize);
+  BufferPool pool(2, 64);
+  EffectParallel parallel(pool);
+  parallel.emplaceBranch<EffectSend>(1.0f, bus, 2.0f);
+
+  std::vector<float> output(blockSize), returned(blockSize);
+  for (size_t i = 0; i + blockSize <= numSamples; i += blockSize) {
+    parallel.process(&input[i], output.data(), blockSize);
+    std::fill(returned.begin(), returned.end(), 0.0f);
+    bus.processReturn(returned.data(), blockSize);
+    for (size_t j = 0; j < blockSize; ++j) {
+      ASSERT_EQ(output[j], input[i + j]);
+      ASSERT_EQ(returned[j], 2.0f * input[i + j]) << i + j;
+    }
+  }
+}
+
+// 仮想呼び出しはノードごとにブロック1回
+TEST_F(EffectChainTest, DispatchesOncePerBlock) {
+  const std::vector<float> input = makeNoise(6);
+  std::vector<float> output(numSamples);
+  CountingEffect first, second;
+  EffectChain chain;
+  chain.add(first);
+  chain.add(second);
+  chain.process(input.data(), output.data(), numSamples);
+  EXPECT_EQ(first.calls, 1u);
+  EXPECT_EQ(second.calls, 1u);
+  EXPECT_EQ(second.samples, numSamples);
+  EXPECT_EQ(output, input);
+
+  chain.reset();
+  EXPECT_EQ(first.resets, 1u);
+  EXPECT_EQ(second.resets, 1u);
+}
+
+// 組み立てたグラフの処理はメモリを確保しない
+TEST_F(EffectChainTest, ProcessDoesNotAllocate) {
+  const std::vector<float> input = makeNoise(7);
+  std::vector<float> output(numSamples);
+  Reverb busReverb(sampleRate);
+  EffectBus bus(busReverb, blockSize);
+  BufferPool pool(4, blockSize);
+
+  EffectChain chain;
+  auto& parallel = chain.emplace<EffectParallel>(pool);
+  parallel.emplaceBranch<CombFilter>(0.5f, makeComb(0.0297f));
+  auto& inner = parallel.emplaceBranch<EffectParallel>(0.5f, pool);
+  inner.emplaceBranch<AllpassFilter>(1.0f, makeAllpass(0.0098f));
+  chain.emplace<EffectSend>(bus, 0.3f);
+
+  size_t allocations = 0;
+  {
+    alloc_counter::Scope scope;
+    for (size_t i = 0; i < numSamples; i += blockSize) {
+      const size_t n = std::min(blockSize, numSamples - i);
+      chain.process(&input[i], &output[i], n);
+      bus.processReturn(&output[i], n);
+    }
+    allocations = scope.allocations();
+  }
+  EXPECT_EQ(allocations, 0u);
+  EXPECT_EQ(parallel.getStats().starvedBlocks, 0u);
+  EXPECT_EQ(inner.getStats().starvedBlocks, 0u);
+}
+
+// 作業バッファが足りなければ無音を出して数える
+TEST_F(EffectChainTest, StarvedPoolOutputsSilence) {
+  const std::vector<float> input = makeNoise(8);
+  std::vector<float> output(blockSize, 1.0f);
+  BufferPool pool(1, blockSize);
+  EffectParallel parallel(pool);
+  parallel.emplaceBranch<CountingEffect>(1.0f);
+
+  parallel.process(input.data(), output.data(), blockSize);
+  EXPECT_TRUE(std::all_of(output.begin(), output.end(),
+                          [](float x) { return x == 0.0f; }));
+  EXPECT_EQ(parallel.getStats().starvedBlocks, 1u);
+  EXPECT_EQ(pool.getNumFree(), 1u);
+  parallel.resetStats();
+  EXPECT_EQ(parallel.getStats().starvedBlocks, 0u);
+}
@@ -0,0 +1,107 @@
+#include "FdnReverb.h"
+
+#include <cmath>
+#include <vector>
+
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+class FdnReverbTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 8000;
+
+  std::vector<float> makeNoise() {
+    return reverb_harness::makeNoise(numSamples, 11);
+  }
+
+  // 長さ length のインパルス応答
+  static std::vector<float> impulseResponse(FdnReverb& reverb, size_t length) {
+    std::vector<float> input(length, 0.0f), output(length);
+    input[0] = 1.0f;
+    reverb.process(input.data(), output.data(), length);
+    return output;
+  }
+
+  static double energy(const std::vector<float>& signal, size_t begin,
+                       size_t end) {
+    double sum = 0.0;
+    for (size_t i = begin; i < end; ++i) sum += signal[i] * signal[i];
+    return sum;
+  }
+};
+
+// 線の数は [kMinLines, kMaxLines] の2のべき乗に切り下げる
+TEST_F(FdnReverbTest, NumLinesIsPowerOfTwo) {
+  EXPECT_EQ(FdnReverb(sampleRate, 1).getNumLines(), 4u);
+  EXPECT_EQ(FdnReverb(sampleRate, 8).getNumLines(), 8u);
+  EXPECT_EQ(FdnReverb(sampleRate, 12).getNumLines(), 8u);
+  EXPECT_EQ(FdnReverb(sampleRate, 100).getNumLines(), 16u);
+}
+
+TEST_F(FdnReverbTest, DryOnlyWhenWetIsZero) {
+  const std::vector<float> input = makeNoise();
+  FdnReverb reverb(sampleRate);
+  reverb.setWetLevel(0.0f);
+  reverb.reset();
+  std::vector<float> output(numSamples);
+  reverb.process(input.data(), output.data(), numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(output[i], input[i]) << "at sample " << i;
+  }
+}
+
+// decay を大きくすると残響が長くなり、どの設定でも最後は減衰する
+TEST_F(FdnReverbTest, DecayControlsTailLength) {
+  for (size_t numLines : {8u, 16u}) {
+    FdnReverb shortTail(sampleRate, numLines);
+    FdnReverb longTail(sampleRate, numLines);
+    shortTail.setWetLevel(1.0f);
+    shortTail.setDecay(0.2f);
+    shortTail.reset();
+    longTail.setWetLevel(1.0f);
+    longTail.setDecay(0.9f);
+    longTail.reset();
+
+    const size_t second = static_cast<size_t>(sampleRate);
+    const std::vector<float> shortResponse =
+        impulseResponse(shortTail, 2 * second);
+    const std::vector<float> longResponse =
+        impulseResponse(longTail, 2 * second);
+    const double shortLate = energy(shortResponse, second / 2, second);
+    const double longLate = energy(longResponse, second / 2, second);
+    EXPECT_GT(longLate, shortLate * 10.0) << numLines << " lines";
+
+    // 長い残響でも、時間が経つと確実に小さくなる
+    const double longLater =
+        energy(longResponse, second + second / 2, 2 * second);
+    EXPECT_LT(longLater, longLate * 0.5) << numLines << " lines";
+  }
+}
+
+// パラメータのランプは、呼び出し側のブロック長によらず同じ出力になる
+TEST_F(FdnReverbTest, ParameterRampIndependentOfBlockSize) {
+  const std::vector<float> input = makeNoise();
+  FdnReverb wholeBlocks(sampleRate, 16);
+  FdnReverb singleSamples(sampleRate, 16);
+
+  std::vector<float> expected(numSamples), actual(numSamples);
+  const size_t half = numSamples / 2;
+  wholeBlocks.process(input.data(), expected.data(), half);
+  wholeBlocks.setDecay(0.95f);
+  wholeBlocks.setDamping(0.1f);
+  wholeBlocks.setWetLevel(0.8f);
+  wholeBlocks.process(input.data() + half, expected.data() + half, half);
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    if (i == half) {
+      singleSamples.setDecay(0.95f);
+      singleSamples.setDamping(0.1f);
+      singleSamples.setWetLevel(0.8f);
+    }
+    actual[i] = singleSamples.process(input[i]);
+  }
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+}
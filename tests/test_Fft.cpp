@@ -0,0 +1,52 @@
+#include "Fft.h"
+
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+namespace {
+std::vector<float> makeNoise(size_t size) {
+  return reverb_harness::makeNoise(size, 3);
+}
+}  // namespace
+
+// 定義どおりの DFT と一致する
+TEST(RealFftTest, MatchesDirectDft) {
+  for (size_t size = 2; size <= 512; size *= 2) {
+    const std::vector<float> input = makeNoise(size);
+    RealFft fft(size);
+    ASSERT_EQ(fft.getNumBins(), size / 2 + 1);
+    std::vector<float> re(fft.getNumBins()), im(fft.getNumBins());
+    fft.forward(input.data(), re.data(), im.data());
+
+    for (size_t k = 0; k < fft.getNumBins(); ++k) {
+      double expectedRe = 0.0, expectedIm = 0.0;
+      for (size_t n = 0; n < size; ++n) {
+        const double angle = -2.0 * std::numbers::pi * k * n / size;
+        expectedRe += input[n] * std::cos(angle);
+        expectedIm += input[n] * std::sin(angle);
+      }
+      ASSERT_NEAR(re[k], expectedRe, 1e-4) << "size " << size << " bin " << k;
+      ASSERT_NEAR(im[k], expectedIm, 1e-4) << "size " << size << " bin " << k;
+    }
+  }
+}
+
+// inverse(forward(x)) は x の size 倍
+TEST(RealFftTest, InverseRestoresInput) {
+  for (size_t size = 2; size <= 4096; size *= 2) {
+    const std::vector<float> input = makeNoise(size);
+    RealFft fft(size);
+    std::vector<float> re(fft.getNumBins()), im(fft.getNumBins());
+    std::vector<float> output(size);
+    fft.forward(input.data(), re.data(), im.data());
+    fft.inverse(re.data(), im.data(), output.data());
+    for (size_t n = 0; n < size; ++n) {
+      ASSERT_NEAR(output[n] / static_cast<float>(size), input[n], 1e-5f)
+          << "size " << size << " at " << n;
+    }
+  }
+}
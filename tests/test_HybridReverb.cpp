@@ -0,0 +1,167 @@
+#include "HybridReverb.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "Reverb.h"
+#include "ReverbHarness.h"
+#include "ReverbTuning.h"
+#include "gtest/gtest.h"
+
+class HybridReverbTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 12000;
+
+  std::vector<float> makeNoise() {
+    return reverb_harness::makeNoise(numSamples, 13);
+  }
+
+  // 半端な長さのブロックに分けて処理する
+  static std::vector<float> render(HybridReverb& reverb,
+                                   const std::vector<float>& input) {
+    std::vector<float> output(input.size());
+    for (size_t pos = 0; pos < input.size(); pos += 100) {
+      const size_t n = std::min<size_t>(100, input.size() - pos);
+      reverb.process(input.data() + pos, output.data() + pos, n);
+    }
+    return output;
+  }
+};
+
+// 残響は、1スレッドの Reverb の wet を 2 * tailBlockSize 遅らせたものと
+// 一致する
+TEST_F(HybridReverbTest, TailMatchesDelayedReverb) {
+  const std::vector<float> input = makeNoise();
+  Reverb reference(sampleRate);
+  reference.setWetLevel(1.0f);
+  reference.setDecay(0.9f);
+  reference.reset();
+  std::vector<float> expected(numSamples);
+  reference.process(input.data(), expected.data(), numSamples);
+
+  for (bool background : {false, true}) {
+    HybridReverb reverb(sampleRate, 256, background);
+    const size_t latency = reverb.getTailLatency();
+    EXPECT_EQ(latency, 512u);
+    reverb.setWetLevel(1.0f);
+    reverb.setEarlyLevel(0.0f);
+    reverb.setDecay(0.9f);
+    reverb.reset();
+    const std::vector<float> actual = render(reverb, input);
+    for (size_t i = 0; i < numSamples; ++i) {
+      const float delayed = i < latency ? 0.0f : expected[i - latency];
+      ASSERT_EQ(actual[i], delayed)
+          << "background " << background << " at sample " << i;
+    }
+  }
+}
+
+// ワーカーで残響を計算しても、同期モードと全く同じ出力になる
+TEST_F(HybridReverbTest, BackgroundTailMatchesSynchronous) {
+  const std::vector<float> input = makeNoise();
+  HybridReverb synchronous(sampleRate, 128, false);
+  HybridReverb background(sampleRate, 128, true);
+
+  const std::vector<float> expected = render(synchronous, input);
+  const std::vector<float> actual = render(background, input);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+  EXPECT_EQ(background.getStats().tailBlocks, numSamples / 128);
+}
+
+// インパルス応答は、初期反射のタップと 2 * tailBlockSize 遅れた残響の和
+TEST_F(HybridReverbTest, ImpulseResponseIsTapsPlusDelayedTail) {
+  using namespace reverb_tuning;
+  const size_t length = 6000;
+  std::vector<float> input(length, 0.0f), output(length);
+  input[0] = 1.0f;
+
+  Reverb reference(sampleRate);
+  reference.setWetLevel(1.0f);
+  reference.reset();
+  std::vector<float> tail(length);
+  reference.process(input.data(), tail.data(), length);
+
+  HybridReverb reverb(sampleRate, 256, false);
+  reverb.setWetLevel(1.0f);
+  reverb.setEarlyLevel(1.0f);
+  reverb.reset();
+  reverb.process(input.data(), output.data(), length);
+
+  std::vector<float> expected(length, 0.0f);
+  const size_t latency = reverb.getTailLatency();
+  for (size_t i = latency; i < length; ++i) {
+    expected[i] = tail[i - latency];
+  }
+  for (size_t t = 0; t < kNumEarlyTaps; ++t) {
+    const auto delay = static_cast<size_t>(
+        std::max(delaySamples(sampleRate, kEarlyTapTimes[t]), 1));
+    expected[delay] += kEarlyTapGains[t] * kEarlyMixGain;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_NEAR(output[i], expected[i], 1e-6f) << "at sample " << i;
+  }
+}
+
+// ホストのブロック長が tailBlockSize より長くても (2倍まで)、ワーカーは
+// コールバックの合間に計算を終えるので、音声スレッドは待たない
+TEST_F(HybridReverbTest, LargeHostBlocksDoNotWaitForTail) {
+  const size_t tailBlockSize = 256;
+  const size_t hostBlockSize = 2 * tailBlockSize;
+  const size_t numBlocks = 40;
+  const std::vector<float> input = makeNoise();
+  HybridReverb reverb(sampleRate, tailBlockSize, true);
+  reverb.setDecay(1.0f);
+  std::vector<float> output(hostBlockSize);
+
+  // 実時間と同じ間隔でコールバックを呼ぶ
+  const auto period = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::duration<double>(hostBlockSize / sampleRate));
+  auto next = std::chrono::steady_clock::now();
+  for (size_t b = 0; b < numBlocks; ++b) {
+    const size_t pos = (b * hostBlockSize) % (numSamples - hostBlockSize);
+    reverb.process(input.data() + pos, output.data(), hostBlockSize);
+    next += period;
+    std::this_thread::sleep_until(next);
+  }
+  EXPECT_EQ(reverb.getStats().tailBlocks, numBlocks * 2);
+  EXPECT_EQ(reverb.getStats().lateTailBlocks, 0u);
+}
+
+TEST_F(HybridReverbTest, DryOnlyWhenWetIsZero) {
+  const std::vector<float> input = makeNoise();
+  HybridReverb reverb(sampleRate);
+  reverb.setWetLevel(0.0f);
+  reverb.reset();
+  const std::vector<float> output = render(reverb, input);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(output[i], input[i]) << "at sample " << i;
+  }
+}
+
+// process() はメモリを確保しない (ワーカーも含めて)
+TEST_F(HybridReverbTest, ProcessDoesNotAllocate) {
+  const std::vector<float> input = makeNoise();
+  HybridReverb reverb(sampleRate);
+  reverb.setDecay(1.0f);
+  std::vector<float> output(numSamples);
+
+  size_t allocations = 0;
+  {
+    alloc_counter::Scope scope;
+    for (size_t pos = 0; pos < numSamples; pos += 64) {
+      const size_t n = std::min<size_t>(64, numSamples - pos);
+      reverb.process(input.data() + pos, output.data() + pos, n);
+    }
+    allocations = scope.allocations();
+  }
+  EXPECT_EQ(allocations, 0u);
+  EXPECT_TRUE(std::all_of(output.begin(), output.end(),
+                          [](float x) { return std::isfinite(x); }));
+}
@@ -0,0 +1,123 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "MappedWav.h"
+#include "MultichannelReverb.h"
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+class MappedWavTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t channels = 2;
+  const size_t numFrames = 5003;
+
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    dir = std::filesystem::temp_directory_path() /
+          (std::string("mapped_wav_test_") + info->name());
+    std::filesystem::create_directories(dir);
+  }
+  void TearDown() override { std::filesystem::remove_all(dir); }
+
+  std::string path(const std::string& name) { return (dir / name).string(); }
+
+  std::vector<float> makeNoise() {
+    return reverb_harness::makeNoise(numFrames * channels, 11);
+  }
+
+  std::filesystem::path dir;
+};
+
+TEST_F(MappedWavTest, WriterOutputCanBeReadBack) {
+  const std::vector<float> signal = makeNoise();
+  {
+    MappedWavWriter writer;
+    ASSERT_TRUE(writer.create(path("a.wav"), channels, sampleRate, numFrames));
+    std::memcpy(writer.data(), signal.data(), signal.size() * sizeof(float));
+    ASSERT_TRUE(writer.close());
+  }
+  MappedWavReader reader;
+  ASSERT_TRUE(reader.open(path("a.wav")));
+  EXPECT_EQ(reader.getChannels(), channels);
+  EXPECT_EQ(reader.getSampleRate(), sampleRate);
+  ASSERT_EQ(reader.getNumFrames(), numFrames);
+  for (size_t i = 0; i < signal.size(); ++i) {
+    ASSERT_EQ(signal[i], reader.data()[i]) << "at index " << i;
+  }
+}
+
+// マップした入力から直接処理した結果が、メモリ上で処理した結果と一致する
+TEST_F(MappedWavTest, RenderMappedMatchesInMemoryProcessing) {
+  const std::vector<float> signal = makeNoise();
+  {
+    MappedWavWriter writer;
+    ASSERT_TRUE(
+        writer.create(path("in.wav"), channels, sampleRate, numFrames));
+    std::memcpy(writer.data(), signal.data(), signal.size() * sizeof(float));
+    ASSERT_TRUE(writer.close());
+  }
+
+  StreamRenderOptions options;
+  options.blockFrames = 300;
+  options.tailFrames = 777;
+  options.decay = 0.8f;
+
+  std::vector<float> expected = signal;
+  expected.resize((numFrames + options.tailFrames) * channels, 0.0f);
+  MultichannelReverb reverb(sampleRate, channels);
+  reverb.setDecay(options.decay);
+  reverb.reset();
+  reverb.processInterleaved(expected.data(), expected.data(),
+                            numFrames + options.tailFrames);
+
+  MappedWavReader input;
+  ASSERT_TRUE(input.open(path("in.wav")));
+  const StreamRenderResult result =
+      renderMapped(input, path("out.wav"), options);
+  ASSERT_TRUE(result.ok);
+  EXPECT_EQ(result.framesRead, numFrames);
+  EXPECT_EQ(result.framesWritten, numFrames + options.tailFrames);
+
+  MappedWavReader output;
+  ASSERT_TRUE(output.open(path("out.wav")));
+  ASSERT_EQ(output.getNumFrames(), numFrames + options.tailFrames);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_FLOAT_EQ(expected[i], output.data()[i]) << "at index " << i;
+  }
+}
+
+// 16bit PCM はマップせず、バッファ経由の処理に任せる
+TEST_F(MappedWavTest, RejectsIntegerPcm) {
+  std::vector<uint8_t> header(44, 0);
+  auto put32 = [&](size_t pos, uint32_t v) {
+    std::memcpy(&header[pos], &v, 4);
+  };
+  auto put16 = [&](size_t pos, uint16_t v) {
+    std::memcpy(&header[pos], &v, 2);
+  };
+  std::memcpy(&header[0], "RIFF", 4);
+  put32(4, 36 + 4);
+  std::memcpy(&header[8], "WAVE", 4);
+  std::memcpy(&header[12], "fmt ", 4);
+  put32(16, 16);
+  put16(20, 1);  // PCM
+  put16(22, 1);
+  put32(24, 44100);
+  put32(28, 44100 * 2);
+  put16(32, 2);
+  put16(34, 16);
+  std::memcpy(&header[36], "data", 4);
+  put32(40, 4);
+  header.resize(48, 0);
+  std::ofstream(path("pcm16.wav"), std::ios::binary)
+      .write(reinterpret_cast<const char*>(header.data()), header.size());
+
+  MappedWavReader reader;
+  EXPECT_FALSE(reader.open(path("pcm16.wav")));
+  EXPECT_FALSE(reader.open(path("missing.wav")));
+}
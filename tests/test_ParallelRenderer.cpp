@@ -0,0 +1,109 @@
+#include <memory>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "ParallelRenderer.h"
+#include "Reverb.h"
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+// スレッド数を変えても、各インスタンスを直列に処理した場合と同じ出力になる
+class ParallelRendererTest : public ::testing::TestWithParam<size_t> {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numInstances = 37;  // スレッド数で割り切れない数
+  const size_t blockSize = 64;
+  const size_t numBlocks = 20;
+
+  void SetUp() override {
+    for (size_t i = 0; i < numInstances; ++i) {
+      serial.push_back(std::make_unique<Reverb>(sampleRate));
+      parallel.push_back(std::make_unique<Reverb>(sampleRate));
+      // インスタンスごとに異なるパラメータ
+      const float decay = static_cast<float>(i) / numInstances;
+      serial.back()->setDecay(decay);
+      parallel.back()->setDecay(decay);
+      inputs.push_back(reverb_harness::makeNoise(
+          blockSize * numBlocks, 99 + static_cast<unsigned>(i)));
+    }
+  }
+
+  std::vector<std::unique_ptr<Reverb>> serial;
+  std::vector<std::unique_ptr<Reverb>> parallel;
+  std::vector<std::vector<float>> inputs;
+};
+
+TEST_P(ParallelRendererTest, MatchesSerialProcessing) {
+  ParallelRenderer renderer(GetParam(), sampleRate);
+  std::vector<std::vector<float>> expected(
+      numInstances, std::vector<float>(blockSize * numBlocks));
+  std::vector<std::vector<float>> actual = expected;
+
+  std::vector<Reverb*> instances;
+  for (auto& reverb : parallel) instances.push_back(reverb.get());
+  std::vector<const float*> in(numInstances);
+  std::vector<float*> out(numInstances);
+
+  for (size_t block = 0; block < numBlocks; ++block) {
+    const size_t offset = block * blockSize;
+    for (size_t i = 0; i < numInstances; ++i) {
+      serial[i]->process(inputs[i].data() + offset,
+                         expected[i].data() + offset, blockSize);
+      in[i] = inputs[i].data() + offset;
+      out[i] = actual[i].data() + offset;
+    }
+    renderer.render(instances.data(), in.data(), out.data(), numInstances,
+                    blockSize);
+  }
+
+  for (size_t i = 0; i < numInstances; ++i) {
+    for (size_t n = 0; n < expected[i].size(); ++n) {
+      ASSERT_EQ(expected[i][n], actual[i][n])
+          << "instance " << i << ", sample " << n;
+    }
+  }
+  EXPECT_EQ(renderer.getStats().blocks, numBlocks);
+}
+
+TEST_P(ParallelRendererTest, NoAllocationWhileRendering) {
+  ParallelRenderer renderer(GetParam(), sampleRate);
+  std::vector<Reverb*> instances;
+  for (auto& reverb : parallel) instances.push_back(reverb.get());
+  std::vector<std::vector<float>> outputs(numInstances,
+                                          std::vector<float>(blockSize));
+  std::vector<const float*> in(numInstances, inputs[0].data());
+  std::vector<float*> out;
+  for (auto& output : outputs) out.push_back(output.data());
+  // 1ブロック目でスレッドの起動が済んでから数える
+  renderer.render(instances.data(), in.data(), out.data(), numInstances,
+                  blockSize);
+
+  alloc_counter::Scope scope;
+  for (size_t block = 0; block < numBlocks; ++block) {
+    renderer.render(instances.data(), in.data(), out.data(), numInstances,
+                    blockSize);
+  }
+  EXPECT_EQ(scope.allocations(), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Threads, ParallelRendererTest,
+                         ::testing::Values(1, 2, 4, 8));
+
+// ブロックの実時間を超えた処理は締め切り超過として数える
+TEST(ParallelRendererStatsTest, CountsDeadlineMisses) {
+  // 1サンプル = 1e-9 秒になるサンプルレートでは必ず間に合わない
+  ParallelRenderer renderer(2, 1e9f);
+  Reverb reverb(48000.0f);
+  Reverb* instances[] = {&reverb};
+  std::vector<float> buffer(256, 0.5f);
+  const float* in[] = {buffer.data()};
+  float* out[] = {buffer.data()};
+  for (int block = 0; block < 3; ++block) {
+    renderer.render(instances, in, out, 1, buffer.size());
+  }
+  EXPECT_EQ(renderer.getStats().blocks, 3u);
+  EXPECT_EQ(renderer.getStats().deadlineMisses, 3u);
+
+  renderer.resetStats();
+  EXPECT_EQ(renderer.getStats().deadlineMisses, 0u);
+}
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "AllpassFilter.h"
+#include "CombFilter.h"
+#include "Reverb.h"
+#include "ReverbHarness.h"
+#include "ReverbTuning.h"
+#include "gtest/gtest.h"
+
+// 処理時間の予算 (ns/sample)。超えたら性能の後退として失敗させる。
+//
+// 最適化したビルド (Release / RelWithDebInfo / MinSizeRel) でだけ測り、
+// それ以外は skip する。予算は開発機 (x86-64, 1 vCPU) の実測の約4倍で、
+// 遅い CI では環境変数 REVERB_PERF_BUDGET_SCALE (例: 2.0) で広げる。
+// ノイズを避けるため、1秒分の処理を数回測って最も速い回を使う。
+using namespace reverb_harness;
+
+namespace {
+
+constexpr float kSampleRate = 48000.0f;
+constexpr size_t kBlockSize = 256;
+constexpr int kRepetitions = 5;
+
+#if defined(REVERB_PERF_OPTIMIZED)
+double budgetScale() {
+  const char* scale = std::getenv("REVERB_PERF_BUDGET_SCALE");
+  return scale != nullptr ? std::atof(scale) : 1.0;
+}
+#endif
+
+// stage で1秒分のノイズを kBlockSize ずつ処理する時間を測り、予算と比べる
+template <typename Stage>
+void expectWithinBudget(Stage& stage, double budgetNsPerSample) {
+#if !defined(REVERB_PERF_OPTIMIZED)
+  (void)stage;
+  (void)budgetNsPerSample;
+  GTEST_SKIP() << "最適化していないビルドでは測らない";
+#else
+  const auto numSamples = static_cast<size_t>(kSampleRate);
+  const std::vector<float> input =
+      makeSignal(Signal::Noise, kSampleRate, numSamples);
+  std::vector<float> output(numSamples);
+  // ノイズは 0.25 秒で終わるので、毎回ノイズの区間だけを繰り返し処理する
+  const auto noiseSamples = static_cast<size_t>(kSampleRate * 0.25f);
+  const double nsPerSample = measureNsPerSample(
+      [&](size_t n) {
+        for (size_t done = 0; done < n;) {
+          const size_t offset = done % noiseSamples;
+          const size_t count =
+              std::min({kBlockSize, n - done, noiseSamples - offset});
+          stage.process(input.data() + offset, output.data() + offset, count);
+          done += count;
+        }
+      },
+      numSamples, kRepetitions);
+  const double budget = budgetNsPerSample * budgetScale();
+  ::testing::Test::RecordProperty("ns_per_sample",
+                                  std::to_string(nsPerSample));
+  EXPECT_LE(nsPerSample, budget) << "予算 " << budget << " ns/sample";
+#endif
+}
+
+}  // namespace
+
+TEST(PerfBudgetTest, Reverb) {
+  Reverb reverb(kSampleRate);
+  expectWithinBudget(reverb, 50.0);
+}
+
+TEST(PerfBudgetTest, ReverbModulated) {
+  Reverb reverb(kSampleRate);
+  reverb.setModulation(1.0f);
+  reverb.reset();
+  expectWithinBudget(reverb, 100.0);
+}
+
+TEST(PerfBudgetTest, CombFilter) {
+  CombFilter comb(kSampleRate, reverb_tuning::kCombDelayTimes[0], 0.84f, 0.4f);
+  expectWithinBudget(comb, 20.0);
+}
+
+TEST(PerfBudgetTest, AllpassFilter) {
+  AllpassFilter allpass(kSampleRate, reverb_tuning::kAllpassDelayTimes[0],
+                        reverb_tuning::kAllpassGain,
+                        reverb_tuning::maxAllpassDelaySamples(kSampleRate));
+  expectWithinBudget(allpass, 5.0);
+}
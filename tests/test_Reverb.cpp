@@ -0,0 +1,346 @@
+#include "Reverb.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+class ReverbTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 8000;
+
+  std::vector<float> makeNoise() {
+    return reverb_harness::makeNoise(numSamples, 99);
+  }
+};
+
+// wet の変更はランプで追従し、出力が飛ばない (ジッパーノイズが出ない)
+TEST_F(ReverbTest, WetLevelChangeIsSmooth) {
+  const std::vector<float> input(numSamples, 1.0f);
+  Reverb reverb(sampleRate);
+  Reverb fullyWet(sampleRate);  // 比較用: 最初から wet 1.0
+  reverb.setWetLevel(0.0f);
+  reverb.reset();
+  fullyWet.setWetLevel(1.0f);
+  fullyWet.reset();
+
+  std::vector<float> output(numSamples), expected(numSamples);
+  const size_t half = numSamples / 2;
+  reverb.process(input.data(), output.data(), half);
+  fullyWet.process(input.data(), expected.data(), half);
+  for (size_t i = 0; i < half; ++i) {
+    ASSERT_EQ(output[i], 1.0f) << "dry only at sample " << i;
+  }
+
+  reverb.setWetLevel(1.0f);
+  reverb.process(input.data() + half, output.data() + half, half);
+  fullyWet.process(input.data() + half, expected.data() + half, half);
+  // 切り替え直後はほぼ dry のまま
+  EXPECT_NEAR(output[half], 1.0f, 0.01f);
+  // ランプが終わると最初から wet 1.0 の出力と一致する
+  const size_t rampEnd = half + reverb_tuning::smoothingSamples(sampleRate);
+  for (size_t i = rampEnd; i < numSamples; ++i) {
+    ASSERT_EQ(output[i], expected[i]) << "at sample " << i;
+  }
+}
+
+// decay / damping / modulation のランプは、呼び出し側のブロック長によらず
+// 同じ出力になる
+TEST_F(ReverbTest, ParameterRampIndependentOfBlockSize) {
+  const std::vector<float> input = makeNoise();
+  Reverb wholeBlocks(sampleRate);
+  Reverb singleSamples(sampleRate);
+
+  std::vector<float> expected(numSamples), actual(numSamples);
+  const size_t half = numSamples / 2;
+  wholeBlocks.process(input.data(), expected.data(), half);
+  wholeBlocks.setDecay(0.95f);
+  wholeBlocks.setDamping(0.1f);
+  wholeBlocks.setWetLevel(0.8f);
+  wholeBlocks.setModulation(1.0f);
+  wholeBlocks.process(input.data() + half, expected.data() + half, half);
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    if (i == half) {
+      singleSamples.setDecay(0.95f);
+      singleSamples.setDamping(0.1f);
+      singleSamples.setWetLevel(0.8f);
+      singleSamples.setModulation(1.0f);
+    }
+    actual[i] = singleSamples.process(input[i]);
+  }
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+}
+
+// decay と damping を別々のブロックで変えても、ランプが終わった後は
+// 最初からその値で reset() した Reverb と同じ出力になる
+// (最後の値まで反映し、変えていないパラメータもそのまま)
+TEST_F(ReverbTest, SettledRampsMatchReset) {
+  const size_t rampLength =
+      static_cast<size_t>(reverb_tuning::smoothingSamples(sampleRate));
+  const std::vector<float> silence(rampLength + 100, 0.0f);
+  std::vector<float> scratch(silence.size());
+  Reverb automated(sampleRate);
+  automated.setDecay(0.9f);
+  for (size_t i = 0; i < silence.size(); i += 64) {
+    const size_t n = std::min<size_t>(64, silence.size() - i);
+    automated.process(&silence[i], &scratch[i], n);
+  }
+  automated.setDamping(0.1f);
+  automated.process(silence.data(), scratch.data(), silence.size());
+  EXPECT_TRUE(automated.isSilent());
+
+  Reverb fresh(sampleRate);
+  fresh.setDecay(0.9f);
+  fresh.setDamping(0.1f);
+  fresh.reset();
+  const std::vector<float> input = makeNoise();
+  std::vector<float> expected(numSamples), actual(numSamples);
+  fresh.process(input.data(), expected.data(), numSamples);
+  automated.process(input.data(), actual.data(), numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+}
+
+// 変調すると残響の細部は変わるが、エネルギーはほぼ同じ
+// (線形補間は高域を少し削るので、補間の影響が小さい低い音で比べる)
+TEST_F(ReverbTest, ModulationAltersTailButKeepsEnergy) {
+  std::vector<float> input(numSamples, 0.0f);
+  for (size_t i = 0; i < 1000; ++i) {
+    input[i] = std::sin(6.2831853f * 440.0f * i / sampleRate);
+  }
+  Reverb plain(sampleRate);
+  Reverb modulated(sampleRate);
+  plain.setWetLevel(1.0f);
+  plain.setDecay(0.9f);
+  plain.reset();
+  modulated.setWetLevel(1.0f);
+  modulated.setDecay(0.9f);
+  modulated.setModulation(1.0f);
+  modulated.reset();
+
+  std::vector<float> a(numSamples), b(numSamples);
+  plain.process(input.data(), a.data(), numSamples);
+  modulated.process(input.data(), b.data(), numSamples);
+
+  double energyA = 0.0, energyB = 0.0, diff = 0.0;
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_TRUE(std::isfinite(b[i]));
+    energyA += a[i] * a[i];
+    energyB += b[i] * b[i];
+    diff += (a[i] - b[i]) * (a[i] - b[i]);
+  }
+  EXPECT_GT(diff, 1e-3 * energyA);
+  EXPECT_NEAR(energyB / energyA, 1.0, 0.1);
+}
+
+// 別スレッドからパラメータを変え続けても、音声スレッドはロックも
+// メモリ確保もせずに処理を続けられる (ThreadSanitizer でも検査する)
+TEST_F(ReverbTest, ConcurrentParameterChanges) {
+  const std::vector<float> input = makeNoise();
+  std::vector<float> output(numSamples);
+  Reverb reverb(sampleRate);
+
+  std::atomic<bool> done{false};
+  std::thread control([&] {
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> distrib(0.0f, 1.0f);
+    while (!done.load(std::memory_order_relaxed)) {
+      reverb.setWetLevel(distrib(gen));
+      reverb.setDecay(distrib(gen));
+      reverb.setDamping(distrib(gen));
+      reverb.setModulation(distrib(gen));
+    }
+  });
+
+  size_t allocations = 0;
+  bool finite = true;
+  {
+    alloc_counter::Scope scope;
+    for (int round = 0; round < 50; ++round) {
+      for (size_t pos = 0; pos < numSamples; pos += 128) {
+        const size_t n = std::min<size_t>(128, numSamples - pos);
+        reverb.process(input.data() + pos, output.data() + pos, n);
+      }
+      finite = finite && std::all_of(output.begin(), output.end(),
+                                     [](float x) { return std::isfinite(x); });
+    }
+    allocations = scope.allocations();
+  }
+  done = true;
+  control.join();
+
+  EXPECT_TRUE(finite);
+  EXPECT_EQ(allocations, 0u);
+}
+
+// 残響が鳴り終わるとコム・オールパスを止めて0を出し、次の入力からは
+// reset() 直後の Reverb と全く同じ出力で再開する
+TEST_F(ReverbTest, SilentTailIsBypassedAndResumesLikeReset) {
+  Reverb reverb(sampleRate);
+  reverb.setWetLevel(1.0f);
+  reverb.setModulation(1.0f);
+  reverb.reset();
+  EXPECT_TRUE(reverb.isSilent());
+
+  const size_t tailLength = static_cast<size_t>(sampleRate) * 4;
+  std::vector<float> tail(tailLength, 0.0f), output(tailLength);
+  tail[0] = 1.0f;
+  reverb.process(tail.data(), output.data(), 1);
+  EXPECT_FALSE(reverb.isSilent());
+  size_t silentAt = 0;
+  for (size_t pos = 1; pos < tailLength; pos += 256) {
+    const size_t n = std::min<size_t>(256, tailLength - pos);
+    reverb.process(tail.data() + pos, output.data() + pos, n);
+    if (silentAt == 0 && reverb.isSilent()) {
+      silentAt = pos + n;
+    }
+  }
+  ASSERT_GT(silentAt, 0u);
+  for (size_t i = silentAt; i < tailLength; ++i) {
+    ASSERT_EQ(output[i], 0.0f) << "at sample " << i;
+  }
+
+  const std::vector<float> input = makeNoise();
+  Reverb fresh(sampleRate);
+  fresh.setWetLevel(1.0f);
+  fresh.setModulation(1.0f);
+  fresh.reset();
+  std::vector<float> expected(numSamples), actual(numSamples);
+  fresh.process(input.data(), expected.data(), numSamples);
+  reverb.process(input.data(), actual.data(), numSamples);
+  EXPECT_FALSE(reverb.isSilent());
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+}
+
+// 止める位置と再開する位置は、呼び出し側のブロック長によらない
+TEST_F(ReverbTest, SilenceDetectionIndependentOfBlockSize) {
+  const size_t length = static_cast<size_t>(sampleRate) * 4;
+  std::vector<float> input(length, 0.0f);
+  input[0] = 1.0f;
+  input[length / 2 + 17] = -0.5f;
+  // しきい値未満の入力は無音として扱う
+  input[length / 2 + 5] = 1e-6f;
+
+  Reverb wholeBlocks(sampleRate);
+  Reverb singleSamples(sampleRate);
+  for (Reverb* reverb : {&wholeBlocks, &singleSamples}) {
+    reverb->setDecay(0.0f);
+    reverb->reset();
+  }
+  std::vector<float> expected(length), actual(length);
+  wholeBlocks.process(input.data(), expected.data(), length);
+  for (size_t i = 0; i < length; ++i) {
+    actual[i] = singleSamples.process(input[i]);
+    if (i == length / 2) {
+      EXPECT_TRUE(singleSamples.isSilent());
+    }
+  }
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+}
+
+// prepare した後は、setSampleRate でそのレートで構築したものと同じ出力になる
+TEST_F(ReverbTest, SetSampleRateMatchesConstruction) {
+  const std::vector<float> input = makeNoise();
+  Reverb switched(sampleRate);
+  switched.prepare(192000.0f, 512);
+  switched.setWetLevel(0.8f);
+  switched.setModulation(1.0f);
+
+  for (const float rate : {44100.0f, 96000.0f, 192000.0f, 48000.0f}) {
+    switched.setSampleRate(rate);
+    EXPECT_EQ(switched.getSampleRate(), rate);
+    Reverb fresh(rate);
+    fresh.setWetLevel(0.8f);
+    fresh.setModulation(1.0f);
+    fresh.reset();
+
+    std::vector<float> expected(numSamples), actual(numSamples);
+    fresh.process(input.data(), expected.data(), numSamples);
+    switched.process(input.data(), actual.data(), numSamples);
+    for (size_t i = 0; i < numSamples; ++i) {
+      ASSERT_EQ(actual[i], expected[i]) << "rate " << rate << " at " << i;
+    }
+  }
+}
+
+// レートの切り替えはメモリを確保しない。最大のレートを超える値は丸める
+TEST_F(ReverbTest, SetSampleRateDoesNotAllocate) {
+  const std::vector<float> input = makeNoise();
+  std::vector<float> output(numSamples);
+  Reverb reverb(44100.0f);
+  reverb.prepare(192000.0f, 256);
+  EXPECT_EQ(reverb.getMaxSampleRate(), 192000.0f);
+
+  size_t allocations = 0;
+  {
+    alloc_counter::Scope scope;
+    for (const float rate : {48000.0f, 192000.0f, 44100.0f, 96000.0f}) {
+      reverb.setSampleRate(rate);
+      reverb.process(input.data(), output.data(), numSamples);
+    }
+    reverb.setSampleRate(384000.0f);
+    allocations = scope.allocations();
+  }
+  EXPECT_EQ(allocations, 0u);
+  EXPECT_EQ(reverb.getSampleRate(), 192000.0f);
+  EXPECT_TRUE(std::all_of(output.begin(), output.end(),
+                          [](float x) { return std::isfinite(x); }));
+}
+
+// 計測 (REVERB_ENABLE_PROFILING) が有効なら段ごとの時間と負荷を数え、
+// 無効なら何も数えない (プロファイラは空のクラス)
+TEST_F(ReverbTest, StatsReportStagesOnlyWhenEnabled) {
+  static_assert(Reverb::kStatsEnabled || std::is_empty_v<Reverb::Profiler>);
+  const std::vector<float> input = makeNoise();
+  std::vector<float> output(numSamples);
+  Reverb reverb(sampleRate);
+  const size_t blockSize = 500;
+  for (size_t i = 0; i < numSamples; i += blockSize) {
+    reverb.process(input.data() + i, output.data() + i, blockSize);
+  }
+
+  Reverb::Stats stats = reverb.getStats();
+  if (!Reverb::kStatsEnabled) {
+    EXPECT_EQ(stats.blocks, 0u);
+    EXPECT_EQ(stats.totalNsPerSample, 0.0);
+    return;
+  }
+  EXPECT_EQ(stats.blocks, numSamples / blockSize);
+  EXPECT_EQ(stats.samples, numSamples);
+  double stageSum = 0.0;
+  for (const double ns : stats.stageNsPerSample) {
+    EXPECT_GT(ns, 0.0);
+    stageSum += ns;
+  }
+  // 段の合計は全体を超えない (換算の誤差を少し許す)
+  EXPECT_LE(stageSum, stats.totalNsPerSample * 1.05);
+  EXPECT_GT(stats.cpuLoadPercent, 0.0);
+  EXPECT_GE(stats.maxBlockNs, stats.totalNsPerSample * blockSize);
+  EXPECT_GE(stats.maxLoadPercent + 0.01, stats.cpuLoadPercent);
+  uint64_t histogramBlocks = 0;
+  for (const uint64_t count : stats.loadHistogram) {
+    histogramBlocks += count;
+  }
+  EXPECT_EQ(histogramBlocks, stats.blocks);
+
+  reverb.resetStats();
+  stats = reverb.getStats();
+  EXPECT_EQ(stats.blocks, 0u);
+  EXPECT_EQ(stats.maxBlockNs, 0.0);
+}
@@ -0,0 +1,107 @@
+#include <vector>
+
+#include "AllocCounter.h"
+#include "Reverb.h"
+#include "ReverbHarness.h"
+#include "ReverbPool.h"
+#include "gtest/gtest.h"
+
+class ReverbPoolTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 3000;
+
+  std::vector<float> makeNoise() {
+    return reverb_harness::makeNoise(numSamples, 7);
+  }
+};
+
+// アリーナはインスタンス数 x 1インスタンス分ぴったりで、全て使い切る
+TEST_F(ReverbPoolTest, ArenaIsSizedExactly) {
+  ReverbPool pool(sampleRate, 10);
+  EXPECT_EQ(pool.getArena().getCapacity(),
+            10 * Reverb::requiredArenaSize(sampleRate));
+  EXPECT_EQ(pool.getArena().getUsed(), pool.getArena().getCapacity());
+}
+
+// プールのインスタンスは単体の Reverb と同じ出力になる
+TEST_F(ReverbPoolTest, InstanceMatchesStandaloneReverb) {
+  const std::vector<float> input = makeNoise();
+  std::vector<float> expected(numSamples);
+  Reverb reverb(sampleRate);
+  reverb.setDecay(0.9f);
+  reverb.process(input.data(), expected.data(), numSamples);
+
+  ReverbPool pool(sampleRate, 3);
+  const ReverbPool::Handle a = pool.acquire();
+  const ReverbPool::Handle b = pool.acquire();
+  pool.get(b).setDecay(0.9f);
+
+  std::vector<float> outA(numSamples), outB(numSamples);
+  const float* inputs[3] = {input.data(), input.data(), nullptr};
+  float* outputs[3] = {nullptr, nullptr, nullptr};
+  outputs[a] = outA.data();
+  outputs[b] = outB.data();
+  pool.processActive(inputs, outputs, numSamples);
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_FLOAT_EQ(expected[i], outB[i]) << "at sample " << i;
+  }
+}
+
+TEST_F(ReverbPoolTest, AcquireUntilExhausted) {
+  ReverbPool pool(sampleRate, 2);
+  const ReverbPool::Handle a = pool.acquire();
+  const ReverbPool::Handle b = pool.acquire();
+  EXPECT_NE(a, b);
+  EXPECT_EQ(pool.acquire(), ReverbPool::kInvalidHandle);
+  EXPECT_EQ(pool.getNumActive(), 2u);
+
+  pool.release(a);
+  pool.release(a);  // 二重解放は無視する
+  EXPECT_EQ(pool.getNumActive(), 1u);
+  EXPECT_FALSE(pool.isActive(a));
+  EXPECT_EQ(pool.acquire(), a);
+}
+
+// 再取得したインスタンスは前の残響もパラメータも残っていない
+TEST_F(ReverbPoolTest, ReacquiredInstanceStartsFresh) {
+  const std::vector<float> input = makeNoise();
+  ReverbPool pool(sampleRate, 1);
+  ReverbPool::Handle h = pool.acquire();
+  std::vector<float> first(numSamples), second(numSamples);
+  pool.get(h).process(input.data(), first.data(), numSamples);
+
+  pool.get(h).setDecay(1.0f);
+  pool.get(h).setModulation(1.0f);
+  pool.get(h).process(input.data(), second.data(), numSamples);
+  pool.release(h);
+  h = pool.acquire();
+  pool.get(h).process(input.data(), second.data(), numSamples);
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_FLOAT_EQ(first[i], second[i]) << "at sample " << i;
+  }
+}
+
+TEST_F(ReverbPoolTest, NoAllocationAfterConstruction) {
+  const std::vector<float> input = makeNoise();
+  std::vector<float> output(numSamples);
+  ReverbPool pool(sampleRate, 4);
+  const float* inputs[4];
+  float* outputs[4];
+  for (size_t i = 0; i < 4; ++i) {
+    inputs[i] = input.data();
+    outputs[i] = output.data();
+  }
+
+  alloc_counter::Scope scope;
+  for (int round = 0; round < 10; ++round) {
+    const ReverbPool::Handle a = pool.acquire();
+    const ReverbPool::Handle b = pool.acquire();
+    pool.processActive(inputs, outputs, numSamples);
+    pool.release(a);
+    pool.release(b);
+  }
+  EXPECT_EQ(scope.allocations(), 0u);
+}
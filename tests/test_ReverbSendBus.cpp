@@ -0,0 +1,157 @@
+#include "ReverbSendBus.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "AllocCounter.h"
+#include "Reverb.h"
+#include "ReverbHarness.h"
+#include "gtest/gtest.h"
+
+class ReverbSendBusTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 9600;
+  const size_t blockSize = 300;  // 内部のチャンク (256) をまたぐ長さ
+
+  std::vector<float> makeNoise(unsigned seed) {
+    return reverb_harness::makeNoise(numSamples, seed);
+  }
+
+  // 比較用: wet だけを出す単独の Reverb
+  std::vector<float> renderReverb(const std::vector<float>& input) {
+    Reverb reverb(sampleRate);
+    reverb.setWetLevel(1.0f);
+    reverb.reset();
+    return reverb_harness::render(reverb, input, blockSize);
+  }
+
+  // bus を blockSize ごとに処理し、各バスの出力を返す
+  std::vector<std::vector<float>> renderBus(
+      ReverbSendBus& bus, const std::vector<std::vector<float>>& sources) {
+    std::vector<std::vector<float>> outputs(
+        bus.getNumBuses(), std::vector<float>(numSamples));
+    std::vector<const float*> inputs(bus.getMaxSources(), nullptr);
+    std::vector<float*> outs(bus.getNumBuses());
+    for (size_t i = 0; i < numSamples; i += blockSize) {
+      const size_t n = std::min(blockSize, numSamples - i);
+      for (size_t s = 0; s < sources.size(); ++s) {
+        inputs[s] = &sources[s][i];
+      }
+      for (size_t b = 0; b < outs.size(); ++b) {
+        outs[b] = &outputs[b][i];
+      }
+      bus.process(inputs.data(), outs.data(), n);
+    }
+    return outputs;
+  }
+};
+
+// 線形なので、センドの総和を1つの Reverb に通したのと同じになる
+TEST_F(ReverbSendBusTest, MatchesReverbOfSummedSends) {
+  const size_t numSources = 7;  // 4ソースずつのカーネルと端数の両方を通す
+  std::vector<std::vector<float>> sources;
+  std::vector<float> gains;
+  ReverbSendBus bus(sampleRate, 1, numSources);
+  for (size_t s = 0; s < numSources; ++s) {
+    sources.push_back(makeNoise(static_cast<unsigned>(s)));
+    gains.push_back(0.1f * static_cast<float>(s + 1));
+    EXPECT_EQ(bus.addSource(0, gains.back()), s);
+  }
+  EXPECT_EQ(bus.getNumSources(), numSources);
+
+  std::vector<float> sum(numSamples, 0.0f);
+  for (size_t s = 0; s < numSources; ++s) {
+    for (size_t i = 0; i < numSamples; ++i) {
+      sum[i] += gains[s] * sources[s][i];
+    }
+  }
+  const std::vector<float> expected = renderReverb(sum);
+  const std::vector<float> actual = renderBus(bus, sources)[0];
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-5f) << "sample " << i;
+  }
+}
+
+// プリディレイはソースごと。遅らせた入力を Reverb に通したのと同じになる
+TEST_F(ReverbSendBusTest, PreDelayIsPerSource) {
+  const std::vector<float> direct = makeNoise(10);
+  const std::vector<float> delayedSource = makeNoise(11);
+  const float preDelay = 0.0123f;
+  const auto preDelaySamples = static_cast<size_t>(sampleRate * preDelay);
+
+  ReverbSendBus bus(sampleRate, 1, 2, 0.05f);
+  bus.addSource(0, 0.5f);
+  bus.addSource(0, 0.8f, preDelay);
+
+  std::vector<float> sum(numSamples, 0.0f);
+  for (size_t i = 0; i < numSamples; ++i) {
+    sum[i] = 0.5f * direct[i];
+    if (i >= preDelaySamples) {
+      sum[i] += 0.8f * delayedSource[i - preDelaySamples];
+    }
+  }
+  const std::vector<float> expected = renderReverb(sum);
+  const std::vector<float> actual = renderBus(bus, {direct, delayedSource})[0];
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-5f) << "sample " << i;
+  }
+}
+
+// バスごとに別の Reverb。外したソースは送られない
+TEST_F(ReverbSendBusTest, BusesAreIndependentAndSourcesCanBeRemoved) {
+  const std::vector<float> a = makeNoise(20);
+  const std::vector<float> b = makeNoise(21);
+  const std::vector<float> c = makeNoise(22);
+  ReverbSendBus bus(sampleRate, 2, 3);
+  bus.addSource(0, 1.0f);
+  const ReverbSendBus::SourceId removed = bus.addSource(0, 1.0f);
+  bus.addSource(1, 1.0f);
+  bus.removeSource(removed);
+  EXPECT_EQ(bus.getNumSources(), 2u);
+
+  const auto outputs = renderBus(bus, {a, b, c});
+  const std::vector<float> expected0 = renderReverb(a);
+  const std::vector<float> expected1 = renderReverb(c);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_NEAR(outputs[0][i], expected0[i], 1e-6f) << "sample " << i;
+    ASSERT_NEAR(outputs[1][i], expected1[i], 1e-6f) << "sample " << i;
+  }
+}
+
+// 枠を使い切ったら kInvalidSource。外した枠は再利用する
+TEST_F(ReverbSendBusTest, SourceSlotsAreRecycled) {
+  ReverbSendBus bus(sampleRate, 1, 2);
+  const auto first = bus.addSource(0, 1.0f);
+  bus.addSource(0, 1.0f);
+  EXPECT_EQ(bus.addSource(0, 1.0f), ReverbSendBus::kInvalidSource);
+  EXPECT_EQ(bus.addSource(5, 1.0f), ReverbSendBus::kInvalidSource);
+  bus.removeSource(first);
+  bus.removeSource(first);  // 2回目は何もしない
+  EXPECT_EQ(bus.addSource(0, 1.0f), first);
+}
+
+// ソースの出し入れと処理はメモリを確保しない
+TEST_F(ReverbSendBusTest, DoesNotAllocate) {
+  const std::vector<float> input = makeNoise(30);
+  const size_t maxSources = 64;
+  ReverbSendBus bus(sampleRate, 2, maxSources, 0.02f);
+  std::vector<const float*> inputs(maxSources, input.data());
+  std::vector<float> out0(blockSize), out1(blockSize);
+  float* outputs[] = {out0.data(), out1.data()};
+
+  size_t allocations = 0;
+  {
+    alloc_counter::Scope scope;
+    for (size_t s = 0; s < maxSources; ++s) {
+      bus.addSource(s % 2, 0.1f, 0.001f * static_cast<float>(s % 5));
+    }
+    bus.process(inputs.data(), outputs, blockSize);
+    for (ReverbSendBus::SourceId s = 0; s < maxSources; s += 3) {
+      bus.removeSource(s);
+    }
+    bus.process(inputs.data(), outputs, blockSize);
+    allocations = scope.allocations();
+  }
+  EXPECT_EQ(allocations, 0u);
+}
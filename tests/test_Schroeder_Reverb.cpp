@@ -0,0 +1,175 @@
+#include <cmath>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "AllpassFilter.h"
+#include "CombFilter.h"
+#include "Reverb.h"
+#include "ReverbHarness.h"
+#include "ReverbTuning.h"
+#include "gtest/gtest.h"
+
+// Schroeder リバーブ (Reverb と、その部品の CombFilter / AllpassFilter) の
+// ゴールデン出力との比較。最適化などで出力が変わっていないことを確かめる。
+//
+// ゴールデンファイルは tests/golden/<ケース名>.txt。意図して出力を変えたときは
+//   REVERB_UPDATE_GOLDEN=1 ./run_tests --gtest_filter='GoldenOutput*'
+// で作り直し、差分を確認してからコミットする。
+using namespace reverb_harness;
+
+namespace {
+
+constexpr float kSampleRate = 48000.0f;
+constexpr size_t kBlockSize = 256;
+
+// 許容誤差。FMA の有無や SIMD の並びで変わる程度の差は許す
+constexpr float kSampleTolerance = 1e-4f;  // 先頭のサンプル (振幅)
+constexpr float kEdcToleranceDb = 0.5f;    // 減衰曲線
+constexpr float kEdcCompareFloorDb = -60.0f;
+constexpr double kRt60Tolerance = 0.02;  // 相対
+
+enum class Stage { Reverb, Comb, Allpass };
+
+struct GoldenCase {
+  const char* name;
+  Stage stage;
+  Signal signal;
+  float seconds;
+  float wet;
+  float decay;
+  float damping;
+  float modulation;
+};
+
+const GoldenCase kGoldenCases[] = {
+    {"reverb_impulse", Stage::Reverb, Signal::Impulse, 2.5f, 1.0f, 0.5f, 0.4f,
+     0.0f},
+    {"reverb_impulse_dark_short", Stage::Reverb, Signal::Impulse, 1.5f, 1.0f,
+     0.2f, 0.8f, 0.0f},
+    {"reverb_impulse_long_modulated", Stage::Reverb, Signal::Impulse, 6.0f,
+     1.0f, 0.9f, 0.2f, 1.0f},
+    {"reverb_sine_burst", Stage::Reverb, Signal::SineBurst, 2.5f, 0.5f, 0.5f,
+     0.4f, 0.0f},
+    {"reverb_noise", Stage::Reverb, Signal::Noise, 3.0f, 0.3f, 0.7f, 0.4f,
+     0.5f},
+    {"comb_impulse", Stage::Comb, Signal::Impulse, 2.0f, 1.0f, 0.5f, 0.4f,
+     0.0f},
+    {"comb_impulse_bright", Stage::Comb, Signal::Impulse, 4.0f, 1.0f, 0.9f,
+     0.0f, 0.0f},
+    {"allpass_impulse", Stage::Allpass, Signal::Impulse, 1.0f, 1.0f, 0.0f,
+     0.0f, 0.0f},
+    {"allpass_impulse_modulated", Stage::Allpass, Signal::Impulse, 1.0f, 1.0f,
+     0.0f, 0.0f, 1.0f},
+};
+
+// 失敗したときにケース名を表示する
+void PrintTo(const GoldenCase& c, std::ostream* os) { *os << c.name; }
+
+std::vector<float> renderCase(const GoldenCase& c, size_t blockSize) {
+  using namespace reverb_tuning;
+  const std::vector<float> input = makeSignal(
+      c.signal, kSampleRate, static_cast<size_t>(c.seconds * kSampleRate));
+  switch (c.stage) {
+    case Stage::Reverb: {
+      Reverb reverb(kSampleRate);
+      reverb.setWetLevel(c.wet);
+      reverb.setDecay(c.decay);
+      reverb.setDamping(c.damping);
+      reverb.setModulation(c.modulation);
+      reverb.reset();
+      return render(reverb, input, blockSize);
+    }
+    case Stage::Comb: {
+      // Reverb の1本目のコムと同じ設定
+      CombFilter comb(kSampleRate, kCombDelayTimes[0], combGain(c.decay, 0),
+                      c.damping);
+      return render(comb, input, blockSize);
+    }
+    case Stage::Allpass: {
+      AllpassFilter allpass(kSampleRate, kAllpassDelayTimes[0], kAllpassGain,
+                            maxAllpassDelaySamples(kSampleRate));
+      allpass.setModulation(c.modulation * kMaxModulationTime * kSampleRate,
+                            kAllpassModulationRates[0]);
+      return render(allpass, input, blockSize);
+    }
+  }
+  return {};
+}
+
+std::string describe(const GoldenCase& c) {
+  const char* stages[] = {"Reverb", "CombFilter", "AllpassFilter"};
+  const char* signals[] = {"impulse", "sine burst", "noise burst"};
+  return std::string(stages[static_cast<int>(c.stage)]) + ", " +
+         signals[static_cast<int>(c.signal)] + ", " +
+         std::to_string(kSampleRate) + " Hz, wet " + std::to_string(c.wet) +
+         ", decay " + std::to_string(c.decay) + ", damping " +
+         std::to_string(c.damping) + ", modulation " +
+         std::to_string(c.modulation);
+}
+
+}  // namespace
+
+class GoldenOutputTest : public ::testing::TestWithParam<GoldenCase> {};
+
+TEST_P(GoldenOutputTest, MatchesGolden) {
+  const GoldenCase& c = GetParam();
+  const Golden actual = analyze(renderCase(c, kBlockSize), kSampleRate);
+  const std::string path =
+      std::string(REVERB_GOLDEN_DIR) + "/" + c.name + ".txt";
+
+  if (std::getenv("REVERB_UPDATE_GOLDEN") != nullptr) {
+    ASSERT_TRUE(writeGolden(path, actual, describe(c))) << path;
+    GTEST_SKIP() << "wrote " << path;
+  }
+
+  Golden expected;
+  ASSERT_TRUE(readGolden(path, expected))
+      << path << " がない。REVERB_UPDATE_GOLDEN=1 で作る";
+  ASSERT_EQ(actual.head.size(), expected.head.size());
+  for (size_t i = 0; i < expected.head.size(); ++i) {
+    ASSERT_NEAR(actual.head[i], expected.head[i], kSampleTolerance)
+        << "sample " << i;
+  }
+  ASSERT_EQ(actual.edcDb.size(), expected.edcDb.size());
+  for (size_t i = 0; i < expected.edcDb.size(); ++i) {
+    if (expected.edcDb[i] < kEdcCompareFloorDb) {
+      break;
+    }
+    ASSERT_NEAR(actual.edcDb[i], expected.edcDb[i], kEdcToleranceDb)
+        << "EDC at " << static_cast<float>(i) * kEdcStep << " s";
+  }
+  ASSERT_GT(expected.rt60, 0.0);
+  EXPECT_NEAR(actual.rt60, expected.rt60, expected.rt60 * kRt60Tolerance);
+}
+
+// ゴールデンは kBlockSize で作るが、呼び出し側のブロック長によらない
+TEST_P(GoldenOutputTest, IndependentOfBlockSize) {
+  const GoldenCase& c = GetParam();
+  const std::vector<float> expected = renderCase(c, kBlockSize);
+  const std::vector<float> actual = renderCase(c, 61);
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-6f) << "sample " << i;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    SchroederReverb, GoldenOutputTest, ::testing::ValuesIn(kGoldenCases),
+    [](const ::testing::TestParamInfo<GoldenCase>& info) {
+      return std::string(info.param.name);
+    });
+
+// 指標そのものの確認: ダンピングのないコムの残響時間は
+// RT60 = -3 D / log10(g) (D: 遅延 [秒], g: フィードバックゲイン)
+TEST(ReverbHarnessTest, CombDecayTimeMatchesTheory) {
+  const float delay = 0.0297f;
+  const float gain = 0.9f;
+  CombFilter comb(kSampleRate, delay, gain, 0.0f);
+  const std::vector<float> response = render(
+      comb, makeSignal(Signal::Impulse, kSampleRate, 4 * 48000), kBlockSize);
+  const double expected = -3.0 * delay / std::log10(gain);
+  EXPECT_NEAR(decayTime(energyDecayCurveDb(response), kSampleRate), expected,
+              expected * 0.05);
+}
@@ -0,0 +1,85 @@
+#include "SmoothedParameter.h"
+
+#include "gtest/gtest.h"
+
+// 目標値を変えると rampLength サンプルかけて線形に近づく
+TEST(SmoothedParameterTest, RampsLinearlyToTarget) {
+  SmoothedParameter param(0.0f, 10);
+  param.setTarget(1.0f);
+  EXPECT_EQ(param.getCurrent(), 0.0f);  // 取り込むまでは変わらない
+
+  EXPECT_TRUE(param.pollTarget());
+  for (int i = 1; i < 10; ++i) {
+    EXPECT_NEAR(param.advance(1), i / 10.0f, 1e-6f) << "at sample " << i;
+    EXPECT_TRUE(param.isRamping());
+  }
+  EXPECT_EQ(param.advance(1), 1.0f);  // 最後はちょうど目標値
+  EXPECT_FALSE(param.isRamping());
+  EXPECT_EQ(param.advance(100), 1.0f);
+}
+
+// ブロック長の分け方によらず同じ値になる
+TEST(SmoothedParameterTest, IndependentOfBlockSplit) {
+  SmoothedParameter a(0.3f, 1000);
+  SmoothedParameter b(0.3f, 1000);
+  a.setTarget(0.9f);
+  b.setTarget(0.9f);
+  a.pollTarget();
+  b.pollTarget();
+
+  float valueA = 0.0f;
+  for (int i = 0; i < 777; ++i) {
+    valueA = a.advance(1);
+  }
+  b.advance(500);
+  const float valueB = b.advance(277);
+  EXPECT_EQ(valueA, valueB);
+  EXPECT_EQ(a.getSteppedValue(32), b.getSteppedValue(32));
+}
+
+// ランプの途中で目標値が変わると、その時点の値から新しいランプを始める
+TEST(SmoothedParameterTest, RetargetStartsFromCurrentValue) {
+  SmoothedParameter param(0.0f, 100);
+  param.setTarget(1.0f);
+  param.pollTarget();
+  const float middle = param.advance(50);
+  EXPECT_NEAR(middle, 0.5f, 1e-6f);
+
+  param.setTarget(0.0f);
+  param.pollTarget();
+  EXPECT_EQ(param.getCurrent(), middle);
+  EXPECT_NEAR(param.advance(50), 0.25f, 1e-6f);
+  EXPECT_EQ(param.advance(50), 0.0f);
+}
+
+// 階段状の値は stepSize の倍数の位置でだけ変わる
+TEST(SmoothedParameterTest, SteppedValueChangesAtStepBoundaries) {
+  SmoothedParameter param(0.0f, 100);
+  param.setTarget(1.0f);
+  param.pollTarget();
+  EXPECT_EQ(param.getSteppedValue(32), 0.0f);
+  EXPECT_EQ(param.samplesUntilNextStep(32), 32u);
+
+  param.advance(20);
+  EXPECT_EQ(param.getSteppedValue(32), 0.0f);
+  EXPECT_EQ(param.samplesUntilNextStep(32), 12u);
+
+  param.advance(12);
+  EXPECT_NEAR(param.getSteppedValue(32), 0.32f, 1e-6f);
+
+  // 最後の段はランプの終わりまで
+  param.advance(64);
+  EXPECT_EQ(param.samplesUntilNextStep(32), 4u);
+  param.advance(4);
+  EXPECT_EQ(param.getSteppedValue(32), 1.0f);
+  EXPECT_EQ(param.samplesUntilNextStep(32), SIZE_MAX);
+}
+
+// snap はランプせずに目標値へ飛ぶ
+TEST(SmoothedParameterTest, SnapJumpsToTarget) {
+  SmoothedParameter param(0.0f, 100);
+  param.setTarget(0.7f);
+  param.snap();
+  EXPECT_EQ(param.getCurrent(), 0.7f);
+  EXPECT_FALSE(param.pollTarget());
+}
@@ -0,0 +1,175 @@
+#include "ReverbHarness.h"
+#include "StaticReverb.h"
+
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Reverb.h"
+#include "SampleStorage.h"
+#include "gtest/gtest.h"
+
+class StaticReverbTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 48000.0f;
+  const size_t numSamples = 8000;
+
+  std::vector<float> makeNoise() {
+    return reverb_harness::makeNoise(numSamples, 7);
+  }
+};
+
+// 遅延サンプル数は Reverb (CombBank / AllpassFilter) と同じ求め方
+TEST_F(StaticReverbTest, DelaysMatchTuning) {
+  auto reverb = std::make_unique<StaticSchroederReverb<48000>>(sampleRate);
+  for (size_t i = 0; i < reverb_tuning::kNumCombs; ++i) {
+    EXPECT_EQ(reverb->getCombDelaySamples(i),
+              reverb_tuning::delaySamples(
+                  sampleRate, reverb_tuning::kCombDelayTimes[i]));
+  }
+  for (size_t i = 0; i < reverb_tuning::kNumAllpasses; ++i) {
+    EXPECT_EQ(reverb->getAllpassDelaySamples(i),
+              static_cast<int>(std::round(
+                  sampleRate * reverb_tuning::kAllpassDelayTimes[i])));
+  }
+}
+
+// パラメータのランプも含めて、動的な Reverb と同じ出力になる
+// (コムの総和の順序が SIMD 版と違うので、丸め誤差の分だけ許容する)
+TEST_F(StaticReverbTest, MatchesDynamicReverb) {
+  const std::vector<float> input = makeNoise();
+  Reverb reference(sampleRate);
+  auto reverb = std::make_unique<StaticSchroederReverb<48000>>(sampleRate);
+
+  std::vector<float> expected(numSamples), actual(numSamples);
+  const size_t half = numSamples / 2;
+  reference.process(input.data(), expected.data(), half);
+  reverb->process(input.data(), actual.data(), half);
+  reference.setDecay(0.9f);
+  reference.setDamping(0.2f);
+  reference.setWetLevel(0.8f);
+  reverb->setDecay(0.9f);
+  reverb->setDamping(0.2f);
+  reverb->setWetLevel(0.8f);
+  reference.process(input.data() + half, expected.data() + half, half);
+  reverb->process(input.data() + half, actual.data() + half, half);
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_NEAR(actual[i], expected[i], 1e-4f) << "at sample " << i;
+  }
+}
+
+// 呼び出し側のブロック長によらず同じ出力になる
+TEST_F(StaticReverbTest, IndependentOfBlockSize) {
+  const std::vector<float> input = makeNoise();
+  auto wholeBlocks = std::make_unique<StaticSchroederReverb<48000>>(sampleRate);
+  auto singleSamples =
+      std::make_unique<StaticSchroederReverb<48000>>(sampleRate);
+
+  std::vector<float> expected(numSamples), actual(numSamples);
+  wholeBlocks->setDecay(0.95f);
+  wholeBlocks->process(input.data(), expected.data(), numSamples);
+  singleSamples->setDecay(0.95f);
+  for (size_t i = 0; i < numSamples; ++i) {
+    actual[i] = singleSamples->process(input[i]);
+  }
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_EQ(actual[i], expected[i]) << "at sample " << i;
+  }
+}
+
+// double で計算しても float 版とほぼ同じ出力になる
+TEST_F(StaticReverbTest, DoublePrecisionCloseToFloat) {
+  const std::vector<float> input = makeNoise();
+  auto single = std::make_unique<StaticSchroederReverb<48000>>(sampleRate);
+  auto precise =
+      std::make_unique<StaticSchroederReverb<48000, double>>(sampleRate);
+
+  std::vector<float> a(numSamples), b(numSamples);
+  single->process(input.data(), a.data(), numSamples);
+  precise->process(input.data(), b.data(), numSamples);
+  for (size_t i = 0; i < numSamples; ++i) {
+    ASSERT_NEAR(a[i], b[i], 1e-4f) << "at sample " << i;
+  }
+}
+
+// 独自のトポロジー (8コム + 4オールパス) でもインパルス応答が減衰する
+TEST_F(StaticReverbTest, CustomTopologyDecays) {
+  constexpr StaticTopology<8, 4> kTopology = {
+      {0.0253f, 0.0269f, 0.0290f, 0.0307f, 0.0322f, 0.0338f, 0.0353f,
+       0.0367f},
+      {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f},
+      {0.0051f, 0.0126f, 0.0100f, 0.0077f},
+      0.5f,
+      0.125f,
+      48000.0f};
+  auto reverb =
+      std::make_unique<StaticReverb<8, 4, float, kTopology>>(sampleRate);
+  reverb->setWetLevel(1.0f);
+  reverb->reset();
+
+  const size_t length = 48000;
+  std::vector<float> input(length, 0.0f), output(length);
+  input[0] = 1.0f;
+  reverb->process(input.data(), output.data(), length);
+
+  double early = 0.0, late = 0.0;
+  for (size_t i = 0; i < length; ++i) {
+    ASSERT_TRUE(std::isfinite(output[i]));
+    (i < length / 2 ? early : late) += output[i] * output[i];
+  }
+  EXPECT_GT(early, 0.0);
+  EXPECT_LT(late, early * 0.1);
+}
+
+// Q15 / Q31 の遅延バッファと double の演算を、float 版に対する SNR で比べる
+TEST_F(StaticReverbTest, StorageVariantsCloseToFloat) {
+  const std::vector<float> input = makeNoise();
+  auto reference = std::make_unique<StaticSchroederReverb<48000>>(sampleRate);
+  std::vector<float> expected(numSamples);
+  reference->process(input.data(), expected.data(), numSamples);
+
+  // 信号と誤差のエネルギー比 (dB)
+  auto snr = [&](auto& reverb) {
+    std::vector<float> actual(numSamples);
+    reverb->process(input.data(), actual.data(), numSamples);
+    double signal = 0.0, noise = 0.0;
+    for (size_t i = 0; i < numSamples; ++i) {
+      signal += expected[i] * expected[i];
+      noise += (actual[i] - expected[i]) * (actual[i] - expected[i]);
+    }
+    return 10.0 * std::log10(signal / noise);
+  };
+
+  using Q15Reverb = StaticSchroederReverb<48000, float, int16_t>;
+  using Q31Reverb = StaticSchroederReverb<48000, double, int32_t>;
+  using DoubleReverb = StaticSchroederReverb<48000, double, float>;
+  auto q15 = std::make_unique<Q15Reverb>(sampleRate);
+  auto q31 = std::make_unique<Q31Reverb>(sampleRate);
+  auto doubleMath = std::make_unique<DoubleReverb>(sampleRate);
+  // Q15 は分解能 1/2^11 (約 73 dB)、他は float 版の丸め誤差 (約 140 dB)
+  EXPECT_GT(snr(q15), 60.0);
+  EXPECT_GT(snr(q31), 120.0);
+  EXPECT_GT(snr(doubleMath), 120.0);
+
+  // Q15 の遅延バッファは float の半分
+  EXPECT_EQ(Q15Reverb::delayBufferBytes() * 2,
+            StaticSchroederReverb<48000>::delayBufferBytes());
+}
+
+// 固定小数点は ±kHeadroom で飽和し、折り返さない
+TEST(SampleStorageTest, FixedPointRoundsAndSaturates) {
+  using Q15 = SampleStorage<int16_t>;
+  EXPECT_EQ(Q15::store(0.0f), 0);
+  EXPECT_EQ(Q15::store(1.0f), 2048);
+  EXPECT_EQ(Q15::store(-1.0f), -2048);
+  EXPECT_EQ(Q15::load<float>(Q15::store(0.25f)), 0.25f);
+  EXPECT_EQ(Q15::store(100.0f), INT16_MAX);
+  EXPECT_EQ(Q15::store(-100.0f), INT16_MIN);
+
+  using Q31 = SampleStorage<int32_t>;
+  EXPECT_EQ(Q31::store(1.0), 1 << 27);
+  EXPECT_EQ(Q31::store(1e9), INT32_MAX);
+  EXPECT_NEAR(Q31::load<double>(Q31::store(0.123456789)), 0.123456789, 1e-8);
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <vector>
+
+#include "MultichannelReverb.h"
+#include "ReverbHarness.h"
+#include "StreamRenderer.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+// メモリ上のインターリーブ信号を少しずつ返す。
+// failAfterFrames を渡すと、そこで読み込みに失敗する
+class MemorySource : public StreamSource {
+ public:
+  explicit MemorySource(const std::vector<float>& samples, size_t channels,
+                        size_t failAfterFrames = SIZE_MAX)
+      : samples_(samples),
+        channels_(channels),
+        failAfterFrames_(failAfterFrames) {}
+
+  size_t read(float* interleaved, size_t maxFrames) override {
+    maxRequest = std::max(maxRequest, maxFrames);
+    const size_t end = std::min(samples_.size() / channels_, failAfterFrames_);
+    const size_t frames = std::min(maxFrames, end - position_);
+    std::copy_n(samples_.begin() + position_ * channels_, frames * channels_,
+                interleaved);
+    position_ += frames;
+    return frames;
+  }
+
+  bool failed() const override { return position_ == failAfterFrames_; }
+
+  size_t maxRequest = 0;
+
+ private:
+  const std::vector<float>& samples_;
+  size_t channels_;
+  size_t failAfterFrames_;
+  size_t position_ = 0;
+};
+
+class MemorySink : public StreamSink {
+ public:
+  explicit MemorySink(size_t channels, size_t failAfterFrames = SIZE_MAX)
+      : channels_(channels), failAfterFrames_(failAfterFrames) {}
+
+  bool write(const float* interleaved, size_t numFrames) override {
+    if (samples.size() / channels_ + numFrames > failAfterFrames_) {
+      return false;
+    }
+    samples.insert(samples.end(), interleaved,
+                   interleaved + numFrames * channels_);
+    return true;
+  }
+
+  std::vector<float> samples;
+
+ private:
+  size_t channels_;
+  size_t failAfterFrames_;
+};
+
+}  // namespace
+
+class StreamRendererTest : public ::testing::Test {
+ protected:
+  const float sampleRate = 44100.0f;
+  const size_t channels = 2;
+  const size_t numFrames = 10007;  // ブロック長で割り切れない長さ
+
+  std::vector<float> makeNoise() {
+    return reverb_harness::makeNoise(numFrames * channels, 3);
+  }
+};
+
+// パイプラインで流しても、全体を一度に処理した結果と同じになる
+TEST_F(StreamRendererTest, MatchesWholeBufferProcessing) {
+  const std::vector<float> input = makeNoise();
+  StreamRenderOptions options;
+  options.blockFrames = 512;
+  options.numBlocks = 3;
+  options.tailFrames = 1000;
+  options.decay = 0.7f;
+
+  std::vector<float> expected = input;
+  expected.resize((numFrames + options.tailFrames) * channels, 0.0f);
+  MultichannelReverb reverb(sampleRate, channels);
+  reverb.setDecay(options.decay);
+  reverb.reset();
+  reverb.processInterleaved(expected.data(), expected.data(),
+                            numFrames + options.tailFrames);
+
+  MemorySource source(input, channels);
+  MemorySink sink(channels);
+  const StreamRenderResult result =
+      renderStream(source, sink, channels, sampleRate, options);
+
+  EXPECT_TRUE(result.ok);
+  EXPECT_EQ(result.framesRead, numFrames);
+  EXPECT_EQ(result.framesWritten, numFrames + options.tailFrames);
+  // 入力はブロック長ずつしか読まない
+  EXPECT_EQ(source.maxRequest, options.blockFrames);
+  ASSERT_EQ(sink.samples.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_FLOAT_EQ(expected[i], sink.samples[i]) << "at index " << i;
+  }
+}
+
+// 書き込みに失敗したら途中で止まり、失敗を返す
+TEST_F(StreamRendererTest, StopsOnWriteFailure) {
+  const std::vector<float> input = makeNoise();
+  StreamRenderOptions options;
+  options.blockFrames = 256;
+
+  MemorySource source(input, channels);
+  MemorySink sink(channels, 1000);
+  const StreamRenderResult result =
+      renderStream(source, sink, channels, sampleRate, options);
+
+  EXPECT_FALSE(result.ok);
+  EXPECT_EQ(result.framesWritten, 768u);  // 256 x 3 ブロック
+}
+
+// 読み込みに失敗したら、読めた分だけを (余韻を足さずに) 書いて失敗を返す
+TEST_F(StreamRendererTest, StopsOnReadFailure) {
+  const std::vector<float> input = makeNoise();
+  StreamRenderOptions options;
+  options.blockFrames = 256;
+  options.tailFrames = 1000;
+
+  MemorySource source(input, channels, numFrames / 2);
+  MemorySink sink(channels);
+  const StreamRenderResult result =
+      renderStream(source, sink, channels, sampleRate, options);
+
+  EXPECT_FALSE(result.ok);
+  EXPECT_EQ(result.framesRead, numFrames / 2);
+  EXPECT_EQ(result.framesWritten, numFrames / 2);
+  EXPECT_EQ(sink.samples.size(), numFrames / 2 * channels);
+}
@@ -0,0 +1,88 @@
+#include "WavStream.h"
+
+#define DR_WAV_IMPLEMENTATION
+#include "dr_wav.h"
+
+struct WavFileSource::Impl {
+  drwav wav;
+  bool opened = false;
+  uint64_t framesRead = 0;
+  bool failed = false;
+};
+
+WavFileSource::WavFileSource() : impl_(std::make_unique<Impl>()) {}
+
+WavFileSource::~WavFileSource() {
+  if (impl_->opened) {
+    drwav_uninit(&impl_->wav);
+  }
+}
+
+bool WavFileSource::open(const std::string& path) {
+  impl_->opened = drwav_init_file(&impl_->wav, path.c_str(), NULL);
+  return impl_->opened;
+}
+
+size_t WavFileSource::read(float* interleaved, size_t maxFrames) {
+  if (!impl_->opened) {
+    impl_->failed = true;
+    return 0;
+  }
+  const auto frames = static_cast<size_t>(
+      drwav_read_pcm_frames_f32(&impl_->wav, maxFrames, interleaved));
+  impl_->framesRead += frames;
+  if (frames < maxFrames &&
+      impl_->framesRead < impl_->wav.totalPCMFrameCount) {
+    impl_->failed = true;
+  }
+  return frames;
+}
+
+bool WavFileSource::failed() const { return impl_->failed; }
+
+size_t WavFileSource::getChannels() const { return impl_->wav.channels; }
+
+float WavFileSource::getSampleRate() const {
+  return static_cast<float>(impl_->wav.sampleRate);
+}
+
+uint64_t WavFileSource::getTotalFrames() const {
+  return impl_->wav.totalPCMFrameCount;
+}
+
+struct WavFileSink::Impl {
+  drwav wav;
+  bool opened = false;
+};
+
+WavFileSink::WavFileSink() : impl_(std::make_unique<Impl>()) {}
+
+WavFileSink::~WavFileSink() { close(); }
+
+bool WavFileSink::open(const std::string& path, size_t channels,
+                       float sampleRate) {
+  drwav_data_format format;
+  format.container = drwav_container_riff;
+  format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+  format.channels = static_cast<drwav_uint32>(channels);
+  format.sampleRate = static_cast<drwav_uint32>(sampleRate);
+  format.bitsPerSample = 32;
+  impl_->opened =
+      drwav_init_file_write(&impl_->wav, path.c_str(), &format, NULL);
+  return impl_->opened;
+}
+
+bool WavFileSink::write(const float* interleaved, size_t numFrames) {
+  if (!impl_->opened) {
+    return false;
+  }
+  return drwav_write_pcm_frames(&impl_->wav, numFrames, interleaved) ==
+         numFrames;
+}
+
+void WavFileSink::close() {
+  if (impl_->opened) {
+    drwav_uninit(&impl_->wav);
+    impl_->opened = false;
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "StreamRenderer.h"
+
+// dr_wav で WAV ファイルをブロック単位で読み書きする StreamSource / StreamSink
+// (ファイル全体をメモリに載せない)
+
+class WavFileSource : public StreamSource {
+ public:
+  WavFileSource();
+  ~WavFileSource() override;
+
+  bool open(const std::string& path);
+  size_t read(float* interleaved, size_t maxFrames) override;
+  // ヘッダのフレーム数より前で読めなくなったら true
+  bool failed() const override;
+
+  size_t getChannels() const;
+  float getSampleRate() const;
+  uint64_t getTotalFrames() const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+// 32bit float の WAV として書き出す
+class WavFileSink : public StreamSink {
+ public:
+  WavFileSink();
+  ~WavFileSink() override;
+
+  bool open(const std::string& path, size_t channels, float sampleRate);
+  bool write(const float* interleaved, size_t numFrames) override;
+  // ヘッダを確定してファイルを閉じる (デストラクタでも閉じる)
+  void close();
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
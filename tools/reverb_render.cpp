@@ -0,0 +1,278 @@
+// reverb_render: WAV ファイルにリバーブをかけて書き出す
+//
+// 使い方:
+//   reverb_render [options] input.wav [input2.wav ...]
+//
+// 入力はブロック単位で読み込み -> 処理 -> 書き出しを別スレッドで流すので、
+// 数時間のファイルでもメモリ使用量は一定。複数ファイルは --jobs 個ずつ並列に
+// 処理する。
+// 32bit float の WAV はメモリマップして、マップした入力から直接マップした
+// 出力へ書く (中間バッファなし)。それ以外の形式は dr_wav で読み書きする。
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MappedWav.h"
+#include "MultichannelReverb.h"
+#include "StreamRenderer.h"
+#include "WavStream.h"
+
+namespace {
+
+struct Options {
+  std::vector<std::string> inputs;
+  std::string output;     // 入力が1つの場合だけ有効
+  std::string outputDir;  // 空なら入力と同じディレクトリ
+  std::string suffix = "_reverb";
+  float tailSeconds = 3.0f;
+  size_t jobs = 1;
+  bool useMmap = true;
+  StreamRenderOptions render;
+};
+
+void printUsage() {
+  std::cerr
+      << "usage: reverb_render [options] input.wav [input2.wav ...]\n"
+         "  -o <file>         output file (single input only)\n"
+         "  --out-dir <dir>   output directory (default: next to input)\n"
+         "  --suffix <str>    output name suffix (default: _reverb)\n"
+         "  --wet <0-1>       wet level (default: 0.5)\n"
+         "  --decay <0-1>     decay (default: 0.5)\n"
+         "  --damping <0-1>   damping (default: 0.4)\n"
+         "  --width <0-1>     stereo width (default: 1.0)\n"
+         "  --tail <seconds>  silence appended for the reverb tail "
+         "(default: 3)\n"
+         "  --block <frames>  frames per pipeline block (default: 4096)\n"
+         "  --jobs <n>        files rendered in parallel (default: 1)\n"
+         "  --no-mmap         always use buffered I/O\n";
+}
+
+// 値全体が有限の数として読めたときだけ true (例外は投げない)
+bool parseFloat(const std::string& text, float& value) {
+  if (text.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  value = std::strtof(text.c_str(), &end);
+  return end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+bool parseSize(const std::string& text, size_t& value) {
+  const char* last = text.data() + text.size();
+  const auto [end, error] = std::from_chars(text.data(), last, value);
+  return error == std::errc() && end == last;
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      return false;
+    }
+    if (arg == "--no-mmap") {
+      options.useMmap = false;
+      continue;
+    }
+    if (!arg.empty() && arg[0] == '-') {
+      if (i + 1 >= argc) {
+        std::cerr << "ERROR: missing value for " << arg << std::endl;
+        return false;
+      }
+      const std::string value = argv[++i];
+      bool valid = true;
+      if (arg == "-o") {
+        options.output = value;
+      } else if (arg == "--out-dir") {
+        options.outputDir = value;
+      } else if (arg == "--suffix") {
+        options.suffix = value;
+      } else if (arg == "--wet") {
+        valid = parseFloat(value, options.render.wetLevel);
+      } else if (arg == "--decay") {
+        valid = parseFloat(value, options.render.decay);
+      } else if (arg == "--damping") {
+        valid = parseFloat(value, options.render.damping);
+      } else if (arg == "--width") {
+        valid = parseFloat(value, options.render.width);
+      } else if (arg == "--tail") {
+        valid = parseFloat(value, options.tailSeconds);
+        options.tailSeconds = std::max(0.0f, options.tailSeconds);
+      } else if (arg == "--block") {
+        valid = parseSize(value, options.render.blockFrames);
+        options.render.blockFrames =
+            std::max<size_t>(1, options.render.blockFrames);
+      } else if (arg == "--jobs") {
+        valid = parseSize(value, options.jobs);
+        options.jobs = std::max<size_t>(1, options.jobs);
+      } else {
+        std::cerr << "ERROR: unknown option " << arg << std::endl;
+        return false;
+      }
+      if (!valid) {
+        std::cerr << "ERROR: invalid value for " << arg << std::endl;
+        return false;
+      }
+    } else {
+      options.inputs.push_back(arg);
+    }
+  }
+  if (options.inputs.empty()) {
+    return false;
+  }
+  if (!options.output.empty() && options.inputs.size() != 1) {
+    std::cerr << "ERROR: -o can only be used with a single input" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+std::string outputPathFor(const Options& options, const std::string& input) {
+  if (!options.output.empty()) {
+    return options.output;
+  }
+  const std::filesystem::path in(input);
+  const std::filesystem::path dir =
+      options.outputDir.empty() ? in.parent_path()
+                                : std::filesystem::path(options.outputDir);
+  return (dir / (in.stem().string() + options.suffix + ".wav")).string();
+}
+
+std::string describe(const std::string& input, const std::string& output,
+                     size_t channels, float sampleRate,
+                     const StreamRenderResult& result, double seconds,
+                     const char* method) {
+  const double audioSeconds = result.framesWritten / sampleRate;
+  return input + " -> " + output + " (" + std::to_string(channels) +
+         " ch, " + std::to_string(audioSeconds) + " s audio in " +
+         std::to_string(seconds) + " s, " +
+         std::to_string(audioSeconds / std::max(seconds, 1e-9)) +
+         "x realtime, " + method + ")";
+}
+
+enum class MappedStatus {
+  Unsupported,  // メモリマップできない形式。dr_wav で処理し直す
+  Rendered,
+  Failed,  // 書き出しに失敗した。同じ出力に書き直さずにエラーにする
+};
+
+// float32 の WAV をメモリマップで処理する
+MappedStatus renderFileMapped(const Options& options, const std::string& input,
+                              std::string& log) {
+  MappedWavReader source;
+  if (!source.open(input) ||
+      source.getChannels() > MultichannelReverb::kMaxChannels) {
+    return MappedStatus::Unsupported;
+  }
+  const std::string output = outputPathFor(options, input);
+  StreamRenderOptions render = options.render;
+  render.tailFrames =
+      static_cast<size_t>(options.tailSeconds * source.getSampleRate());
+
+  const auto start = std::chrono::steady_clock::now();
+  const StreamRenderResult result = renderMapped(source, output, render);
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  if (!result.ok) {
+    log = "ERROR: failed while writing " + output;
+    return MappedStatus::Failed;
+  }
+  log = describe(input, output, source.getChannels(), source.getSampleRate(),
+                 result, elapsed.count(), "mmap");
+  return MappedStatus::Rendered;
+}
+
+// 1ファイルを処理する。結果のメッセージは log にまとめて返す
+bool renderFile(const Options& options, const std::string& input,
+                std::string& log) {
+  if (options.useMmap) {
+    const MappedStatus status = renderFileMapped(options, input, log);
+    if (status != MappedStatus::Unsupported) {
+      return status == MappedStatus::Rendered;
+    }
+  }
+
+  WavFileSource source;
+  if (!source.open(input)) {
+    log = "ERROR: failed to open " + input;
+    return false;
+  }
+  const size_t channels = source.getChannels();
+  if (channels == 0 || channels > MultichannelReverb::kMaxChannels) {
+    log = "ERROR: unsupported channel count in " + input;
+    return false;
+  }
+
+  const std::string output = outputPathFor(options, input);
+  WavFileSink sink;
+  if (!sink.open(output, channels, source.getSampleRate())) {
+    log = "ERROR: failed to open " + output + " for writing";
+    return false;
+  }
+
+  StreamRenderOptions render = options.render;
+  render.tailFrames =
+      static_cast<size_t>(options.tailSeconds * source.getSampleRate());
+
+  const auto start = std::chrono::steady_clock::now();
+  const StreamRenderResult result =
+      renderStream(source, sink, channels, source.getSampleRate(), render);
+  sink.close();
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  if (!result.ok) {
+    log = source.failed() ? "ERROR: failed while reading " + input
+                          : "ERROR: failed while writing " + output;
+    return false;
+  }
+  log = describe(input, output, channels, source.getSampleRate(), result,
+                 elapsed.count(), "buffered");
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parseArgs(argc, argv, options)) {
+    printUsage();
+    return EXIT_FAILURE;
+  }
+
+  // ファイル単位で並列に処理する (各ファイルの中も読み込み/DSP/書き出しで
+  // パイプライン化されている)
+  std::atomic<size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::mutex logMutex;
+  auto worker = [&] {
+    for (size_t i = next++; i < options.inputs.size(); i = next++) {
+      std::string log;
+      const bool ok = renderFile(options, options.inputs[i], log);
+      if (!ok) {
+        failed = true;
+      }
+      std::lock_guard<std::mutex> lock(logMutex);
+      (ok ? std::cout : std::cerr) << log << std::endl;
+    }
+  };
+
+  const size_t numWorkers = std::min(options.jobs, options.inputs.size());
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < numWorkers; ++i) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : workers) {
+    thread.join();
+  }
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}